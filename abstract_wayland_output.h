@@ -139,6 +139,10 @@ public:
 
 Q_SIGNALS:
     void modeChanged();
+    /**
+     * Emitted when the compositor ran for this output but presented no new frame.
+     */
+    void frameSkipped();
 
 protected:
     void initInterfaces(std::string const& name, std::string const& make,
@@ -19,10 +19,26 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "mock_drm.h"
 
+#include <cerrno>
+
 #include <QMap>
 #include <QVector>
 
+struct MockPlane {
+    uint32_t possibleCrtcs;
+    QVector<uint32_t> formats;
+    QVector<uint32_t> properties;
+    QVector<uint64_t> values;
+};
+
+struct _drmModeAtomicReq {
+    MockDrm::AtomicRequest values;
+    int count = 0;
+};
+
 static QMap<int, QVector<_drmModeProperty>> s_drmProperties{};
+static QMap<int, QMap<uint32_t, MockPlane>> s_planes{};
+static QMap<int, std::function<bool(const MockDrm::AtomicRequest &, uint32_t)>> s_commitHandlers{};
 
 namespace MockDrm
 {
@@ -32,15 +48,92 @@ void addDrmModeProperties(int fd, const QVector<_drmModeProperty> &properties)
     s_drmProperties.insert(fd, properties);
 }
 
+void addPlane(int fd, uint32_t id, uint32_t possibleCrtcs, const QVector<uint32_t> &formats,
+              const QVector<uint32_t> &properties, const QVector<uint64_t> &values)
+{
+    s_planes[fd].insert(id, MockPlane{possibleCrtcs, formats, properties, values});
+}
+
+void setAtomicCommitHandler(int fd, std::function<bool(const AtomicRequest &, uint32_t flags)> handler)
+{
+    s_commitHandlers.insert(fd, handler);
+}
+
+}
+
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return new _drmModeAtomicReq;
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    delete req;
 }
 
 int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
 {
-    Q_UNUSED(req)
-    Q_UNUSED(object_id)
-    Q_UNUSED(property_id)
-    Q_UNUSED(value)
-    return 0;
+    req->values[object_id][property_id] = value;
+    return ++req->count;
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void *user_data)
+{
+    Q_UNUSED(user_data)
+    auto it = s_commitHandlers.constFind(fd);
+    if (it == s_commitHandlers.constEnd() || !*it || (*it)(req->values, flags)) {
+        return 0;
+    }
+    errno = EINVAL;
+    return -EINVAL;
+}
+
+drmModePlanePtr drmModeGetPlane(int fd, uint32_t plane_id)
+{
+    auto it = s_planes.constFind(fd);
+    if (it == s_planes.constEnd() || !it->contains(plane_id)) {
+        return nullptr;
+    }
+    const auto &mock = (*it)[plane_id];
+
+    auto *plane = new _drmModePlane{};
+    plane->plane_id = plane_id;
+    plane->possible_crtcs = mock.possibleCrtcs;
+    plane->count_formats = mock.formats.size();
+    plane->formats = new uint32_t[mock.formats.size()];
+    std::copy(mock.formats.cbegin(), mock.formats.cend(), plane->formats);
+    return plane;
+}
+
+void drmModeFreePlane(drmModePlanePtr ptr)
+{
+    delete[] ptr->formats;
+    delete ptr;
+}
+
+drmModeObjectPropertiesPtr drmModeObjectGetProperties(int fd, uint32_t object_id, uint32_t object_type)
+{
+    Q_UNUSED(object_type)
+    auto it = s_planes.constFind(fd);
+    if (it == s_planes.constEnd() || !it->contains(object_id)) {
+        return nullptr;
+    }
+    const auto &mock = (*it)[object_id];
+
+    auto *properties = new drmModeObjectProperties{};
+    properties->count_props = mock.properties.size();
+    properties->props = new uint32_t[mock.properties.size()];
+    properties->prop_values = new uint64_t[mock.values.size()];
+    std::copy(mock.properties.cbegin(), mock.properties.cend(), properties->props);
+    std::copy(mock.values.cbegin(), mock.values.cend(), properties->prop_values);
+    return properties;
+}
+
+void drmModeFreeObjectProperties(drmModeObjectPropertiesPtr ptr)
+{
+    delete[] ptr->props;
+    delete[] ptr->prop_values;
+    delete ptr;
 }
 
 drmModePropertyPtr drmModeGetProperty(int fd, uint32_t propertyId)
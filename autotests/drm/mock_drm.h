@@ -22,11 +22,31 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cstdint>
 #include <xf86drmMode.h>
 
+#include <QMap>
 #include <QVector>
 
+#include <functional>
+
 namespace MockDrm
 {
 
 void addDrmModeProperties(int fd, const QVector<_drmModeProperty> &properties);
 
+/**
+ * Adds a plane returned by drmModeGetPlane. Its properties are returned by
+ * drmModeObjectGetProperties and must be described with addDrmModeProperties.
+ */
+void addPlane(int fd, uint32_t id, uint32_t possibleCrtcs, const QVector<uint32_t> &formats,
+              const QVector<uint32_t> &properties, const QVector<uint64_t> &values);
+
+/**
+ * Property values of an atomic request by object and property id.
+ */
+using AtomicRequest = QMap<uint32_t, QMap<uint32_t, uint64_t>>;
+
+/**
+ * Decides whether drmModeAtomicCommit succeeds. Without a handler all commits succeed.
+ */
+void setAtomicCommitHandler(int fd, std::function<bool(const AtomicRequest &, uint32_t flags)> handler);
+
 }
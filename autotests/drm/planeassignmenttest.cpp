@@ -0,0 +1,272 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "mock_drm.h"
+#include "../../plugins/platforms/drm/drm_buffer.h"
+#include "../../plugins/platforms/drm/drm_object_plane.h"
+#include "../../plugins/platforms/drm/drm_plane_assignment.h"
+#include "../../plugins/platforms/drm/drm_pointer.h"
+
+#include <QtTest>
+
+#include <drm_fourcc.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace KWin;
+
+static const int s_fd = 30;
+static const uint32_t s_crtcId = 40;
+
+// Property ids of the mocked planes.
+static const uint32_t s_zposId = 1;
+static const uint32_t s_fbId = 10;
+static const uint32_t s_crtcIdId = 11;
+
+class MockBuffer : public DrmBuffer
+{
+public:
+    MockBuffer(uint32_t id)
+        : DrmBuffer(s_fd)
+    {
+        m_bufferId = id;
+    }
+};
+
+class PlaneAssignmentTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testAssignByZpos();
+    void testUnsupportedFormat();
+    void testRejectedPlane();
+    void testUnknownZpos();
+    void testDisable();
+
+private:
+    struct MockPlaneInfo {
+        uint32_t id;
+        int zpos;
+        QVector<uint32_t> formats;
+    };
+
+    QVector<DrmPlane*> createPlanes(const QVector<MockPlaneInfo> &infos);
+    QVector<DrmLayer> createLayers(int count, uint32_t format = DRM_FORMAT_XRGB8888);
+    bool testCommit(const QVector<DrmPlane*> &planes) const;
+
+    std::vector<std::unique_ptr<DrmPlane>> m_planes;
+    std::vector<std::unique_ptr<MockBuffer>> m_buffers;
+};
+
+static _drmModeProperty createProperty(uint32_t id, const char *name)
+{
+    _drmModeProperty property;
+    std::memset(&property, 0, sizeof(property));
+    property.prop_id = id;
+    std::strncpy(property.name, name, DRM_PROP_NAME_LEN - 1);
+    return property;
+}
+
+void PlaneAssignmentTest::initTestCase()
+{
+    MockDrm::addDrmModeProperties(s_fd, QVector<_drmModeProperty>{
+        createProperty(s_zposId, "zpos"),
+        createProperty(2, "SRC_X"),
+        createProperty(3, "SRC_Y"),
+        createProperty(4, "SRC_W"),
+        createProperty(5, "SRC_H"),
+        createProperty(6, "CRTC_X"),
+        createProperty(7, "CRTC_Y"),
+        createProperty(8, "CRTC_W"),
+        createProperty(9, "CRTC_H"),
+        createProperty(s_fbId, "FB_ID"),
+        createProperty(s_crtcIdId, "CRTC_ID")
+    });
+}
+
+void PlaneAssignmentTest::cleanup()
+{
+    // The planes delete their buffers otherwise.
+    for (auto &plane : m_planes) {
+        plane->setNext(nullptr);
+    }
+    m_planes.clear();
+    m_buffers.clear();
+    MockDrm::setAtomicCommitHandler(s_fd, nullptr);
+}
+
+QVector<DrmPlane*> PlaneAssignmentTest::createPlanes(const QVector<MockPlaneInfo> &infos)
+{
+    QVector<DrmPlane*> planes;
+    for (const auto &info : infos) {
+        QVector<uint32_t> properties{2, 3, 4, 5, 6, 7, 8, 9, s_fbId, s_crtcIdId};
+        QVector<uint64_t> values(properties.size(), 0);
+        if (info.zpos >= 0) {
+            properties << s_zposId;
+            values << info.zpos;
+        }
+        MockDrm::addPlane(s_fd, info.id, 1, info.formats, properties, values);
+
+        auto plane = new DrmPlane(info.id, s_fd);
+        if (!plane->atomicInit()) {
+            delete plane;
+            return {};
+        }
+        m_planes.emplace_back(plane);
+        planes << plane;
+    }
+    return planes;
+}
+
+QVector<DrmLayer> PlaneAssignmentTest::createLayers(int count, uint32_t format)
+{
+    QVector<DrmLayer> layers;
+    for (int i = 0; i < count; i++) {
+        m_buffers.emplace_back(new MockBuffer(200 + i));
+        layers << DrmLayer{m_buffers.back().get(), format, QRect(0, 0, 100, 100),
+                           QRect(10 * i, 10 * i, 100, 100)};
+    }
+    return layers;
+}
+
+bool PlaneAssignmentTest::testCommit(const QVector<DrmPlane*> &planes) const
+{
+    DrmScopedPointer<drmModeAtomicReq> req{drmModeAtomicAlloc()};
+    for (auto plane : planes) {
+        if (!plane->atomicPopulate(req.data())) {
+            return false;
+        }
+    }
+    return drmModeAtomicCommit(s_fd, req.data(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+void PlaneAssignmentTest::testAssignByZpos()
+{
+    // Planes are used from the highest zpos down, independent of their order.
+    auto planes = createPlanes({{100, 1, {DRM_FORMAT_XRGB8888}},
+                                {101, 3, {DRM_FORMAT_XRGB8888}},
+                                {102, 2, {DRM_FORMAT_XRGB8888}}});
+    QCOMPARE(planes.size(), 3);
+
+    DrmPlaneAssignment assignment(s_crtcId, planes);
+    QCOMPARE(assignment.planes(), (QVector<DrmPlane*>{planes[1], planes[2], planes[0]}));
+
+    int tests = 0;
+    MockDrm::setAtomicCommitHandler(s_fd, [&tests](const MockDrm::AtomicRequest &request,
+                                                   uint32_t flags) {
+        tests++;
+        return flags & DRM_MODE_ATOMIC_TEST_ONLY && request.size() == 3;
+    });
+
+    auto layers = createLayers(2);
+    QCOMPARE(assignment.assign(layers, [&] { return testCommit(planes); }), 2);
+    QCOMPARE(tests, 2);
+    QCOMPARE(assignment.assignedPlanes(), (QVector<DrmPlane*>{planes[1], planes[2]}));
+
+    QCOMPARE(planes[1]->next(), layers[0].buffer);
+    QCOMPARE(planes[2]->next(), layers[1].buffer);
+    QVERIFY(!planes[0]->next());
+
+    // The last test contained the complete assignment.
+    MockDrm::setAtomicCommitHandler(s_fd, [](const MockDrm::AtomicRequest &request, uint32_t) {
+        return request[101][s_fbId] == 200 && request[101][s_crtcIdId] == s_crtcId
+            && request[102][s_fbId] == 201 && request[102][s_crtcIdId] == s_crtcId
+            && request[100][s_fbId] == 0 && request[100][s_crtcIdId] == 0;
+    });
+    QVERIFY(testCommit(planes));
+}
+
+void PlaneAssignmentTest::testUnsupportedFormat()
+{
+    auto planes = createPlanes({{100, 2, {DRM_FORMAT_XRGB8888}},
+                                {101, 1, {DRM_FORMAT_NV12}}});
+    QCOMPARE(planes.size(), 2);
+    DrmPlaneAssignment assignment(s_crtcId, planes);
+
+    // The top layer can only be put on the lower plane.
+    auto layers = createLayers(1, DRM_FORMAT_NV12);
+    layers << createLayers(1, DRM_FORMAT_XRGB8888);
+    QCOMPARE(assignment.assign(layers, [&] { return testCommit(planes); }), 1);
+    QCOMPARE(assignment.assignedPlanes(), QVector<DrmPlane*>{planes[1]});
+
+    // The second layer must not be put above the first one.
+    QVERIFY(!planes[0]->next());
+    QCOMPARE(planes[1]->next(), layers[0].buffer);
+
+    // Nothing supports the format of the top layer. No layer can be assigned.
+    layers = createLayers(1, DRM_FORMAT_ARGB2101010);
+    layers << createLayers(1, DRM_FORMAT_XRGB8888);
+    QCOMPARE(assignment.assign(layers, [&] { return testCommit(planes); }), 0);
+    QVERIFY(assignment.assignedPlanes().isEmpty());
+    QVERIFY(!planes[0]->next());
+    QVERIFY(!planes[1]->next());
+}
+
+void PlaneAssignmentTest::testRejectedPlane()
+{
+    auto planes = createPlanes({{100, 3, {DRM_FORMAT_XRGB8888}},
+                                {101, 2, {DRM_FORMAT_XRGB8888}},
+                                {102, 1, {DRM_FORMAT_XRGB8888}}});
+    QCOMPARE(planes.size(), 3);
+    DrmPlaneAssignment assignment(s_crtcId, planes);
+
+    // The hardware can not scan out anything on the top plane.
+    MockDrm::setAtomicCommitHandler(s_fd, [](const MockDrm::AtomicRequest &request, uint32_t) {
+        return request[100][s_fbId] == 0;
+    });
+
+    auto layers = createLayers(3);
+    QCOMPARE(assignment.assign(layers, [&] { return testCommit(planes); }), 2);
+    QCOMPARE(assignment.assignedPlanes(), (QVector<DrmPlane*>{planes[1], planes[2]}));
+    QVERIFY(!planes[0]->next());
+    QCOMPARE(planes[1]->next(), layers[0].buffer);
+    QCOMPARE(planes[2]->next(), layers[1].buffer);
+}
+
+void PlaneAssignmentTest::testUnknownZpos()
+{
+    // Without zpos the stacking of the planes is unknown and only one of them is used.
+    auto planes = createPlanes({{100, -1, {DRM_FORMAT_XRGB8888}},
+                                {101, 1, {DRM_FORMAT_XRGB8888}}});
+    QCOMPARE(planes.size(), 2);
+    DrmPlaneAssignment assignment(s_crtcId, planes);
+    QCOMPARE(assignment.planes().size(), 1);
+
+    auto layers = createLayers(2);
+    QCOMPARE(assignment.assign(layers, [&] { return testCommit(planes); }), 1);
+    QCOMPARE(assignment.assignedPlanes().first()->next(), layers[0].buffer);
+}
+
+void PlaneAssignmentTest::testDisable()
+{
+    auto planes = createPlanes({{100, 2, {DRM_FORMAT_XRGB8888}},
+                                {101, 1, {DRM_FORMAT_XRGB8888}}});
+    QCOMPARE(planes.size(), 2);
+    DrmPlaneAssignment assignment(s_crtcId, planes);
+
+    QCOMPARE(assignment.assign(createLayers(2), [&] { return testCommit(planes); }), 2);
+
+    int tests = 0;
+    QCOMPARE(assignment.assign({}, [&] { tests++; return true; }), 0);
+    QCOMPARE(tests, 0);
+    QVERIFY(assignment.assignedPlanes().isEmpty());
+
+    MockDrm::setAtomicCommitHandler(s_fd, [](const MockDrm::AtomicRequest &request, uint32_t) {
+        return request[100][s_fbId] == 0 && request[100][s_crtcIdId] == 0
+            && request[101][s_fbId] == 0 && request[101][s_crtcIdId] == 0;
+    });
+    for (auto plane : planes) {
+        QVERIFY(!plane->next());
+    }
+    QVERIFY(testCommit(planes));
+}
+
+QTEST_GUILESS_MAIN(PlaneAssignmentTest)
+#include "planeassignmenttest.moc"
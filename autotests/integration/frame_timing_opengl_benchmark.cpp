@@ -0,0 +1,19 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_frame_timing_benchmark.h"
+
+class FrameTimingOpenGLBenchmark : public GenericFrameTimingBenchmark
+{
+    Q_OBJECT
+public:
+    FrameTimingOpenGLBenchmark()
+        : GenericFrameTimingBenchmark(QByteArrayLiteral("O2"))
+    {
+    }
+};
+
+WAYLANDTEST_MAIN(FrameTimingOpenGLBenchmark)
+#include "frame_timing_opengl_benchmark.moc"
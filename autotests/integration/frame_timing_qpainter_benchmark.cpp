@@ -0,0 +1,19 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_frame_timing_benchmark.h"
+
+class FrameTimingQPainterBenchmark : public GenericFrameTimingBenchmark
+{
+    Q_OBJECT
+public:
+    FrameTimingQPainterBenchmark()
+        : GenericFrameTimingBenchmark(QByteArrayLiteral("Q"))
+    {
+    }
+};
+
+WAYLANDTEST_MAIN(FrameTimingQPainterBenchmark)
+#include "frame_timing_qpainter_benchmark.moc"
@@ -0,0 +1,351 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_frame_timing_benchmark.h"
+
+#include "composite.h"
+#include "effect_builtins.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "render/wayland/output.h"
+#include "scene.h"
+#include "wayland_server.h"
+
+#include "win/wayland/window.h"
+
+#include <KConfigGroup>
+
+#include <Wrapland/Client/shm_pool.h>
+#include <Wrapland/Client/surface.h>
+#include <Wrapland/Client/xdg_shell.h>
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+using namespace KWin;
+namespace Clt = Wrapland::Client;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_frame_timing-0");
+
+// Frames per sample set for the median based benchmarks.
+static constexpr int s_frames{100};
+
+// Only allocations on the thread that enabled counting are taken into account. Counting is only
+// enabled while the compositor runs for the output, see allocation_counter.
+static thread_local bool s_count_allocations{false};
+static thread_local size_t s_allocated{0};
+
+void* operator new(std::size_t size)
+{
+    if (s_count_allocations) {
+        s_allocated += size;
+    }
+    if (auto ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+
+template<typename T>
+T median(std::vector<T> values)
+{
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+render::wayland::output* first_output()
+{
+    auto compositor = static_cast<WaylandCompositor*>(Compositor::self());
+    if (compositor->outputs.empty()) {
+        return nullptr;
+    }
+    return compositor->outputs.begin()->second.get();
+}
+
+/**
+ * Counts allocations only while the output handles its paint timer, so that allocations of the
+ * synthetic clients on the same thread are left out.
+ */
+class allocation_counter : public QObject
+{
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (event->type() != QEvent::Timer) {
+            return false;
+        }
+        s_count_allocations = true;
+        watched->event(event);
+        s_count_allocations = false;
+        return true;
+    }
+};
+
+}
+
+GenericFrameTimingBenchmark::GenericFrameTimingBenchmark(QByteArray const& compose)
+    : QObject()
+    , m_compose(compose)
+{
+}
+
+GenericFrameTimingBenchmark::~GenericFrameTimingBenchmark() = default;
+
+void GenericFrameTimingBenchmark::initTestCase()
+{
+    qRegisterMetaType<win::wayland::window*>();
+
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // Disable all effects so that only the scene itself is measured.
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("XCURSOR_THEME", QByteArrayLiteral("DMZ-White"));
+    qputenv("XCURSOR_SIZE", QByteArrayLiteral("24"));
+    qputenv("KWIN_COMPOSE", m_compose);
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    QVERIFY(Compositor::self()->scene());
+    QVERIFY(first_output());
+
+    m_allocationCounter = std::make_unique<allocation_counter>();
+    first_output()->installEventFilter(m_allocationCounter.get());
+}
+
+void GenericFrameTimingBenchmark::cleanup()
+{
+    for (auto& client : m_clients) {
+        delete client.toplevel;
+        delete client.surface;
+    }
+    m_clients.clear();
+    Test::destroyWaylandConnection();
+}
+
+void GenericFrameTimingBenchmark::add_rows()
+{
+    QTest::addColumn<int>("clients");
+    QTest::addColumn<int>("pattern");
+
+    auto const patterns = {std::make_pair(damage_pattern::full, "full"),
+                           std::make_pair(damage_pattern::partial, "partial"),
+                           std::make_pair(damage_pattern::single, "single")};
+
+    for (auto const& [pattern, name] : patterns) {
+        for (auto count : {1, 8, 32}) {
+            QTest::addRow("%s-%d", name, count) << count << static_cast<int>(pattern);
+        }
+    }
+}
+
+void GenericFrameTimingBenchmark::setup_clients(int count)
+{
+    Test::setupWaylandConnection();
+
+    for (int i = 0; i < count; i++) {
+        client client;
+        client.surface = Test::createSurface();
+        QVERIFY(client.surface);
+        client.toplevel = Test::create_xdg_shell_toplevel(client.surface);
+        QVERIFY(client.toplevel);
+
+        client.image = QImage(QSize(320, 240), QImage::Format_ARGB32_Premultiplied);
+        client.image.fill(QColor::fromHsv(i * 360 / count, 255, 255));
+
+        auto window = Test::renderAndWaitForShown(client.surface, client.image.size(), Qt::blue);
+        QVERIFY(window);
+
+        m_clients.push_back(client);
+    }
+}
+
+bool GenericFrameTimingBenchmark::render_frame(damage_pattern pattern, int frame)
+{
+    assert(!m_clients.empty());
+
+    auto const single = static_cast<size_t>(frame) % m_clients.size();
+    auto last = pattern == damage_pattern::single ? m_clients.at(single).surface
+                                                  : m_clients.back().surface;
+    auto const color = QColor::fromHsv(frame * 37 % 360, 255, 255);
+
+    for (size_t i = 0; i < m_clients.size(); i++) {
+        auto& client = m_clients.at(i);
+        auto damage = client.image.rect();
+
+        switch (pattern) {
+        case damage_pattern::full:
+            break;
+        case damage_pattern::partial:
+            damage = QRect(frame * 16 % (damage.width() - 32),
+                           frame * 8 % (damage.height() - 32), 32, 32);
+            break;
+        case damage_pattern::single:
+            if (i != single) {
+                continue;
+            }
+            break;
+        }
+
+        QPainter painter(&client.image);
+        painter.fillRect(damage, color);
+        painter.end();
+
+        client.surface->attachBuffer(Test::waylandShmPool()->createBuffer(client.image));
+        client.surface->damage(damage);
+        client.surface->commit(Clt::Surface::CommitFlag::FrameCallback);
+    }
+
+    QSignalSpy frameRenderedSpy(last, &Clt::Surface::frameRendered);
+    return frameRenderedSpy.isValid() && frameRenderedSpy.wait();
+}
+
+std::vector<GenericFrameTimingBenchmark::frame_sample>
+GenericFrameTimingBenchmark::run_frames(damage_pattern pattern, int count)
+{
+    auto output = first_output();
+    std::vector<frame_sample> samples;
+
+    for (int frame = 0; frame < count; frame++) {
+        s_allocated = 0;
+        auto const rendered = render_frame(pattern, frame);
+
+        if (!rendered) {
+            return {};
+        }
+        samples.push_back({output->last_run.prepare, output->last_run.paint, s_allocated});
+    }
+
+    return samples;
+}
+
+void GenericFrameTimingBenchmark::benchmarkFrame_data()
+{
+    add_rows();
+}
+
+void GenericFrameTimingBenchmark::benchmarkFrame()
+{
+    // Measures the whole round trip from committing the damage to the frame callback.
+    QFETCH(int, clients);
+    QFETCH(int, pattern);
+
+    setup_clients(clients);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    int frame = 0;
+    QBENCHMARK
+    {
+        QVERIFY(render_frame(static_cast<damage_pattern>(pattern), frame++));
+    }
+}
+
+void GenericFrameTimingBenchmark::benchmarkPrepareRun_data()
+{
+    add_rows();
+}
+
+void GenericFrameTimingBenchmark::benchmarkPrepareRun()
+{
+    QFETCH(int, clients);
+    QFETCH(int, pattern);
+
+    setup_clients(clients);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    auto const samples = run_frames(static_cast<damage_pattern>(pattern), s_frames);
+    QVERIFY(!samples.empty());
+
+    std::vector<int64_t> durations;
+    for (auto const& sample : samples) {
+        durations.push_back(sample.prepare.count());
+    }
+    QTest::setBenchmarkResult(median(durations), QTest::WalltimeNanoseconds);
+}
+
+void GenericFrameTimingBenchmark::benchmarkScenePaint_data()
+{
+    add_rows();
+}
+
+void GenericFrameTimingBenchmark::benchmarkScenePaint()
+{
+    QFETCH(int, clients);
+    QFETCH(int, pattern);
+
+    setup_clients(clients);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    auto const samples = run_frames(static_cast<damage_pattern>(pattern), s_frames);
+    QVERIFY(!samples.empty());
+
+    std::vector<int64_t> durations;
+    for (auto const& sample : samples) {
+        durations.push_back(sample.paint.count());
+    }
+    QTest::setBenchmarkResult(median(durations), QTest::WalltimeNanoseconds);
+}
+
+void GenericFrameTimingBenchmark::benchmarkAllocations_data()
+{
+    add_rows();
+}
+
+void GenericFrameTimingBenchmark::benchmarkAllocations()
+{
+    QFETCH(int, clients);
+    QFETCH(int, pattern);
+
+    setup_clients(clients);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    auto const samples = run_frames(static_cast<damage_pattern>(pattern), s_frames);
+    QVERIFY(!samples.empty());
+
+    std::vector<size_t> allocated;
+    for (auto const& sample : samples) {
+        allocated.push_back(sample.allocated);
+    }
+    QTest::setBenchmarkResult(median(allocated), QTest::BytesAllocated);
+}
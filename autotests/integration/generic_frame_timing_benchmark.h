@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "kwin_wayland_test.h"
+
+#include <QObject>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace Wrapland::Client
+{
+class Surface;
+class XdgShellToplevel;
+}
+
+/**
+ * Measures the compositing hot path on the virtual platform. Synthetic clients commit scripted
+ * damage and for each frame the time spent preparing the run, painting the scene and the bytes
+ * allocated by the compositor's run for the output are reported.
+ */
+class GenericFrameTimingBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    ~GenericFrameTimingBenchmark() override;
+
+protected:
+    GenericFrameTimingBenchmark(QByteArray const& compose);
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void benchmarkFrame_data();
+    void benchmarkFrame();
+    void benchmarkPrepareRun_data();
+    void benchmarkPrepareRun();
+    void benchmarkScenePaint_data();
+    void benchmarkScenePaint();
+    void benchmarkAllocations_data();
+    void benchmarkAllocations();
+
+private:
+    enum class damage_pattern {
+        // Every client damages its whole surface.
+        full,
+        // Every client damages a small rect that moves from frame to frame.
+        partial,
+        // Only one client per frame damages its whole surface.
+        single,
+    };
+
+    struct client {
+        Wrapland::Client::Surface* surface{nullptr};
+        Wrapland::Client::XdgShellToplevel* toplevel{nullptr};
+        QImage image;
+    };
+
+    struct frame_sample {
+        std::chrono::nanoseconds prepare;
+        std::chrono::nanoseconds paint;
+        size_t allocated;
+    };
+
+    void add_rows();
+    void setup_clients(int count);
+    bool render_frame(damage_pattern pattern, int frame);
+    std::vector<frame_sample> run_frames(damage_pattern pattern, int count);
+
+    QByteArray m_compose;
+    std::vector<client> m_clients;
+    std::unique_ptr<QObject> m_allocationCounter;
+};
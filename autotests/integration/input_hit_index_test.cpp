@@ -0,0 +1,277 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "cursor.h"
+#include "input.h"
+#include "platform.h"
+#include "screens.h"
+#include "toplevel.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include "win/deco.h"
+#include "win/geo.h"
+#include "win/move.h"
+#include "win/wayland/window.h"
+
+#include <Wrapland/Client/surface.h>
+#include <Wrapland/Client/xdg_shell.h>
+#include <Wrapland/Client/xdgdecoration.h>
+
+#include <KConfigGroup>
+#include <KDecoration2/Decoration>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_input_hit_index-0");
+
+class InputHitIndexTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testPartitions();
+    void testMoveBetweenOutputs();
+    void testStackingOrderChange();
+    void testOutputsChange();
+    void testResizeOnlyBorders();
+
+private:
+    Toplevel* showWindow(QSize const& size, bool decorated = false);
+
+    struct Window {
+        std::unique_ptr<Wrapland::Client::Surface> surface;
+        std::unique_ptr<Wrapland::Client::XdgShellToplevel> toplevel;
+        std::unique_ptr<Wrapland::Client::XdgDecoration> decoration;
+    };
+    std::vector<Window> m_windows;
+};
+
+void InputHitIndexTest::initTestCase()
+{
+    qRegisterMetaType<win::wayland::window*>();
+
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(int, 2));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QCOMPARE(screens()->count(), 2);
+    QCOMPARE(screens()->geometry(0), QRect(0, 0, 1280, 1024));
+    QCOMPARE(screens()->geometry(1), QRect(1280, 0, 1280, 1024));
+    waylandServer()->initWorkspace();
+}
+
+void InputHitIndexTest::init()
+{
+    Test::setupWaylandConnection(Test::AdditionalWaylandInterface::XdgDecoration);
+
+    screens()->setCurrent(0);
+    Cursor::setPos(QPoint(640, 512));
+}
+
+void InputHitIndexTest::cleanup()
+{
+    m_windows.clear();
+    Test::destroyWaylandConnection();
+
+    const QVector<QRect> geometries{QRect(0, 0, 1280, 1024), QRect(1280, 0, 1280, 1024)};
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs",
+                              Qt::DirectConnection,
+                              Q_ARG(int, 2),
+                              Q_ARG(QVector<QRect>, geometries));
+}
+
+Toplevel* InputHitIndexTest::showWindow(QSize const& size, bool decorated)
+{
+    using namespace Wrapland::Client;
+#define VERIFY(statement) \
+    if (!QTest::qVerify((statement), #statement, "", __FILE__, __LINE__))\
+        return nullptr;
+
+    Window window;
+    window.surface.reset(Test::createSurface(Test::waylandCompositor()));
+    VERIFY(window.surface);
+    window.toplevel.reset(Test::create_xdg_shell_toplevel(window.surface.get(), nullptr,
+                                                          Test::CreationSetup::CreateOnly));
+    VERIFY(window.toplevel);
+
+    if (decorated) {
+        window.decoration.reset(Test::xdgDecorationManager()->getToplevelDecoration(
+            window.toplevel.get(), window.toplevel.get()));
+        VERIFY(window.decoration);
+        window.decoration->setMode(XdgDecoration::Mode::ServerSide);
+    }
+
+    QSignalSpy configureRequestedSpy(window.toplevel.get(), &XdgShellToplevel::configureRequested);
+    VERIFY(configureRequestedSpy.isValid());
+    Test::init_xdg_shell_toplevel(window.surface.get(), window.toplevel.get());
+    VERIFY(configureRequestedSpy.count() > 0 || configureRequestedSpy.wait());
+    window.toplevel->ackConfigure(configureRequestedSpy.last()[2].toInt());
+
+    auto c = Test::renderAndWaitForShown(window.surface.get(), size, Qt::blue);
+    VERIFY(c);
+    VERIFY(!decorated || win::decoration(c));
+
+    m_windows.push_back(std::move(window));
+    return c;
+#undef VERIFY
+}
+
+void InputHitIndexTest::testPartitions()
+{
+    // Windows are found on the outputs they intersect and only there.
+    auto left = showWindow(QSize(100, 50));
+    QVERIFY(left);
+    win::move(left, QPoint(100, 100));
+
+    auto right = showWindow(QSize(100, 50));
+    QVERIFY(right);
+    win::move(right, QPoint(1400, 100));
+
+    auto spanning = showWindow(QSize(200, 50));
+    QVERIFY(spanning);
+    win::move(spanning, QPoint(1200, 500));
+
+    QCOMPARE(input()->findManagedToplevel(QPoint(150, 120)), left);
+    QCOMPARE(input()->findManagedToplevel(QPoint(1450, 120)), right);
+    QCOMPARE(input()->findManagedToplevel(QPoint(1250, 520)), spanning);
+    QCOMPARE(input()->findManagedToplevel(QPoint(1350, 520)), spanning);
+
+    QVERIFY(!input()->findManagedToplevel(QPoint(1450, 300)));
+    QVERIFY(!input()->findManagedToplevel(QPoint(99, 120)));
+    QVERIFY(!input()->findManagedToplevel(QPoint(150, 150)));
+}
+
+void InputHitIndexTest::testMoveBetweenOutputs()
+{
+    // Geometry changes are applied to the output partitions in place.
+    auto window = showWindow(QSize(100, 50));
+    QVERIFY(window);
+    win::move(window, QPoint(100, 100));
+    QCOMPARE(input()->findManagedToplevel(QPoint(150, 120)), window);
+
+    win::move(window, QPoint(1400, 100));
+    QVERIFY(!input()->findManagedToplevel(QPoint(150, 120)));
+    QCOMPARE(input()->findManagedToplevel(QPoint(1450, 120)), window);
+
+    // Partially on both outputs.
+    win::move(window, QPoint(1230, 100));
+    QCOMPARE(input()->findManagedToplevel(QPoint(1250, 120)), window);
+    QCOMPARE(input()->findManagedToplevel(QPoint(1300, 120)), window);
+    QVERIFY(!input()->findManagedToplevel(QPoint(1450, 120)));
+
+    win::move(window, QPoint(100, 100));
+    QCOMPARE(input()->findManagedToplevel(QPoint(150, 120)), window);
+    QVERIFY(!input()->findManagedToplevel(QPoint(1300, 120)));
+}
+
+void InputHitIndexTest::testStackingOrderChange()
+{
+    // The topmost window is found, also after the stacking order changed.
+    auto window1 = showWindow(QSize(100, 50));
+    QVERIFY(window1);
+    auto window2 = showWindow(QSize(100, 50));
+    QVERIFY(window2);
+    win::move(window1, QPoint(100, 100));
+    win::move(window2, QPoint(100, 100));
+
+    QCOMPARE(input()->findManagedToplevel(QPoint(150, 120)), window2);
+
+    workspace()->raise_window(window1);
+    QCOMPARE(input()->findManagedToplevel(QPoint(150, 120)), window1);
+
+    workspace()->lower_window(window1);
+    QCOMPARE(input()->findManagedToplevel(QPoint(150, 120)), window2);
+
+    // Closing the topmost window reveals the other one.
+    QSignalSpy windowClosedSpy(window2, &Toplevel::windowClosed);
+    QVERIFY(windowClosedSpy.isValid());
+    m_windows.pop_back();
+    QVERIFY(windowClosedSpy.wait());
+    QCOMPARE(input()->findManagedToplevel(QPoint(150, 120)), window1);
+}
+
+void InputHitIndexTest::testOutputsChange()
+{
+    // Partitions follow the outputs.
+    auto window = showWindow(QSize(100, 50));
+    QVERIFY(window);
+    win::move(window, QPoint(1400, 100));
+    QCOMPARE(input()->findManagedToplevel(QPoint(1450, 120)), window);
+
+    QSignalSpy screensChangedSpy(screens(), &Screens::changed);
+    QVERIFY(screensChangedSpy.isValid());
+    const QVector<QRect> geometries{QRect(0, 0, 1280, 1024), QRect(0, 1024, 1280, 1024)};
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs",
+                              Qt::DirectConnection,
+                              Q_ARG(int, 2),
+                              Q_ARG(QVector<QRect>, geometries));
+    QCOMPARE(screensChangedSpy.count(), 1);
+
+    // The window is moved back onto the outputs or stays outside of them. Either way it must be
+    // found where its input geometry is.
+    auto const pos = win::input_geometry(window).center();
+    QCOMPARE(input()->findManagedToplevel(pos), window);
+    QVERIFY(!input()->findManagedToplevel(pos + QPoint(0, 500)));
+}
+
+void InputHitIndexTest::testResizeOnlyBorders()
+{
+    // The resize-only borders of the decoration are part of the input geometry. Changes of them
+    // must reach the index.
+    auto window = showWindow(QSize(500, 50), true);
+    QVERIFY(window);
+    win::move(window, QPoint(100, 100));
+
+    auto check = [window] {
+        auto const geo = win::input_geometry(window);
+        auto const outside = geo.adjusted(-1, -1, 1, 1);
+        for (auto const& pos : {geo.topLeft(), geo.bottomRight(), geo.center()}) {
+            if (input()->findManagedToplevel(pos) != window) {
+                return false;
+            }
+        }
+        for (auto const& pos : {outside.topLeft(), outside.bottomRight()}) {
+            if (input()->findManagedToplevel(pos)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    QVERIFY(check());
+
+    auto deco = win::decoration(window);
+    QVERIFY(deco);
+    QSignalSpy bordersChangedSpy(deco, &KDecoration2::Decoration::resizeOnlyBordersChanged);
+    QVERIFY(bordersChangedSpy.isValid());
+
+    // Without borders the decoration provides borders for resizing outside of the frame.
+    auto group = kwinApp()->config()->group("org.kde.kdecoration2");
+    group.writeEntry("BorderSize", QStringLiteral("None"));
+    group.sync();
+    workspace()->slotReconfigure();
+    QVERIFY(bordersChangedSpy.count() || bordersChangedSpy.wait());
+    QVERIFY(win::input_geometry(window) != window->frameGeometry());
+    QVERIFY(check());
+
+    group.deleteEntry("BorderSize");
+    group.sync();
+    workspace()->slotReconfigure();
+    QTRY_VERIFY(bordersChangedSpy.count() > 1);
+    QVERIFY(check());
+}
+}
+
+WAYLANDTEST_MAIN(KWin::InputHitIndexTest)
+#include "input_hit_index_test.moc"
@@ -0,0 +1,204 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "platform.h"
+#include "rules/rule_book.h"
+#include "rules/rules.h"
+#include "utils.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include "win/wayland/window.h"
+
+#include <Wrapland/Client/surface.h>
+#include <Wrapland/Client/xdg_shell.h>
+
+#include <KConfigGroup>
+
+#include <algorithm>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_rule_book-0");
+
+class RuleBookTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testPriorityOrder_data();
+    void testPriorityOrder();
+    void testTemporaryRule();
+
+private:
+    struct rule {
+        QByteArray wmclass;
+        bool complete;
+        Rules::StringMatch match;
+        QPoint position;
+    };
+    void setRules(QVector<rule> const& rules);
+
+    Toplevel* m_window{nullptr};
+    std::unique_ptr<Wrapland::Client::Surface> m_surface;
+    std::unique_ptr<Wrapland::Client::XdgShellToplevel> m_toplevel;
+};
+
+void RuleBookTest::initTestCase()
+{
+    qRegisterMetaType<win::wayland::window*>();
+
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+}
+
+void RuleBookTest::init()
+{
+    using namespace Wrapland::Client;
+    Test::setupWaylandConnection();
+
+    m_surface.reset(Test::createSurface());
+    QVERIFY(m_surface);
+    m_toplevel.reset(Test::create_xdg_shell_toplevel(m_surface.get(), nullptr,
+                                                     Test::CreationSetup::CreateOnly));
+    QVERIFY(m_toplevel);
+    m_toplevel->setAppId(QByteArrayLiteral("org.kde.foo"));
+
+    QSignalSpy configureRequestedSpy(m_toplevel.get(), &XdgShellToplevel::configureRequested);
+    QVERIFY(configureRequestedSpy.isValid());
+    m_surface->commit(Surface::CommitFlag::None);
+    QVERIFY(configureRequestedSpy.wait());
+    m_toplevel->ackConfigure(configureRequestedSpy.last().at(2).value<quint32>());
+
+    m_window = Test::renderAndWaitForShown(m_surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(m_window);
+    QCOMPARE(m_window->resourceClass(), QByteArrayLiteral("org.kde.foo"));
+}
+
+void RuleBookTest::cleanup()
+{
+    m_toplevel.reset();
+    m_surface.reset();
+    if (m_window) {
+        QVERIFY(Test::waitForWindowDestroyed(m_window));
+        m_window = nullptr;
+    }
+    Test::destroyWaylandConnection();
+
+    // Unreference the previous config.
+    RuleBook::self()->setConfig({});
+    workspace()->slotReconfigure();
+}
+
+void RuleBookTest::setRules(QVector<rule> const& rules)
+{
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    config->group("General").writeEntry("count", rules.size());
+
+    for (int i = 0; i < rules.size(); i++) {
+        auto const& rule = rules.at(i);
+        auto group = config->group(QString::number(i + 1));
+        group.writeEntry("wmclass", rule.wmclass);
+        group.writeEntry("wmclasscomplete", rule.complete);
+        group.writeEntry("wmclassmatch", int(rule.match));
+        group.writeEntry("position", rule.position);
+        group.writeEntry("positionrule", int(Rules::Force));
+    }
+
+    config->sync();
+    RuleBook::self()->setConfig(config);
+    workspace()->slotReconfigure();
+}
+
+void RuleBookTest::testPriorityOrder_data()
+{
+    QTest::addColumn<QString>("order");
+
+    // g: substring match, evaluated for every window
+    // c: exact window class
+    // n: exact resource name and window class
+    for (auto const& order : {"gcn", "gnc", "cgn", "cng", "ngc", "ncg"}) {
+        QTest::newRow(order) << QString::fromLatin1(order);
+    }
+}
+
+void RuleBookTest::testPriorityOrder()
+{
+    // Rules are held in buckets by their exact window class. The rule that comes first in the
+    // rule list must still win, no matter in which bucket it is.
+    QFETCH(QString, order);
+
+    auto const complete = m_window->resourceName() + ' ' + m_window->resourceClass();
+
+    // Rules for other windows in all buckets and in front of the matching ones.
+    QVector<rule> rules{
+        {QByteArrayLiteral("org.kde.bar"), false, Rules::ExactMatch, QPoint(1, 1)},
+        {m_window->resourceName() + " org.kde.bar", true, Rules::ExactMatch, QPoint(2, 2)},
+        {QByteArrayLiteral("kde.bar"), false, Rules::SubstringMatch, QPoint(3, 3)},
+    };
+
+    QPoint expected;
+    for (auto const kind : order) {
+        rule entry;
+        if (kind == QLatin1Char('g')) {
+            entry = {QByteArrayLiteral("kde.fo"), false, Rules::SubstringMatch, QPoint(10, 10)};
+        } else if (kind == QLatin1Char('c')) {
+            entry = {QByteArrayLiteral("org.kde.foo"), false, Rules::ExactMatch, QPoint(20, 20)};
+        } else {
+            entry = {complete, true, Rules::ExactMatch, QPoint(30, 30)};
+        }
+        if (expected.isNull()) {
+            expected = entry.position;
+        }
+        rules.append(entry);
+    }
+    setRules(rules);
+
+    auto const windowRules = RuleBook::self()->find(m_window, false);
+    QCOMPARE(windowRules.checkPosition(invalidPoint, true), expected);
+
+    // The index is rebuilt when the rules change.
+    std::reverse(rules.begin() + 3, rules.end());
+    setRules(rules);
+    QCOMPARE(RuleBook::self()->find(m_window, false).checkPosition(invalidPoint, true),
+             rules.at(3).position);
+}
+
+void RuleBookTest::testTemporaryRule()
+{
+    // Temporary rules take precedence, are applied once and then removed from the index.
+    setRules({{QByteArrayLiteral("org.kde.foo"), false, Rules::ExactMatch, QPoint(10, 10)}});
+    QCOMPARE(RuleBook::self()->find(m_window, false).checkPosition(invalidPoint, true),
+             QPoint(10, 10));
+
+    auto const message = QStringLiteral("wmclass=org.kde.foo\nwmclassmatch=%1\n"
+                                        "position=20,20\npositionrule=%2\n")
+                             .arg(int(Rules::ExactMatch))
+                             .arg(int(Rules::Force));
+    QVERIFY(QMetaObject::invokeMethod(RuleBook::self(), "temporaryRulesMessage",
+                                      Qt::DirectConnection, Q_ARG(QString, message)));
+
+    // Ignored temporary rules stay.
+    QCOMPARE(RuleBook::self()->find(m_window, true).checkPosition(invalidPoint, true),
+             QPoint(10, 10));
+
+    QCOMPARE(RuleBook::self()->find(m_window, false).checkPosition(invalidPoint, true),
+             QPoint(20, 20));
+    QCOMPARE(RuleBook::self()->find(m_window, false).checkPosition(invalidPoint, true),
+             QPoint(10, 10));
+}
+
+WAYLANDTEST_MAIN(RuleBookTest)
+#include "rule_book_test.moc"
@@ -0,0 +1,158 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../mock_effectwindow.h"
+
+#include <kwineffects.h>
+
+#include <QtTest>
+
+using namespace KWin;
+
+namespace
+{
+
+struct Tracked {
+    Tracked(int value, int *destroyed)
+        : value(value)
+        , destroyed(destroyed)
+    {
+    }
+    ~Tracked()
+    {
+        ++*destroyed;
+    }
+
+    int value;
+    int *destroyed;
+};
+
+}
+
+class EffectWindowSlotTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmplace();
+    void testSet();
+    void testReset();
+    void testIndependentSlots();
+    void testWindowDestroyed();
+    void testSlotDestroyed();
+};
+
+void EffectWindowSlotTest::testEmplace()
+{
+    int destroyed = 0;
+    EffectWindowSlot<Tracked> slot;
+    MockEffectWindow w;
+
+    QVERIFY(!slot.get(&w));
+
+    auto &value = slot.emplace(&w, 1, &destroyed);
+    QCOMPARE(value.value, 1);
+    QCOMPARE(slot.get(&w), &value);
+
+    // Emplacing again replaces the value.
+    auto &replaced = slot.emplace(&w, 2, &destroyed);
+    QCOMPARE(destroyed, 1);
+    QCOMPARE(slot.get(&w), &replaced);
+    QCOMPARE(slot.get(&w)->value, 2);
+}
+
+void EffectWindowSlotTest::testSet()
+{
+    int destroyed = 0;
+    EffectWindowSlot<Tracked> slot;
+    MockEffectWindow w;
+
+    auto value = slot.set(&w, std::make_unique<Tracked>(1, &destroyed));
+    QCOMPARE(slot.get(&w), value);
+
+    slot.set(&w, std::make_unique<Tracked>(2, &destroyed));
+    QCOMPARE(destroyed, 1);
+    QCOMPARE(slot.get(&w)->value, 2);
+
+    // Setting null is a reset.
+    slot.set(&w, nullptr);
+    QCOMPARE(destroyed, 2);
+    QVERIFY(!slot.get(&w));
+}
+
+void EffectWindowSlotTest::testReset()
+{
+    int destroyed = 0;
+    EffectWindowSlot<Tracked> slot;
+    MockEffectWindow w1;
+    MockEffectWindow w2;
+
+    slot.emplace(&w1, 1, &destroyed);
+    slot.emplace(&w2, 2, &destroyed);
+
+    slot.reset(&w1);
+    QCOMPARE(destroyed, 1);
+    QVERIFY(!slot.get(&w1));
+    QCOMPARE(slot.get(&w2)->value, 2);
+
+    // Resetting without a value is fine.
+    slot.reset(&w1);
+    QCOMPARE(destroyed, 1);
+}
+
+void EffectWindowSlotTest::testIndependentSlots()
+{
+    int destroyed = 0;
+    EffectWindowSlot<Tracked> slot1;
+    EffectWindowSlot<int> slot2;
+    MockEffectWindow w;
+
+    slot1.emplace(&w, 1, &destroyed);
+    QVERIFY(!slot2.get(&w));
+
+    slot2.emplace(&w, 2);
+    QCOMPARE(slot1.get(&w)->value, 1);
+    QCOMPARE(*slot2.get(&w), 2);
+
+    slot1.reset(&w);
+    QCOMPARE(*slot2.get(&w), 2);
+}
+
+void EffectWindowSlotTest::testWindowDestroyed()
+{
+    int destroyed = 0;
+    EffectWindowSlot<Tracked> slot;
+    MockEffectWindow w;
+
+    auto other = new MockEffectWindow;
+    slot.emplace(&w, 1, &destroyed);
+    slot.emplace(other, 2, &destroyed);
+
+    delete other;
+    QCOMPARE(destroyed, 1);
+    QCOMPARE(slot.get(&w)->value, 1);
+}
+
+void EffectWindowSlotTest::testSlotDestroyed()
+{
+    // Values of a slot are destroyed with it, like when the effect or handler owning it goes away.
+    int destroyed = 0;
+    MockEffectWindow w1;
+    MockEffectWindow w2;
+
+    auto slot = new EffectWindowSlot<Tracked>;
+    slot->emplace(&w1, 1, &destroyed);
+    slot->emplace(&w2, 2, &destroyed);
+
+    delete slot;
+    QCOMPARE(destroyed, 2);
+
+    // A new slot may reuse the index, but starts out empty.
+    EffectWindowSlot<Tracked> reused;
+    QVERIFY(!reused.get(&w1));
+    QVERIFY(!reused.get(&w2));
+}
+
+QTEST_MAIN(EffectWindowSlotTest)
+#include "effectwindowslottest.moc"
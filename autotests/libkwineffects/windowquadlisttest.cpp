@@ -18,6 +18,7 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include <kwineffects.h>
+#include <QMatrix4x4>
 #include <QTest>
 
 Q_DECLARE_METATYPE(KWin::WindowQuadList)
@@ -30,6 +31,8 @@ private Q_SLOTS:
     void testMakeGrid();
     void testMakeRegularGrid_data();
     void testMakeRegularGrid();
+    void testMakeInterleavedArrays_data();
+    void testMakeInterleavedArrays();
 
 private:
     KWin::WindowQuad makeQuad(const QRectF &rect);
@@ -216,6 +219,45 @@ void WindowQuadListTest::testMakeRegularGrid()
     }
 }
 
+void WindowQuadListTest::testMakeInterleavedArrays_data()
+{
+    QTest::addColumn<uint>("type");
+    QTest::addColumn<QVector<int>>("indices");
+
+    // GL_QUADS and GL_TRIANGLES
+    QTest::newRow("quads") << 0x0007u << QVector<int>{0, 1, 2, 3};
+    QTest::newRow("triangles") << 0x0004u << QVector<int>{1, 0, 3, 3, 2, 1};
+}
+
+void WindowQuadListTest::testMakeInterleavedArrays()
+{
+    QFETCH(uint, type);
+    QFETCH(QVector<int>, indices);
+
+    KWin::WindowQuadList quads;
+    quads.append(makeQuad(QRectF(0, 0, 10, 20)));
+    quads.append(makeQuad(QRectF(10, 20, 30, 40)));
+    quads[1][2].move(45, 65);
+
+    // The texture matrix only scales and translates.
+    QMatrix4x4 matrix;
+    matrix.translate(0.5, 0.25);
+    matrix.scale(0.5, 2);
+
+    alignas(16) KWin::GLVertex2D vertices[12];
+    quads.makeInterleavedArrays(type, vertices, matrix);
+
+    int i = 0;
+    for (const KWin::WindowQuad &quad : quads) {
+        for (int index : indices) {
+            const KWin::WindowVertex &expected = quad[index];
+            QCOMPARE(vertices[i].position, QVector2D(expected.x(), expected.y()));
+            QCOMPARE(vertices[i].texcoord, QVector2D(expected.u() * 0.5 + 0.5, expected.v() * 2 + 0.25));
+            i++;
+        }
+    }
+}
+
 QTEST_MAIN(WindowQuadListTest)
 
 #include "windowquadlisttest.moc"
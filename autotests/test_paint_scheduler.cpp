@@ -0,0 +1,126 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../render/wayland/paint_scheduler.h"
+
+#include <QTest>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class PaintSchedulerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testRefreshLength();
+    void testPrediction();
+    void testPercentileIgnoresOutliers();
+    void testDelayFromVblank();
+    void testDelaySkipsMissedVblank();
+    void testDelaySlowRendering();
+};
+
+void PaintSchedulerTest::testRefreshLength()
+{
+    render::wayland::paint_scheduler scheduler;
+    scheduler.set_refresh_rate(60000);
+    QCOMPARE(scheduler.refresh_length(), 16666666ns);
+
+    scheduler.set_refresh_rate(144000);
+    QCOMPARE(scheduler.refresh_length(), 6944444ns);
+
+    // Invalid rates are ignored.
+    scheduler.set_refresh_rate(0);
+    QCOMPARE(scheduler.refresh_length(), 6944444ns);
+}
+
+void PaintSchedulerTest::testPrediction()
+{
+    render::wayland::paint_scheduler scheduler;
+    QCOMPARE(scheduler.predicted_render_time(), 0ns);
+
+    // CPU and GPU durations overlap, the longer one counts.
+    scheduler.add_render_duration(2ms, 1ms);
+    QCOMPARE(scheduler.predicted_render_time(), 2ms);
+
+    for (size_t i = 0; i < render::wayland::paint_scheduler::window_size; i++) {
+        scheduler.add_render_duration(1ms, 3ms);
+    }
+    QCOMPARE(scheduler.predicted_render_time(), 3ms);
+
+    // The oldest durations leave the window.
+    for (size_t i = 0; i < render::wayland::paint_scheduler::window_size; i++) {
+        scheduler.add_render_duration(1ms, 0ns);
+    }
+    QCOMPARE(scheduler.predicted_render_time(), 1ms);
+}
+
+void PaintSchedulerTest::testPercentileIgnoresOutliers()
+{
+    render::wayland::paint_scheduler scheduler;
+    scheduler.set_percentile(90);
+
+    for (int i = 0; i < 60; i++) {
+        scheduler.add_render_duration(2ms, 0ns);
+    }
+    for (int i = 0; i < 4; i++) {
+        scheduler.add_render_duration(10ms, 0ns);
+    }
+    QCOMPARE(scheduler.predicted_render_time(), 2ms);
+
+    scheduler.set_percentile(100);
+    scheduler.add_render_duration(2ms, 0ns);
+    QCOMPARE(scheduler.predicted_render_time(), 10ms);
+}
+
+void PaintSchedulerTest::testDelayFromVblank()
+{
+    render::wayland::paint_scheduler scheduler;
+    scheduler.set_refresh_rate(50000);
+    scheduler.set_latency_budget(1ms);
+    scheduler.add_render_duration(2ms, 5ms);
+
+    // Vblank every 20ms. Painting must start 6ms before the next one.
+    scheduler.presented(100ms);
+    QCOMPARE(scheduler.next_delay(100ms), 14ms);
+    QCOMPARE(scheduler.next_delay(104ms), 10ms);
+
+    // Without a presentation timestamp the vblank is assumed to be now.
+    render::wayland::paint_scheduler unsynced;
+    unsynced.set_refresh_rate(50000);
+    unsynced.set_latency_budget(1ms);
+    QCOMPARE(unsynced.next_delay(500ms), 19ms);
+}
+
+void PaintSchedulerTest::testDelaySkipsMissedVblank()
+{
+    render::wayland::paint_scheduler scheduler;
+    scheduler.set_refresh_rate(50000);
+    scheduler.set_latency_budget(1ms);
+    scheduler.add_render_duration(5ms, 0ns);
+
+    scheduler.presented(100ms);
+
+    // Too late for the vblank at 120ms, so aim for the one at 140ms.
+    QCOMPARE(scheduler.next_delay(116ms), 18ms);
+
+    // Timestamps from earlier cycles are extrapolated.
+    QCOMPARE(scheduler.next_delay(145ms), 9ms);
+}
+
+void PaintSchedulerTest::testDelaySlowRendering()
+{
+    render::wayland::paint_scheduler scheduler;
+    scheduler.set_refresh_rate(50000);
+    scheduler.set_latency_budget(1ms);
+    scheduler.add_render_duration(25ms, 0ns);
+
+    // Rendering takes longer than a refresh cycle. Start right away.
+    scheduler.presented(100ms);
+    QCOMPARE(scheduler.next_delay(101ms), 0ns);
+}
+
+QTEST_GUILESS_MAIN(PaintSchedulerTest)
+#include "test_paint_scheduler.moc"
@@ -0,0 +1,161 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../plugins/scenes/qpainter/tile_kernels.h"
+
+#include <QRandomGenerator>
+#include <QTest>
+
+#include <algorithm>
+#include <vector>
+
+using namespace KWin;
+
+namespace
+{
+
+// Source over per channel, dividing by 255 the way QPainter approximates it.
+uint32_t referenceBlend(uint32_t dst, uint32_t src)
+{
+    const uint32_t inv = 0xff - (src >> 24);
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t t = ((dst >> shift) & 0xff) * inv;
+        const uint32_t channel = ((src >> shift) & 0xff) + ((t + (t >> 8) + 0x80) >> 8);
+        result |= channel << shift;
+    }
+    return result;
+}
+
+uint32_t premultiplied(QRandomGenerator &random, uint32_t alpha)
+{
+    uint32_t pixel = alpha << 24;
+    for (int shift = 0; shift < 24; shift += 8) {
+        pixel |= random.bounded(alpha + 1) << shift;
+    }
+    return pixel;
+}
+
+// Mixes opaque, transparent and translucent pixels, so vectors of each kind and mixed ones occur.
+std::vector<uint32_t> randomPixels(QRandomGenerator &random, int count)
+{
+    std::vector<uint32_t> pixels(count);
+    for (auto &pixel : pixels) {
+        switch (random.bounded(4)) {
+        case 0:
+            pixel = premultiplied(random, 0xff);
+            break;
+        case 1:
+            pixel = 0;
+            break;
+        default:
+            pixel = premultiplied(random, random.bounded(256));
+            break;
+        }
+    }
+    return pixels;
+}
+
+}
+
+class TileKernelsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testCopy_data();
+    void testCopy();
+    void testBlend_data();
+    void testBlend();
+    void testBlendUniform_data();
+    void testBlendUniform();
+};
+
+void TileKernelsTest::testCopy_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("offset");
+
+    // Widths around the vector size cover the tail, offsets unaligned rows.
+    for (int width : {0, 1, 3, 4, 5, 7, 8, 15, 16, 17, 33}) {
+        for (int offset = 0; offset < 4; offset++) {
+            QTest::addRow("%d+%d", width, offset) << width << offset;
+        }
+    }
+}
+
+void TileKernelsTest::testCopy()
+{
+    QFETCH(int, width);
+    QFETCH(int, offset);
+
+    QRandomGenerator random(width * 4 + offset);
+    const auto src = randomPixels(random, width + 8);
+    auto dst = randomPixels(random, width + 8);
+
+    auto expected = dst;
+    std::copy(src.begin() + offset, src.begin() + offset + width, expected.begin() + offset);
+
+    TileKernels::copyPixels(dst.data() + offset, src.data() + offset, width);
+    QCOMPARE(dst, expected);
+}
+
+void TileKernelsTest::testBlend_data()
+{
+    testCopy_data();
+}
+
+void TileKernelsTest::testBlend()
+{
+    QFETCH(int, width);
+    QFETCH(int, offset);
+
+    QRandomGenerator random(width * 4 + offset);
+    const auto src = randomPixels(random, width + 8);
+    auto dst = randomPixels(random, width + 8);
+
+    // Pixels in front of and behind the row must stay untouched.
+    auto expected = dst;
+    for (int i = offset; i < offset + width; i++) {
+        expected[i] = referenceBlend(dst[i], src[i]);
+    }
+
+    TileKernels::blendPixels(dst.data() + offset, src.data() + offset, width);
+    QCOMPARE(dst, expected);
+}
+
+void TileKernelsTest::testBlendUniform_data()
+{
+    QTest::addColumn<uint32_t>("alpha");
+
+    QTest::newRow("opaque") << 0xffu;
+    QTest::newRow("transparent") << 0x0u;
+    QTest::newRow("translucent") << 0x80u;
+}
+
+void TileKernelsTest::testBlendUniform()
+{
+    // Rows of a single alpha take the shortcuts of the vector path.
+    QFETCH(uint32_t, alpha);
+
+    QRandomGenerator random(alpha);
+    for (int width : {4, 6, 16, 19}) {
+        std::vector<uint32_t> src(width);
+        for (auto &pixel : src) {
+            pixel = premultiplied(random, alpha);
+        }
+        auto dst = randomPixels(random, width);
+
+        auto expected = dst;
+        for (int i = 0; i < width; i++) {
+            expected[i] = referenceBlend(dst[i], src[i]);
+        }
+
+        TileKernels::blendPixels(dst.data(), src.data(), width);
+        QCOMPARE(dst, expected);
+    }
+}
+
+QTEST_GUILESS_MAIN(TileKernelsTest)
+#include "test_tile_kernels.moc"
@@ -0,0 +1,186 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../xwl/event_merge.h"
+
+#include <QTest>
+
+using namespace KWin;
+
+namespace
+{
+
+template<typename T>
+const xcb_generic_event_t *generic(const T &event)
+{
+    return reinterpret_cast<const xcb_generic_event_t*>(&event);
+}
+
+xcb_motion_notify_event_t motion(int16_t x, int16_t y)
+{
+    xcb_motion_notify_event_t event = {};
+    event.response_type = XCB_MOTION_NOTIFY;
+    event.root = 1;
+    event.event = 2;
+    event.child = 3;
+    event.root_x = event.event_x = x;
+    event.root_y = event.event_y = y;
+    event.same_screen = 1;
+    return event;
+}
+
+xcb_configure_notify_event_t configure(int16_t x, uint16_t width)
+{
+    xcb_configure_notify_event_t event = {};
+    event.response_type = XCB_CONFIGURE_NOTIFY;
+    event.event = 2;
+    event.window = 2;
+    event.x = x;
+    event.width = width;
+    event.height = 100;
+    return event;
+}
+
+xcb_property_notify_event_t property(xcb_atom_t atom, uint8_t state)
+{
+    xcb_property_notify_event_t event = {};
+    event.response_type = XCB_PROPERTY_NOTIFY;
+    event.window = 2;
+    event.atom = atom;
+    event.state = state;
+    return event;
+}
+
+}
+
+class XwlEventMergeTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testMotion();
+    void testConfigure();
+    void testProperty();
+    void testSendEvent();
+    void testDifferentType();
+    void testOtherEvents();
+};
+
+void XwlEventMergeTest::testMotion()
+{
+    const auto previous = motion(10, 10);
+
+    // Only the pointer position changes.
+    auto event = motion(20, 30);
+    event.time = 5;
+    QVERIFY(Xwl::supersedes(generic(event), generic(previous)));
+
+    // Button or modifier state changes are kept.
+    event = motion(20, 30);
+    event.state = XCB_KEY_BUT_MASK_BUTTON_1;
+    QVERIFY(!Xwl::supersedes(generic(event), generic(previous)));
+
+    event = motion(20, 30);
+    event.event = 4;
+    QVERIFY(!Xwl::supersedes(generic(event), generic(previous)));
+
+    event = motion(20, 30);
+    event.child = 4;
+    QVERIFY(!Xwl::supersedes(generic(event), generic(previous)));
+
+    event = motion(20, 30);
+    event.same_screen = 0;
+    QVERIFY(!Xwl::supersedes(generic(event), generic(previous)));
+}
+
+void XwlEventMergeTest::testConfigure()
+{
+    const auto previous = configure(0, 100);
+
+    const auto event = configure(10, 200);
+    QVERIFY(Xwl::supersedes(generic(event), generic(previous)));
+
+    // The parent is notified about its children too.
+    auto other = configure(10, 200);
+    other.window = 4;
+    QVERIFY(!Xwl::supersedes(generic(other), generic(previous)));
+
+    other = configure(10, 200);
+    other.event = 4;
+    QVERIFY(!Xwl::supersedes(generic(other), generic(previous)));
+}
+
+void XwlEventMergeTest::testProperty()
+{
+    const auto previous = property(10, XCB_PROPERTY_NEW_VALUE);
+
+    auto event = property(10, XCB_PROPERTY_NEW_VALUE);
+    event.time = 5;
+    QVERIFY(Xwl::supersedes(generic(event), generic(previous)));
+
+    // A deletion does not replace a change and the other way around.
+    event = property(10, XCB_PROPERTY_DELETE);
+    QVERIFY(!Xwl::supersedes(generic(event), generic(previous)));
+    QVERIFY(!Xwl::supersedes(generic(previous), generic(event)));
+
+    event = property(11, XCB_PROPERTY_NEW_VALUE);
+    QVERIFY(!Xwl::supersedes(generic(event), generic(previous)));
+
+    event = property(10, XCB_PROPERTY_NEW_VALUE);
+    event.window = 4;
+    QVERIFY(!Xwl::supersedes(generic(event), generic(previous)));
+}
+
+void XwlEventMergeTest::testSendEvent()
+{
+    // Events sent by clients are never merged, neither into each other nor into real ones.
+    auto previousMotion = motion(10, 10);
+    auto sentMotion = motion(20, 20);
+    sentMotion.response_type |= 0x80;
+    QVERIFY(!Xwl::supersedes(generic(sentMotion), generic(previousMotion)));
+    previousMotion.response_type |= 0x80;
+    QVERIFY(!Xwl::supersedes(generic(sentMotion), generic(previousMotion)));
+
+    auto previousConfigure = configure(0, 100);
+    auto sentConfigure = configure(10, 200);
+    sentConfigure.response_type |= 0x80;
+    QVERIFY(!Xwl::supersedes(generic(sentConfigure), generic(previousConfigure)));
+    QVERIFY(!Xwl::supersedes(generic(previousConfigure), generic(sentConfigure)));
+
+    auto previousProperty = property(10, XCB_PROPERTY_NEW_VALUE);
+    auto sentProperty = property(10, XCB_PROPERTY_NEW_VALUE);
+    sentProperty.response_type |= 0x80;
+    QVERIFY(!Xwl::supersedes(generic(sentProperty), generic(previousProperty)));
+    previousProperty.response_type |= 0x80;
+    QVERIFY(!Xwl::supersedes(generic(sentProperty), generic(previousProperty)));
+}
+
+void XwlEventMergeTest::testDifferentType()
+{
+    const auto motionEvent = motion(10, 10);
+    const auto configureEvent = configure(0, 100);
+    const auto propertyEvent = property(10, XCB_PROPERTY_NEW_VALUE);
+
+    QVERIFY(!Xwl::supersedes(generic(motionEvent), generic(configureEvent)));
+    QVERIFY(!Xwl::supersedes(generic(configureEvent), generic(propertyEvent)));
+    QVERIFY(!Xwl::supersedes(generic(propertyEvent), generic(motionEvent)));
+}
+
+void XwlEventMergeTest::testOtherEvents()
+{
+    // Only the notifications above are merged, for example no two identical button presses.
+    xcb_button_press_event_t press = {};
+    press.response_type = XCB_BUTTON_PRESS;
+    press.event = 2;
+    press.detail = 1;
+    QVERIFY(!Xwl::supersedes(generic(press), generic(press)));
+
+    xcb_map_notify_event_t map = {};
+    map.response_type = XCB_MAP_NOTIFY;
+    map.window = 2;
+    QVERIFY(!Xwl::supersedes(generic(map), generic(map)));
+}
+
+QTEST_GUILESS_MAIN(XwlEventMergeTest)
+#include "test_xwl_event_merge.moc"
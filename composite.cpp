@@ -26,7 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "effects.h"
 #include "internal_client.h"
 #include "overlaywindow.h"
-#include "perf/ftrace.h"
+#include "perf/trace.h"
 #include "platform.h"
 #include "presentation.h"
 #include "scene.h"
@@ -43,9 +43,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "win/net.h"
 #include "win/remnant.h"
 #include "win/scene.h"
-#include "win/transient.h"
-
-#include <kwingltexture.h>
 
 #include <Wrapland/Server/surface.h>
 
@@ -585,6 +582,12 @@ void Compositor::bufferSwapComplete(bool present)
     setCompositeTimer();
 }
 
+bool Compositor::is_frame_scheduled(AbstractWaylandOutput* output) const
+{
+    Q_UNUSED(output)
+    return false;
+}
+
 void WaylandCompositor::addRepaint(QRegion const& region)
 {
     if (!isActive()) {
@@ -661,19 +664,8 @@ bool Compositor::prepare_composition(QRegion& repaints, std::deque<Toplevel*>& w
 
     // Get the replies
     for (auto win : damaged) {
-        // Discard the cached lanczos texture
-        if (win->transient()->annexed) {
-            win = win::lead_of_annexed_transient(win);
-        }
-        if (win->effectWindow()) {
-            const QVariant texture = win->effectWindow()->data(LanczosCacheRole);
-            if (texture.isValid()) {
-                delete static_cast<GLTexture *>(texture.value<void*>());
-                win->effectWindow()->setData(LanczosCacheRole, QVariant());
-            }
-        }
-
         win->getDamageRegionReply();
+        static_cast<EffectsHandlerImpl*>(effects)->addLanczosDamage(win);
     }
 
     if (auto const& wins = workspace()->windows();
@@ -752,7 +744,7 @@ void Compositor::setCompositeTimer()
 
     // In milliseconds.
     const uint waitTime = m_delay / 1000 / 1000;
-    Perf::Ftrace::mark(QStringLiteral("timer ") + QString::number(waitTime));
+    Perf::Trace::instant(Perf::Trace::event::paint_timer, 0, waitTime);
 
     // Force 4fps minimum:
     compositeTimer.start(qMin(waitTime, 250u), this);
@@ -825,6 +817,15 @@ void WaylandCompositor::schedule_repaint(Toplevel* window)
     }
 }
 
+bool WaylandCompositor::is_frame_scheduled(AbstractWaylandOutput* output) const
+{
+    auto it = outputs.find(output);
+    if (it == outputs.end()) {
+        return false;
+    }
+    return it->second->frame_scheduled();
+}
+
 void WaylandCompositor::toggleCompositing()
 {
     // For the shortcut. Not possible on Wayland because we always composite.
@@ -969,7 +970,7 @@ std::deque<Toplevel*> X11Compositor::performCompositing()
         return std::deque<Toplevel*>();
     }
 
-    Perf::Ftrace::begin(QStringLiteral("Paint"), ++s_msc);
+    Perf::Trace::begin(Perf::Trace::event::paint, 0, ++s_msc);
     create_opengl_safepoint(OpenGLSafePoint::PreFrame);
 
     auto now_ns = std::chrono::steady_clock::now().time_since_epoch();
@@ -982,7 +983,7 @@ std::deque<Toplevel*> X11Compositor::performCompositing()
     create_opengl_safepoint(OpenGLSafePoint::PostFrame);
     retard_next_composition();
 
-    Perf::Ftrace::end(QStringLiteral("Paint"), s_msc);
+    Perf::Trace::end(Perf::Trace::event::paint, 0, s_msc);
 
     return windows;
 }
@@ -90,6 +90,12 @@ public:
      */
     virtual void bufferSwapComplete(bool present = true);
 
+    /**
+     * Whether a frame is about to be presented on @p output, i.e. a frame waits for its buffer
+     * swap or the next paint of the output is scheduled.
+     */
+    virtual bool is_frame_scheduled(AbstractWaylandOutput* output) const;
+
     /**
      * Toggles compositing, that is if the Compositor is suspended it will be resumed
      * and if the Compositor is active it will be suspended.
@@ -206,6 +212,7 @@ public:
     static WaylandCompositor *create(QObject *parent = nullptr);
 
     void schedule_repaint(Toplevel* window) override;
+    bool is_frame_scheduled(AbstractWaylandOutput* output) const override;
 
     void swapped(AbstractWaylandOutput* output);
     void swapped(AbstractWaylandOutput* output, unsigned int sec, unsigned int usec);
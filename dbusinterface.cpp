@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "debug_console.h"
 #include "main.h"
 #include "perf/ftrace.h"
+#include "perf/trace.h"
 #include "placement.h"
 #include "platform.h"
 #include "kwinadaptor.h"
@@ -45,6 +46,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Qt
 #include <QOpenGLContext>
 #include <QDBusServiceWatcher>
+#include <QFile>
 
 namespace KWin
 {
@@ -214,6 +216,39 @@ void DBusInterface::enableFtrace(bool enable)
 #endif
 }
 
+void DBusInterface::enableTracing(bool enable)
+{
+#if HAVE_PERF
+    Perf::Trace::set_recording(enable);
+#else
+    Q_UNUSED(enable)
+    const QString name = QStringLiteral("org.kde.kwin.enableTracing");
+    const QString msg = QStringLiteral("KWin built without tracing capability");
+    QDBusConnection::sessionBus().send(message().createErrorReply(name, msg));
+#endif
+}
+
+void DBusInterface::saveTrace(const QString &path)
+{
+    const QString name = QStringLiteral("org.kde.kwin.saveTrace");
+#if HAVE_PERF
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        const QString msg = QStringLiteral("Could not open trace file: ") + file.errorString();
+        QDBusConnection::sessionBus().send(message().createErrorReply(name, msg));
+        return;
+    }
+    if (!Perf::Trace::export_chrome_json(&file)) {
+        const QString msg = QStringLiteral("Could not write trace file: ") + file.errorString();
+        QDBusConnection::sessionBus().send(message().createErrorReply(name, msg));
+    }
+#else
+    Q_UNUSED(path)
+    const QString msg = QStringLiteral("KWin built without tracing capability");
+    QDBusConnection::sessionBus().send(message().createErrorReply(name, msg));
+#endif
+}
+
 namespace {
 QVariantMap clientToVariantMap(Toplevel const* c)
 {
@@ -342,6 +377,14 @@ bool CompositorDBusInterface::platformRequiresCompositing() const
     return kwinApp()->platform()->requiresCompositing();
 }
 
+qlonglong CompositorDBusInterface::gpuFrameTime() const
+{
+    if (!m_compositor->scene()) {
+        return 0;
+    }
+    return m_compositor->scene()->gpuPaintDuration();
+}
+
 void CompositorDBusInterface::resume()
 {
     if (kwinApp()->operationMode() == Application::OperationModeX11) {
@@ -69,6 +69,8 @@ public Q_SLOTS: // METHODS
     Q_NOREPLY void unclutterDesktop();
     Q_NOREPLY void showDebugConsole();
     void enableFtrace(bool enable);
+    void enableTracing(bool enable);
+    void saveTrace(const QString &path);
 
     QVariantMap queryWindowInfo();
     QVariantMap getWindowInfo(const QString &uuid);
@@ -124,6 +126,10 @@ class CompositorDBusInterface : public QObject
      */
     Q_PROPERTY(QStringList supportedOpenGLPlatformInterfaces READ supportedOpenGLPlatformInterfaces)
     Q_PROPERTY(bool platformRequiresCompositing READ platformRequiresCompositing)
+    /**
+     * @brief GPU execution time in nanoseconds of the last finished frame. 0 if not measured.
+     */
+    Q_PROPERTY(qlonglong gpuFrameTime READ gpuFrameTime)
 public:
     explicit CompositorDBusInterface(Compositor *parent);
     ~CompositorDBusInterface() override = default;
@@ -135,6 +141,7 @@ public:
     QString compositingType() const;
     QStringList supportedOpenGLPlatformInterfaces() const;
     bool platformRequiresCompositing() const;
+    qlonglong gpuFrameTime() const;
 
 public Q_SLOTS:
     /**
@@ -47,6 +47,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "kwineffectquickview.h"
 
 #include "win/control.h"
+#include "win/geo.h"
 #include "win/meta.h"
 #include "win/remnant.h"
 #include "win/screen.h"
@@ -146,7 +147,7 @@ EffectsHandlerImpl::EffectsHandlerImpl(Compositor *compositor, Scene *scene)
     QDBusConnection dbus = QDBusConnection::sessionBus();
     dbus.registerObject(QStringLiteral("/Effects"), this);
     // init is important, otherwise causes crashes when quads are build before the first painting pass start
-    m_currentBuildQuadsIterator = m_activeEffects.constEnd();
+    m_buildQuadsChain.current = m_buildQuadsChain.effects.constEnd();
 
     Workspace *ws = Workspace::self();
     VirtualDesktopManager *vds = VirtualDesktopManager::self();
@@ -416,18 +417,20 @@ void EffectsHandlerImpl::reconfigure()
 // the idea is that effects call this function again which calls the next one
 void EffectsHandlerImpl::prePaintScreen(ScreenPrePaintData& data, std::chrono::milliseconds presentTime)
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->prePaintScreen(data, presentTime);
-        --m_currentPaintScreenIterator;
+    auto& chain = m_prePaintScreenChain;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->prePaintScreen(data, presentTime);
+        --chain.current;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::paintScreen(int mask, const QRegion &region, ScreenPaintData& data)
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->paintScreen(mask, region, data);
-        --m_currentPaintScreenIterator;
+    auto& chain = m_paintScreenChain;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->paintScreen(mask, region, data);
+        --chain.current;
     } else
         m_scene->finalPaintScreen(mask, region, data);
 }
@@ -440,46 +443,50 @@ void EffectsHandlerImpl::paintDesktop(int desktop, int mask, QRegion region, Scr
     m_currentRenderedDesktop = desktop;
     m_desktopRendering = true;
     // save the paint screen iterator
-    EffectsIterator savedIterator = m_currentPaintScreenIterator;
-    m_currentPaintScreenIterator = m_activeEffects.constBegin();
+    EffectsIterator savedIterator = m_paintScreenChain.current;
+    m_paintScreenChain.current = m_paintScreenChain.effects.constBegin();
     effects->paintScreen(mask, region, data);
     // restore the saved iterator
-    m_currentPaintScreenIterator = savedIterator;
+    m_paintScreenChain.current = savedIterator;
     m_desktopRendering = false;
 }
 
 void EffectsHandlerImpl::postPaintScreen()
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->postPaintScreen();
-        --m_currentPaintScreenIterator;
+    auto& chain = m_postPaintScreenChain;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->postPaintScreen();
+        --chain.current;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, std::chrono::milliseconds presentTime)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, presentTime);
-        --m_currentPaintWindowIterator;
+    auto& chain = m_prePaintWindowChain;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->prePaintWindow(w, data, presentTime);
+        --chain.current;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::paintWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->paintWindow(w, mask, region, data);
-        --m_currentPaintWindowIterator;
+    auto& chain = m_paintWindowChain;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->paintWindow(w, mask, region, data);
+        --chain.current;
     } else
         m_scene->finalPaintWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
 }
 
 void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, const QRegion &region, double opacity, double frameOpacity)
 {
-    if (m_currentPaintEffectFrameIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintEffectFrameIterator++)->paintEffectFrame(frame, region, opacity, frameOpacity);
-        --m_currentPaintEffectFrameIterator;
+    auto& chain = m_paintEffectFrameChain;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->paintEffectFrame(frame, region, opacity, frameOpacity);
+        --chain.current;
     } else {
         const EffectFrameImpl* frameImpl = static_cast<const EffectFrameImpl*>(frame);
         frameImpl->finalRender(region, opacity, frameOpacity);
@@ -488,9 +495,10 @@ void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, const QRegion &reg
 
 void EffectsHandlerImpl::postPaintWindow(EffectWindow* w)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->postPaintWindow(w);
-        --m_currentPaintWindowIterator;
+    auto& chain = m_postPaintWindowChain;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->postPaintWindow(w);
+        --chain.current;
     }
     // no special final code
 }
@@ -505,9 +513,10 @@ Effect *EffectsHandlerImpl::provides(Effect::Feature ef)
 
 void EffectsHandlerImpl::drawWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
-    if (m_currentDrawWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentDrawWindowIterator++)->drawWindow(w, mask, region, data);
-        --m_currentDrawWindowIterator;
+    auto& chain = m_drawWindowChain;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->drawWindow(w, mask, region, data);
+        --chain.current;
     } else
         m_scene->finalDrawWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
 }
@@ -515,15 +524,16 @@ void EffectsHandlerImpl::drawWindow(EffectWindow* w, int mask, const QRegion &re
 void EffectsHandlerImpl::buildQuads(EffectWindow* w, WindowQuadList& quadList)
 {
     static bool initIterator = true;
+    auto& chain = m_buildQuadsChain;
     if (initIterator) {
-        m_currentBuildQuadsIterator = m_activeEffects.constBegin();
+        chain.current = chain.effects.constBegin();
         initIterator = false;
     }
-    if (m_currentBuildQuadsIterator != m_activeEffects.constEnd()) {
-        (*m_currentBuildQuadsIterator++)->buildQuads(w, quadList);
-        --m_currentBuildQuadsIterator;
+    if (chain.current != chain.effects.constEnd()) {
+        (*chain.current++)->buildQuads(w, quadList);
+        --chain.current;
     }
-    if (m_currentBuildQuadsIterator == m_activeEffects.constBegin())
+    if (chain.current == chain.effects.constBegin())
         initIterator = true;
 }
 
@@ -545,17 +555,55 @@ bool EffectsHandlerImpl::decorationSupportsBlurBehind() const
 // start another painting pass
 void EffectsHandlerImpl::startPaint()
 {
-    m_activeEffects.clear();
-    m_activeEffects.reserve(loaded_effects.count());
+    EffectsList activeEffects;
+    activeEffects.reserve(loaded_effects.count());
     for(QVector< KWin::EffectPair >::const_iterator it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
         if (it->second->isActive()) {
-            m_activeEffects << it->second;
+            activeEffects << it->second;
         }
     }
-    m_currentDrawWindowIterator = m_activeEffects.constBegin();
-    m_currentPaintWindowIterator = m_activeEffects.constBegin();
-    m_currentPaintScreenIterator = m_activeEffects.constBegin();
-    m_currentPaintEffectFrameIterator = m_activeEffects.constBegin();
+
+    // The chains only change with the set of active effects, which is the same most frames.
+    if (activeEffects != m_activeEffects) {
+        m_activeEffects = activeEffects;
+        rebuildEffectChains();
+    }
+
+    for (auto chain : {&m_prePaintScreenChain, &m_paintScreenChain, &m_postPaintScreenChain,
+                       &m_prePaintWindowChain, &m_paintWindowChain, &m_postPaintWindowChain,
+                       &m_drawWindowChain, &m_paintEffectFrameChain}) {
+        chain->current = chain->effects.constBegin();
+    }
+}
+
+void EffectsHandlerImpl::rebuildEffectChains()
+{
+    const std::initializer_list<std::pair<EffectChain*, Effect::PaintHook>> chains = {
+        {&m_prePaintScreenChain, Effect::PrePaintScreenHook},
+        {&m_paintScreenChain, Effect::PaintScreenHook},
+        {&m_postPaintScreenChain, Effect::PostPaintScreenHook},
+        {&m_prePaintWindowChain, Effect::PrePaintWindowHook},
+        {&m_paintWindowChain, Effect::PaintWindowHook},
+        {&m_postPaintWindowChain, Effect::PostPaintWindowHook},
+        {&m_drawWindowChain, Effect::DrawWindowHook},
+        {&m_buildQuadsChain, Effect::BuildQuadsHook},
+        {&m_paintEffectFrameChain, Effect::PaintEffectFrameHook},
+    };
+
+    for (auto const& entry : chains) {
+        entry.first->effects.clear();
+    }
+    for (auto effect : qAsConst(m_activeEffects)) {
+        const auto hooks = effect->paintHooks();
+        for (auto const& [chain, hook] : chains) {
+            if (hooks.testFlag(hook)) {
+                chain->effects << effect;
+            }
+        }
+    }
+
+    // Quads might get built outside of a paint pass.
+    m_buildQuadsChain.current = m_buildQuadsChain.effects.constBegin();
 }
 
 void EffectsHandlerImpl::slotClientMaximized(Toplevel* window, win::maximize_mode maxMode)
@@ -1153,7 +1201,7 @@ EffectWindow *EffectsHandlerImpl::findWindow(const QUuid &id) const
 
 EffectWindowList EffectsHandlerImpl::stackingOrder() const
 {
-    auto list = Workspace::self()->xStackingOrder();
+    auto const& list = Workspace::self()->xStackingOrder();
     EffectWindowList ret;
     for (auto t : list) {
         if (EffectWindow *w = effectWindow(t))
@@ -1555,6 +1603,7 @@ void EffectsHandlerImpl::effectsChanged()
 {
     loaded_effects.clear();
     m_activeEffects.clear(); // it's possible to have a reconfigure and a quad rebuild between two paint cycles - bug #308201
+    rebuildEffectChains();
 
     loaded_effects.reserve(effect_order.count());
     std::copy(effect_order.constBegin(), effect_order.constEnd(),
@@ -1575,6 +1624,39 @@ QStringList EffectsHandlerImpl::activeEffects() const
     return ret;
 }
 
+bool EffectsHandlerImpl::hasActiveEffects() const
+{
+    return std::any_of(loaded_effects.constBegin(), loaded_effects.constEnd(),
+                       [](const EffectPair &effect) { return effect.second->isActive(); });
+}
+
+bool EffectsHandlerImpl::blocksDirectScanout() const
+{
+    return std::any_of(loaded_effects.constBegin(), loaded_effects.constEnd(),
+                       [](const EffectPair &effect) {
+                           return effect.second->isActive() && effect.second->blocksDirectScanout();
+                       });
+}
+
+void EffectsHandlerImpl::addLanczosDamage(Toplevel *window)
+{
+    auto lead = window;
+    if (window->transient()->annexed) {
+        lead = win::lead_of_annexed_transient(window);
+    }
+    if (!lead->effectWindow()) {
+        return;
+    }
+    auto cache = m_lanczosCache.get(lead->effectWindow());
+    if (!cache) {
+        return;
+    }
+
+    // The damage is relative to the render geometry of the window.
+    auto const offset = win::render_geometry(window).topLeft() - lead->pos();
+    cache->damage += window->damage().translated(offset);
+}
+
 Wrapland::Server::Display *EffectsHandlerImpl::waylandDisplay() const
 {
     if (waylandServer()) {
@@ -1851,15 +1933,6 @@ EffectWindowImpl::EffectWindowImpl(Toplevel *toplevel)
     x11Client = qobject_cast<KWin::win::x11::window*>(toplevel) != nullptr || toplevel->xcb_window();
 }
 
-EffectWindowImpl::~EffectWindowImpl()
-{
-    QVariant cachedTextureVariant = data(LanczosCacheRole);
-    if (cachedTextureVariant.isValid()) {
-        GLTexture *cachedTexture = static_cast< GLTexture*>(cachedTextureVariant.value<void*>());
-        delete cachedTexture;
-    }
-}
-
 bool EffectWindowImpl::isPaintingEnabled()
 {
     return sceneWindow()->isPaintingEnabled();
@@ -57,6 +57,7 @@ class WindowThumbnailItem;
 class Compositor;
 class Deleted;
 class EffectLoader;
+class GLTexture;
 class Group;
 class Toplevel;
 class WindowPropertyNotifyX11Filter;
@@ -66,6 +67,15 @@ namespace win::x11
 class window;
 }
 
+/**
+ * Downscaled texture of a window painted with the lanczos filter.
+ */
+struct LanczosCache {
+    std::unique_ptr<GLTexture> texture;
+    // Damage of the window since the texture was filtered, relative to its frame geometry.
+    QRegion damage;
+};
+
 class KWIN_EXPORT EffectsHandlerImpl : public EffectsHandler
 {
     Q_OBJECT
@@ -219,6 +229,23 @@ public:
 
     QList<EffectWindow*> elevatedWindows() const;
     QStringList activeEffects() const;
+    bool hasActiveEffects() const;
+    /**
+     * Whether an active effect prevents presenting a window without compositing.
+     * @see Effect::blocksDirectScanout
+     */
+    bool blocksDirectScanout() const;
+
+    /**
+     * Offscreen textures of windows painted with the lanczos filter.
+     */
+    EffectWindowSlot<LanczosCache> &lanczosCache() {
+        return m_lanczosCache;
+    }
+    /**
+     * Adds the current damage of @p window to the lanczos cache of the window it is painted with.
+     */
+    void addLanczosDamage(Toplevel *window);
 
     /**
      * @returns Whether we are currently in a desktop rendering process triggered by paintDesktop hook
@@ -360,12 +387,28 @@ private:
 
     typedef QVector< Effect*> EffectsList;
     typedef EffectsList::const_iterator EffectsIterator;
+
+    /**
+     * The active effects that implement one method of the paint chain and the position of the
+     * effect currently called for it.
+     */
+    struct EffectChain {
+        EffectsList effects;
+        EffectsIterator current;
+    };
+    void rebuildEffectChains();
+
     EffectsList m_activeEffects;
-    EffectsIterator m_currentDrawWindowIterator;
-    EffectsIterator m_currentPaintWindowIterator;
-    EffectsIterator m_currentPaintEffectFrameIterator;
-    EffectsIterator m_currentPaintScreenIterator;
-    EffectsIterator m_currentBuildQuadsIterator;
+    EffectChain m_prePaintScreenChain;
+    EffectChain m_paintScreenChain;
+    EffectChain m_postPaintScreenChain;
+    EffectChain m_prePaintWindowChain;
+    EffectChain m_paintWindowChain;
+    EffectChain m_postPaintWindowChain;
+    EffectChain m_drawWindowChain;
+    EffectChain m_buildQuadsChain;
+    EffectChain m_paintEffectFrameChain;
+    EffectWindowSlot<LanczosCache> m_lanczosCache;
     typedef QHash< QByteArray, QList< Effect*> > PropertyEffectMap;
     PropertyEffectMap m_propertiesForEffects;
     QHash<QByteArray, qulonglong> m_managedProperties;
@@ -402,7 +445,6 @@ class KWIN_EXPORT EffectWindowImpl : public EffectWindow
     Q_OBJECT
 public:
     explicit EffectWindowImpl(Toplevel *toplevel);
-    ~EffectWindowImpl() override;
 
     void enablePainting(int reason) override;
     void disablePainting(int reason) override;
@@ -64,6 +64,12 @@ public:
     int requestedEffectChainPosition() const override {
         return 76;
     }
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PrePaintWindowHook | DrawWindowHook | PaintEffectFrameHook;
+    }
+    bool blocksDirectScanout() const override {
+        return false;
+    }
 
     bool eventFilter(QObject *watched, QEvent *event) override;
 
@@ -67,6 +67,12 @@ public:
     int requestedEffectChainPosition() const override {
         return 75;
     }
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PrePaintWindowHook | DrawWindowHook | PaintEffectFrameHook;
+    }
+    bool blocksDirectScanout() const override {
+        return false;
+    }
 
     bool eventFilter(QObject *watched, QEvent *event) override;
 
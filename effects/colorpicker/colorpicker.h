@@ -44,6 +44,9 @@ public:
     int requestedEffectChainPosition() const override {
         return 50;
     }
+    PaintHooks paintHooks() const override {
+        return PaintScreenHook | PostPaintScreenHook;
+    }
 
     static bool supported();
 
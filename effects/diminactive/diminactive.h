@@ -51,6 +51,7 @@ public:
 
     int requestedEffectChainPosition() const override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override;
 
     int dimStrength() const;
     bool dimPanels() const;
@@ -106,6 +107,11 @@ inline bool DimInactiveEffect::isActive() const
     return true;
 }
 
+inline Effect::PaintHooks DimInactiveEffect::paintHooks() const
+{
+    return PrePaintScreenHook | PaintWindowHook | PostPaintScreenHook;
+}
+
 inline int DimInactiveEffect::dimStrength() const
 {
     return qRound(m_dimStrength * 100.0);
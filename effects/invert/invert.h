@@ -46,6 +46,7 @@ public:
     bool provides(Feature) override;
 
     int requestedEffectChainPosition() const override;
+    PaintHooks paintHooks() const override;
 
     static bool supported();
 
@@ -70,6 +71,11 @@ inline int InvertEffect::requestedEffectChainPosition() const
     return 99;
 }
 
+inline Effect::PaintHooks InvertEffect::paintHooks() const
+{
+    return DrawWindowHook | PaintEffectFrameHook;
+}
+
 } // namespace
 
 #endif
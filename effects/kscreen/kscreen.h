@@ -44,6 +44,9 @@ public:
     int requestedEffectChainPosition() const override {
         return 99;
     }
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PostPaintScreenHook | PrePaintWindowHook | PaintWindowHook;
+    }
 
 private Q_SLOTS:
     void propertyNotify(KWin::EffectWindow *window, long atom);
@@ -43,6 +43,9 @@ public:
     int requestedEffectChainPosition() const override {
         return 90;
     }
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PaintScreenHook;
+    }
 
 private Q_SLOTS:
     void edgeApproaching(ElectricBorder border, qreal factor, const QRect &geometry);
@@ -47,6 +47,9 @@ public:
     int requestedEffectChainPosition() const override {
         return 40;
     }
+    PaintHooks paintHooks() const override {
+        return PrePaintWindowHook | PaintWindowHook | PostPaintWindowHook;
+    }
 
     static bool supported();
 
@@ -48,6 +48,9 @@ public:
     int requestedEffectChainPosition() const override {
         return 90;
     }
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PaintScreenHook | PostPaintScreenHook;
+    }
 
     int type() const {
         return int(m_type);
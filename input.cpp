@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "globalshortcuts.h"
 #include "input_event.h"
 #include "input_event_spy.h"
+#include "input_hit_index.h"
 #include "keyboard_input.h"
 #include "seat/session.h"
 #include "main.h"
@@ -2294,14 +2295,8 @@ Toplevel *InputRedirection::findToplevel(const QPoint &pos)
         if (effects && static_cast<EffectsHandlerImpl*>(effects)->isMouseInterception()) {
             return nullptr;
         }
-        auto const& unmanaged = Workspace::self()->unmanagedList();
-        for (auto const& u : unmanaged) {
-            if (win::input_geometry(u).contains(pos) && acceptsInput(u, pos)) {
-                return u;
-            }
-        }
     }
-    return findManagedToplevel(pos);
+    return findToplevel(pos, !isScreenLocked);
 }
 
 Toplevel *InputRedirection::findManagedToplevel(const QPoint &pos)
@@ -2309,41 +2304,47 @@ Toplevel *InputRedirection::findManagedToplevel(const QPoint &pos)
     if (!Workspace::self()) {
         return nullptr;
     }
-    const bool isScreenLocked = waylandServer() && waylandServer()->isScreenLocked();
-    auto const& stacking = Workspace::self()->stackingOrder();
-    if (stacking.empty()) {
-        return nullptr;
+    return findToplevel(pos, false);
+}
+
+Toplevel *InputRedirection::findToplevel(const QPoint &pos, bool withUnmanaged)
+{
+    if (!m_hitIndex) {
+        m_hitIndex = std::make_unique<InputHitIndex>();
     }
-    auto it = stacking.end();
-    do {
-        --it;
-        auto window = *it;
+
+    const bool isScreenLocked = waylandServer() && waylandServer()->isScreenLocked();
+
+    // The index only provides candidates by their cached input geometry. All other state is
+    // checked here.
+    return m_hitIndex->find(pos, [&](Toplevel *window, bool unmanaged) {
+        if (unmanaged) {
+            return withUnmanaged && win::input_geometry(window).contains(pos)
+                && acceptsInput(window, pos);
+        }
         if (window->isDeleted()) {
             // a deleted window doesn't get mouse events
-            continue;
+            return false;
         }
         if (window->control) {
             if (!window->isOnCurrentActivity() || !window->isOnCurrentDesktop() ||
                     window->control->minimized()) {
-                continue;
+                return false;
             }
         }
         if (window->isHiddenInternal()) {
-            continue;
+            return false;
         }
         if (!window->readyForPainting()) {
-            continue;
+            return false;
         }
         if (isScreenLocked) {
             if (!window->isLockScreen() && !window->isInputMethod()) {
-                continue;
+                return false;
             }
         }
-        if (win::input_geometry(window).contains(pos) && acceptsInput(window, pos)) {
-            return window;
-        }
-    } while (it != stacking.begin());
-    return nullptr;
+        return win::input_geometry(window).contains(pos) && acceptsInput(window, pos);
+    });
 }
 
 Qt::KeyboardModifiers InputRedirection::keyboardModifiers() const
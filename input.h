@@ -33,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSet>
 
 #include <functional>
+#include <memory>
 
 class KGlobalAccelInterface;
 class QKeySequence;
@@ -43,6 +44,7 @@ class QWheelEvent;
 namespace KWin
 {
 class GlobalShortcutsManager;
+class InputHitIndex;
 class Toplevel;
 class InputEventFilter;
 class InputEventSpy;
@@ -297,6 +299,7 @@ private:
     void reconfigure();
     void setupInputFilters();
     void installInputEventFilter(InputEventFilter *filter);
+    Toplevel *findToplevel(const QPoint &pos, bool withUnmanaged);
     KeyboardInputRedirection *m_keyboard;
     PointerInputRedirection *m_pointer;
     TabletInputRedirection *m_tablet;
@@ -308,6 +311,8 @@ private:
 
     WindowSelectorFilter *m_windowSelector = nullptr;
 
+    std::unique_ptr<InputHitIndex> m_hitIndex;
+
     QVector<InputEventFilter*> m_filters;
     QVector<InputEventSpy*> m_spies;
     KConfigWatcher::Ptr m_inputConfigWatcher;
@@ -0,0 +1,166 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "input_hit_index.h"
+
+#include "screens.h"
+#include "toplevel.h"
+#include "workspace.h"
+
+#include "win/deco.h"
+#include "win/geo.h"
+
+#include <KDecoration2/Decoration>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+InputHitIndex::InputHitIndex()
+{
+    auto ws = workspace();
+    connect(ws, &Workspace::stackingOrderChanged, this, &InputHitIndex::invalidate);
+    connect(ws, &Workspace::unmanagedAdded, this, &InputHitIndex::invalidate);
+    connect(ws, &Workspace::unmanagedRemoved, this, &InputHitIndex::invalidate);
+    connect(ws, &Workspace::clientRemoved, this, &InputHitIndex::invalidate);
+    connect(ws, &Workspace::deletedRemoved, this, &InputHitIndex::invalidate);
+    // Decoration settings change the resize-only borders and may recreate all decorations.
+    connect(ws, &Workspace::configChanged, this, &InputHitIndex::invalidate);
+    connect(screens(), &Screens::changed, this, &InputHitIndex::invalidate);
+}
+
+InputHitIndex::~InputHitIndex() = default;
+
+std::vector<uint32_t> const& InputHitIndex::partition_at(QPoint const& pos)
+{
+    if (m_dirty) {
+        rebuild();
+    }
+    for (auto const& partition : m_partitions) {
+        if (partition.geometry.contains(pos)) {
+            return partition.entries;
+        }
+    }
+    return m_all;
+}
+
+void InputHitIndex::invalidate()
+{
+    if (m_dirty) {
+        return;
+    }
+    m_dirty = true;
+
+    // Entries may dangle until the next rebuild. Don't track them any longer.
+    for (auto const& connection : m_window_connections) {
+        disconnect(connection);
+    }
+    m_window_connections.clear();
+}
+
+void InputHitIndex::rebuild()
+{
+    m_dirty = false;
+
+    m_entries.clear();
+    m_indices.clear();
+    m_all.clear();
+    m_partitions.clear();
+
+    for (auto const& connection : m_window_connections) {
+        disconnect(connection);
+    }
+    m_window_connections.clear();
+
+    auto add = [this](Toplevel* window, bool unmanaged) {
+        if (m_indices.count(window)) {
+            return;
+        }
+        auto deco = win::decoration(window);
+        m_indices[window] = m_entries.size();
+        m_entries.push_back({window, win::input_geometry(window), unmanaged, deco});
+
+        m_window_connections.push_back(connect(window, &Toplevel::frame_geometry_changed, this,
+                                               [this, window] { update_window(window); }));
+        m_window_connections.push_back(
+            connect(window, &QObject::destroyed, this, &InputHitIndex::invalidate));
+
+        // The input geometry extends the frame by the resize-only borders of the decoration.
+        if (deco) {
+            m_window_connections.push_back(
+                connect(deco, &KDecoration2::Decoration::resizeOnlyBordersChanged, this,
+                        [this, window] { update_window(window); }));
+            // A replacing decoration is only found again on rebuild.
+            m_window_connections.push_back(
+                connect(deco, &QObject::destroyed, this, &InputHitIndex::invalidate));
+        }
+    };
+
+    auto const& stacking = workspace()->stackingOrder();
+    for (auto const& window : stacking) {
+        add(window, false);
+    }
+
+    // The first unmanaged window in the list takes precedence, so it goes on top.
+    auto const unmanaged = workspace()->unmanagedList();
+    for (auto it = unmanaged.crbegin(); it != unmanaged.crend(); ++it) {
+        add(*it, true);
+    }
+
+    auto const count = screens()->count();
+    m_partitions.resize(count);
+    for (int i = 0; i < count; i++) {
+        m_partitions[i].geometry = screens()->geometry(i);
+    }
+
+    m_all.reserve(m_entries.size());
+    for (uint32_t index = 0; index < m_entries.size(); index++) {
+        m_all.push_back(index);
+        auto const& geo = m_entries[index].geometry;
+        for (auto& partition : m_partitions) {
+            if (partition.geometry.intersects(geo)) {
+                partition.entries.push_back(index);
+            }
+        }
+    }
+}
+
+void InputHitIndex::update_window(Toplevel* window)
+{
+    if (m_dirty) {
+        return;
+    }
+
+    auto it = m_indices.find(window);
+    if (it == m_indices.end()) {
+        return;
+    }
+
+    auto const index = it->second;
+    auto& entry = m_entries[index];
+    if (entry.decoration != win::decoration(window)) {
+        // Decoration created or replaced, its signals must be connected.
+        invalidate();
+        return;
+    }
+    entry.geometry = win::input_geometry(window);
+
+    // Partitions are sorted, so membership changes are a binary search away.
+    for (auto& partition : m_partitions) {
+        auto& entries = partition.entries;
+        auto const pos = std::lower_bound(entries.begin(), entries.end(), index);
+        auto const contained = pos != entries.end() && *pos == index;
+        auto const intersects = partition.geometry.intersects(entry.geometry);
+
+        if (intersects && !contained) {
+            entries.insert(pos, index);
+        } else if (!intersects && contained) {
+            entries.erase(pos);
+        }
+    }
+}
+
+}
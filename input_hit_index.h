@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QObject>
+#include <QPoint>
+#include <QRect>
+
+#include <unordered_map>
+#include <vector>
+
+namespace KWin
+{
+class Toplevel;
+
+/**
+ * Spatial index over the input geometries of windows for hit-testing.
+ *
+ * Windows are partitioned by the outputs their input geometry intersects. Every partition lists
+ * its windows in stacking order, so a lookup only visits the windows of the output containing
+ * the position and only tests window state for windows whose input geometry contains it.
+ *
+ * Unmanaged windows are put on top of the managed ones, in the order of the unmanaged list.
+ *
+ * The index is rebuilt lazily when the stacking order, the set of unmanaged windows, the outputs
+ * or the decorations change. Geometry and resize-only border changes of single windows are
+ * applied in place.
+ */
+class KWIN_EXPORT InputHitIndex : public QObject
+{
+    Q_OBJECT
+public:
+    InputHitIndex();
+    ~InputHitIndex() override;
+
+    /**
+     * Walks the windows whose input geometry contains @p pos from top to bottom and returns the
+     * first one for which @p accept returns true. @p accept is called with the window and
+     * whether it is unmanaged.
+     */
+    template<typename Accept>
+    Toplevel* find(QPoint const& pos, Accept accept)
+    {
+        auto const& partition = partition_at(pos);
+        for (auto it = partition.crbegin(); it != partition.crend(); ++it) {
+            auto const& entry = m_entries[*it];
+            if (entry.geometry.contains(pos) && accept(entry.window, entry.unmanaged)) {
+                return entry.window;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    struct Entry {
+        Toplevel* window;
+        QRect geometry;
+        bool unmanaged;
+        // Tracked for its resize-only borders.
+        QObject* decoration;
+    };
+    struct Partition {
+        QRect geometry;
+        // Indices into m_entries, ascending in stacking order.
+        std::vector<uint32_t> entries;
+    };
+
+    std::vector<uint32_t> const& partition_at(QPoint const& pos);
+
+    void invalidate();
+    void rebuild();
+    void update_window(Toplevel* window);
+
+    std::vector<Entry> m_entries;
+    std::unordered_map<Toplevel*, uint32_t> m_indices;
+
+    std::vector<Partition> m_partitions;
+    // Fallback for positions outside of all outputs.
+    std::vector<uint32_t> m_all;
+
+    std::vector<QMetaObject::Connection> m_window_connections;
+    bool m_dirty{true};
+};
+
+}
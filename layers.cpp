@@ -824,6 +824,14 @@ std::deque<Toplevel*> const& Workspace::xStackingOrder() const
     return x_stacking;
 }
 
+uint64_t Workspace::xStackingGeneration() const
+{
+    if (m_xStackingDirty) {
+        const_cast<Workspace*>(this)->updateXStackingOrder();
+    }
+    return m_xStackingGeneration;
+}
+
 void Workspace::updateXStackingOrder()
 {
     // use our own stacking order, not the X one, as they may differ
@@ -858,6 +866,7 @@ void Workspace::updateXStackingOrder()
     }
 
     m_xStackingDirty = false;
+    m_xStackingGeneration++;
 }
 
 }
@@ -37,6 +37,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector2D>
 #include <QtMath>
 
+#include <vector>
+
 #include <ksharedconfig.h>
 #include <kconfiggroup.h>
 
@@ -672,6 +674,16 @@ int Effect::requestedEffectChainPosition() const
     return 0;
 }
 
+Effect::PaintHooks Effect::paintHooks() const
+{
+    return AllPaintHooks;
+}
+
+bool Effect::blocksDirectScanout() const
+{
+    return true;
+}
+
 xcb_connection_t *Effect::xcbConnection() const
 {
     return effects->xcbConnection();
@@ -778,23 +790,111 @@ class Q_DECL_HIDDEN EffectWindow::Private
 {
 public:
     Private(EffectWindow *q);
+    ~Private();
+
+    void resetSlot(int index);
+
+    struct SlotData {
+        void *data = nullptr;
+        void (*destroy)(void *) = nullptr;
+    };
 
     EffectWindow *q;
+    std::vector<SlotData> slots;
+};
+
+namespace
+{
+
+// Windows and slot indices are only touched from the compositing thread.
+struct SlotRegistry {
+    QSet<EffectWindow *> windows;
+    QVector<int> freeIndices;
+    int nextIndex = 0;
 };
 
+SlotRegistry &slotRegistry()
+{
+    static SlotRegistry registry;
+    return registry;
+}
+
+}
+
 EffectWindow::Private::Private(EffectWindow *q)
     : q(q)
 {
 }
 
+EffectWindow::Private::~Private()
+{
+    for (int i = 0; i < int(slots.size()); ++i) {
+        resetSlot(i);
+    }
+}
+
+void EffectWindow::Private::resetSlot(int index)
+{
+    if (index >= int(slots.size())) {
+        return;
+    }
+    auto &slot = slots[index];
+    if (slot.data) {
+        // Reset before destroying in case the destructor of the value accesses the slot.
+        const auto previous = slot;
+        slot = SlotData();
+        previous.destroy(previous.data);
+    }
+}
+
 EffectWindow::EffectWindow(QObject *parent)
     : QObject(parent)
     , d(new Private(this))
 {
+    slotRegistry().windows.insert(this);
 }
 
 EffectWindow::~EffectWindow()
 {
+    slotRegistry().windows.remove(this);
+}
+
+int EffectWindow::allocateSlot()
+{
+    auto &registry = slotRegistry();
+    if (!registry.freeIndices.isEmpty()) {
+        return registry.freeIndices.takeLast();
+    }
+    return registry.nextIndex++;
+}
+
+void EffectWindow::releaseSlot(int index)
+{
+    auto &registry = slotRegistry();
+    for (auto window : qAsConst(registry.windows)) {
+        window->d->resetSlot(index);
+    }
+    registry.freeIndices.append(index);
+}
+
+void *EffectWindow::slotData(int index) const
+{
+    if (index >= int(d->slots.size())) {
+        return nullptr;
+    }
+    return d->slots[index].data;
+}
+
+void EffectWindow::setSlotData(int index, void *data, void (*destroy)(void *))
+{
+    d->resetSlot(index);
+    if (!data) {
+        return;
+    }
+    if (index >= int(d->slots.size())) {
+        d->slots.resize(index + 1);
+    }
+    d->slots[index] = {data, destroy};
 }
 
 bool EffectWindow::isOnActivity(const QString &activity) const
@@ -1014,6 +1114,22 @@ WindowQuadList WindowQuadList::splitAtY(double y) const
     return ret;
 }
 
+// Upper bound of the number of quads created when splitting @p quads along a grid. Used to
+// reserve the list up front, since effects like wobbly windows create thousands of them.
+static int gridQuadCountBound(const WindowQuadList &quads, double xIncrement, double yIncrement)
+{
+    int count = 0;
+    for (const WindowQuad &quad : quads) {
+        if (quad.left() == quad.right() || quad.top() == quad.bottom()) {
+            count++;
+            continue;
+        }
+        count += (qCeil((quad.right() - quad.left()) / xIncrement) + 1)
+            * (qCeil((quad.bottom() - quad.top()) / yIncrement) + 1);
+    }
+    return count;
+}
+
 WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
 {
     if (empty())
@@ -1037,6 +1153,7 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
     }
 
     WindowQuadList ret;
+    ret.reserve(gridQuadCountBound(*this, maxQuadSize, maxQuadSize));
 
     for (const WindowQuad &quad : *this) {
         const double quadLeft   = quad.left();
@@ -1097,6 +1214,7 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
     double yIncrement = (bottom - top) / ySubdivisions;
 
     WindowQuadList ret;
+    ret.reserve(gridQuadCountBound(*this, xIncrement, yIncrement));
 
     for (const WindowQuad &quad : *this) {
         const double quadLeft   = quad.left();
@@ -1150,28 +1268,31 @@ void WindowQuadList::makeInterleavedArrays(unsigned int type, GLVertex2D *vertic
 
     Q_ASSERT(type == GL_QUADS || type == GL_TRIANGLES);
 
+#if defined(__SSE2__)
+    // A WindowVertex starts with position and texture coordinate laid out like a GLVertex2D.
+    // One multiply-add per vertex leaves the position as is and transforms the texture
+    // coordinate.
+    static_assert(sizeof(GLVertex2D) == 4 * sizeof(float));
+    const __m128 scale = _mm_setr_ps(1.0f, 1.0f, coeff.x(), coeff.y());
+    const __m128 translate = _mm_setr_ps(0.0f, 0.0f, offset.x(), offset.y());
+
+    auto transform = [&](const WindowVertex &wv) {
+        return _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&wv.px), scale), translate);
+    };
+#endif
+
     switch (type)
     {
     case GL_QUADS:
 #if defined(__SSE2__)
         if (!(intptr_t(vertex) & 0xf)) {
             for (const WindowQuad &quad : *this) {
-                alignas(16) GLVertex2D v[4];
+                float *dst = reinterpret_cast<float *>(vertex);
 
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
-
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-                }
-
-                const __m128i *srcP = reinterpret_cast<const __m128i *>(&v);
-                __m128i *dstP = reinterpret_cast<__m128i *>(vertex);
-
-                _mm_stream_si128(&dstP[0], _mm_load_si128(&srcP[0])); // Top-left
-                _mm_stream_si128(&dstP[1], _mm_load_si128(&srcP[1])); // Top-right
-                _mm_stream_si128(&dstP[2], _mm_load_si128(&srcP[2])); // Bottom-right
-                _mm_stream_si128(&dstP[3], _mm_load_si128(&srcP[3])); // Bottom-left
+                _mm_stream_ps(dst + 0, transform(quad[0])); // Top-left
+                _mm_stream_ps(dst + 4, transform(quad[1])); // Top-right
+                _mm_stream_ps(dst + 8, transform(quad[2])); // Bottom-right
+                _mm_stream_ps(dst + 12, transform(quad[3])); // Bottom-left
 
                 vertex += 4;
             }
@@ -1183,8 +1304,8 @@ void WindowQuadList::makeInterleavedArrays(unsigned int type, GLVertex2D *vertic
                     const WindowVertex &wv = quad[j];
 
                     GLVertex2D v;
-                    v.position = QVector2D(wv.x(), wv.y());
-                    v.texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
+                    v.position = QVector2D(wv.px, wv.py);
+                    v.texcoord = QVector2D(wv.tx, wv.ty) * coeff + offset;
 
                     *(vertex++) = v;
                 }
@@ -1196,33 +1317,22 @@ void WindowQuadList::makeInterleavedArrays(unsigned int type, GLVertex2D *vertic
 #if defined(__SSE2__)
         if (!(intptr_t(vertex) & 0xf)) {
             for (const WindowQuad &quad : *this) {
-                alignas(16) GLVertex2D v[4];
-
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
-
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-                }
-
-                const __m128i *srcP = reinterpret_cast<const __m128i *>(&v);
-                __m128i *dstP = reinterpret_cast<__m128i *>(vertex);
+                float *dst = reinterpret_cast<float *>(vertex);
 
-                __m128i src[4];
-                src[0] = _mm_load_si128(&srcP[0]); // Top-left
-                src[1] = _mm_load_si128(&srcP[1]); // Top-right
-                src[2] = _mm_load_si128(&srcP[2]); // Bottom-right
-                src[3] = _mm_load_si128(&srcP[3]); // Bottom-left
+                const __m128 topLeft = transform(quad[0]);
+                const __m128 topRight = transform(quad[1]);
+                const __m128 bottomRight = transform(quad[2]);
+                const __m128 bottomLeft = transform(quad[3]);
 
                 // First triangle
-                _mm_stream_si128(&dstP[0], src[1]); // Top-right
-                _mm_stream_si128(&dstP[1], src[0]); // Top-left
-                _mm_stream_si128(&dstP[2], src[3]); // Bottom-left
+                _mm_stream_ps(dst + 0, topRight);
+                _mm_stream_ps(dst + 4, topLeft);
+                _mm_stream_ps(dst + 8, bottomLeft);
 
                 // Second triangle
-                _mm_stream_si128(&dstP[3], src[3]); // Bottom-left
-                _mm_stream_si128(&dstP[4], src[2]); // Bottom-right
-                _mm_stream_si128(&dstP[5], src[1]); // Top-right
+                _mm_stream_ps(dst + 12, bottomLeft);
+                _mm_stream_ps(dst + 16, bottomRight);
+                _mm_stream_ps(dst + 20, topRight);
 
                 vertex += 6;
             }
@@ -1235,8 +1345,8 @@ void WindowQuadList::makeInterleavedArrays(unsigned int type, GLVertex2D *vertic
                 for (int j = 0; j < 4; j++) {
                     const WindowVertex &wv = quad[j];
 
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
+                    v[j].position = QVector2D(wv.px, wv.py);
+                    v[j].texcoord = QVector2D(wv.tx, wv.ty) * coeff + offset;
                 }
 
                 // First triangle
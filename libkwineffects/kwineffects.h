@@ -51,6 +51,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <climits>
 #include <functional>
+#include <memory>
 
 class KConfigGroup;
 class QFont;
@@ -188,7 +189,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 233
+#define KWIN_EFFECT_API_VERSION_MINOR 236
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -579,6 +580,50 @@ public:
      */
     virtual int requestedEffectChainPosition() const;
 
+    /**
+     * The methods of the paint chain an Effect can reimplement.
+     * @since 5.23
+     */
+    enum PaintHook {
+        PrePaintScreenHook = 1 << 0,
+        PaintScreenHook = 1 << 1,
+        PostPaintScreenHook = 1 << 2,
+        PrePaintWindowHook = 1 << 3,
+        PaintWindowHook = 1 << 4,
+        PostPaintWindowHook = 1 << 5,
+        DrawWindowHook = 1 << 6,
+        BuildQuadsHook = 1 << 7,
+        PaintEffectFrameHook = 1 << 8,
+        AllPaintHooks = (1 << 9) - 1
+    };
+    Q_DECLARE_FLAGS(PaintHooks, PaintHook)
+
+    /**
+     * Reimplement this method to declare which methods of the paint chain the Effect
+     * reimplements. While the Effect is active it is only called for the declared methods,
+     * for all others it is skipped when the chain is dispatched.
+     *
+     * The method is called whenever the set of active Effects changes. An Effect deriving from
+     * another Effect must include the hooks of its base class.
+     *
+     * The default implementation returns AllPaintHooks.
+     * @since 5.23
+     */
+    virtual PaintHooks paintHooks() const;
+
+    /**
+     * Reimplement this method to allow the top-most window of an output to be presented directly,
+     * without compositing, while the Effect is active. This is only the case if the window is
+     * opaque and covers the output completely.
+     *
+     * An Effect can return @c false if it changes nothing but how translucent windows or the
+     * content behind them are painted.
+     *
+     * The default implementation returns @c true.
+     * @since 5.23
+     */
+    virtual bool blocksDirectScanout() const;
+
 
     /**
      * A touch point was pressed.
@@ -1885,6 +1930,9 @@ public:
     virtual QRect geometry() const = 0;
 };
 
+template <typename T>
+class EffectWindowSlot;
+
 /**
  * @short Representation of a window used by/for Effect classes.
  *
@@ -2557,6 +2605,14 @@ public:
     virtual void unreferencePreviousWindowPixmap() = 0;
 
 private:
+    template <typename T>
+    friend class EffectWindowSlot;
+
+    static int allocateSlot();
+    static void releaseSlot(int index);
+    void *slotData(int index) const;
+    void setSlotData(int index, void *data, void (*destroy)(void *));
+
     class Private;
     QScopedPointer<Private> d;
 };
@@ -2568,6 +2624,83 @@ public:
     virtual EffectWindowList members() const = 0;
 };
 
+/**
+ * @short Typed per-window data of an Effect.
+ *
+ * In contrast to EffectWindow::data the value is accessed through an index without hashing and
+ * boxing into a QVariant. The slot owns the values it holds. A value is destroyed when it is
+ * replaced or reset, when its window is destroyed and at the latest when the slot is destroyed.
+ *
+ * Values are private to the slot, other Effects can not see them and no signal is emitted on
+ * changes. To share data between Effects use EffectWindow::setData.
+ *
+ * @code
+ * EffectWindowSlot<AnimationState> m_state;
+ *
+ * if (auto state = m_state.get(w)) {
+ *     state->progress += delta;
+ * } else {
+ *     m_state.emplace(w);
+ * }
+ * @endcode
+ * @since 5.23
+ */
+template <typename T>
+class EffectWindowSlot
+{
+public:
+    EffectWindowSlot()
+        : m_index(EffectWindow::allocateSlot())
+    {
+    }
+    ~EffectWindowSlot()
+    {
+        EffectWindow::releaseSlot(m_index);
+    }
+    EffectWindowSlot(const EffectWindowSlot &) = delete;
+    EffectWindowSlot &operator=(const EffectWindowSlot &) = delete;
+
+    /**
+     * @returns the value of @p w or @c null if none was set
+     */
+    T *get(const EffectWindow *w) const
+    {
+        return static_cast<T *>(w->slotData(m_index));
+    }
+
+    /**
+     * Sets the value of @p w, destroying any previous value.
+     */
+    T *set(EffectWindow *w, std::unique_ptr<T> value)
+    {
+        auto data = value.release();
+        w->setSlotData(m_index, data, &destroy);
+        return data;
+    }
+
+    template <typename... Args>
+    T &emplace(EffectWindow *w, Args &&...args)
+    {
+        return *set(w, std::make_unique<T>(std::forward<Args>(args)...));
+    }
+
+    /**
+     * Destroys the value of @p w if there is one.
+     */
+    void reset(EffectWindow *w)
+    {
+        w->setSlotData(m_index, nullptr, nullptr);
+    }
+
+private:
+    static void destroy(void *data)
+    {
+        delete static_cast<T *>(data);
+    }
+
+    int m_index;
+};
+
 
 struct GLVertex2D
 {
@@ -2610,9 +2743,11 @@ public:
 private:
     friend class WindowQuad;
     friend class WindowQuadList;
-    double px, py; // position
-    double ox, oy; // origional position
-    double tx, ty; // texture coords
+    // Stored as floats in the order of the interleaved vertex arrays, so that position and
+    // texture coordinate can be transformed with a single vector operation.
+    float px, py; // position
+    float tx, ty; // texture coords
+    float ox, oy; // origional position
 };
 
 /**
@@ -3856,20 +3991,20 @@ extern KWINEFFECTS_EXPORT EffectsHandler* effects;
 
 inline
 WindowVertex::WindowVertex()
-    : px(0), py(0), ox(0), oy(0), tx(0), ty(0)
+    : px(0), py(0), tx(0), ty(0), ox(0), oy(0)
 {
 }
 
 inline
 WindowVertex::WindowVertex(double _x, double _y, double _tx, double _ty)
-    : px(_x), py(_y), ox(_x), oy(_y), tx(_tx), ty(_ty)
+    : px(_x), py(_y), tx(_tx), ty(_ty), ox(_x), oy(_y)
 {
 }
 
 
 inline
 WindowVertex::WindowVertex(const QPointF &position, const QPointF &texturePosition)
-    : px(position.x()), py(position.y()), ox(position.x()), oy(position.y()), tx(texturePosition.x()), ty(texturePosition.y())
+    : px(position.x()), py(position.y()), tx(texturePosition.x()), ty(texturePosition.y()), ox(position.x()), oy(position.y())
 {
 }
 
@@ -4072,6 +4207,7 @@ void Effect::initConfig()
 }
 
 } // namespace
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWin::Effect::PaintHooks)
 Q_DECLARE_METATYPE(KWin::EffectWindow*)
 Q_DECLARE_METATYPE(KWin::EffectWindowList)
 Q_DECLARE_METATYPE(KWin::TimeLine)
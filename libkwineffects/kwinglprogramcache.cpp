@@ -0,0 +1,242 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwinglprogramcache_p.h"
+
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+
+namespace KWin
+{
+
+static const quint32 s_magic = 0x4b575042; // "KWPB"
+static const quint32 s_version = 1;
+// Bounds the directory when the sources change between releases with the same driver.
+static const int s_maxPrograms = 256;
+
+static bool programBinarySupported()
+{
+    const bool supported = GLPlatform::instance()->isGLES()
+        ? hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_OES_get_program_binary"))
+        : hasGLVersion(4, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"));
+    if (!supported) {
+        return false;
+    }
+
+    // Drivers can support the extension without offering any format.
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+GLProgramCache *GLProgramCache::create()
+{
+    if (qEnvironmentVariableIsSet("KWIN_GL_NO_PROGRAM_CACHE")) {
+        return nullptr;
+    }
+    if (!programBinarySupported()) {
+        qCDebug(LIBKWINGLUTILS) << "Program binaries not supported, shaders are not cached";
+        return nullptr;
+    }
+
+    const QString location = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (location.isEmpty()) {
+        return nullptr;
+    }
+    const QString path = location + QStringLiteral("/glprograms/");
+    if (!QDir().mkpath(path)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to create the program cache directory" << path;
+        return nullptr;
+    }
+    return new GLProgramCache(path);
+}
+
+GLProgramCache::GLProgramCache(const QString &path)
+    : m_path(path)
+    // The OpenGL ES extension has no program parameters.
+    , m_retrievableHint(!GLPlatform::instance()->isGLES() || hasGLVersion(3, 0))
+{
+    auto platform = GLPlatform::instance();
+    m_driver = platform->glVendorString() + '\n' + platform->glRendererString() + '\n'
+        + platform->glVersionString() + '\n' + platform->glShadingLanguageVersionString();
+
+    prune();
+
+    QFile file(m_path + QStringLiteral("traits"));
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&file);
+        while (!stream.atEnd()) {
+            bool ok;
+            const int traits = stream.readLine().toInt(&ok);
+            if (ok && !m_traits.contains(traits)) {
+                m_traits << traits;
+            }
+        }
+    }
+}
+
+QFileInfoList GLProgramCache::programFiles() const
+{
+    QFileInfoList programs;
+    const auto files = QDir(m_path).entryInfoList(QDir::Files, QDir::Time);
+    for (const QFileInfo &info : files) {
+        if (info.fileName() != QLatin1String("traits")
+                && info.fileName() != QLatin1String("driver")) {
+            programs << info;
+        }
+    }
+    return programs;
+}
+
+void GLProgramCache::prune() const
+{
+    const QByteArray driver = QCryptographicHash::hash(m_driver, QCryptographicHash::Sha1).toHex();
+    QFile file(m_path + QStringLiteral("driver"));
+
+    const bool changed = !file.open(QIODevice::ReadOnly) || file.readAll() != driver;
+    file.close();
+
+    QFileInfoList programs = programFiles();
+    if (changed) {
+        // No binary of another driver can be loaded anymore.
+        if (!programs.isEmpty()) {
+            qCDebug(LIBKWINGLUTILS) << "Driver changed, clearing the program cache";
+        }
+    } else {
+        // Keep the most recently stored programs.
+        programs = programs.mid(s_maxPrograms);
+    }
+    for (const QFileInfo &info : qAsConst(programs)) {
+        QFile::remove(info.filePath());
+    }
+
+    if (changed) {
+        QSaveFile driverFile(file.fileName());
+        if (driverFile.open(QIODevice::WriteOnly)) {
+            driverFile.write(driver);
+            driverFile.commit();
+        }
+    }
+}
+
+QByteArray GLProgramCache::key(const QVector<QByteArray> &sources) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(m_driver);
+    for (const QByteArray &source : sources) {
+        // Separate the sources so that moving code between them changes the key.
+        hash.addData(QByteArray::number(source.size()) + '\n');
+        hash.addData(source);
+    }
+    return hash.result().toHex();
+}
+
+QString GLProgramCache::filePath(const QByteArray &key) const
+{
+    return m_path + QString::fromLatin1(key);
+}
+
+bool GLProgramCache::load(GLuint program, const QByteArray &key)
+{
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic, version, format;
+    QByteArray binary;
+    stream >> magic >> version >> format >> binary;
+    if (stream.status() != QDataStream::Ok || magic != s_magic || version != s_version
+            || binary.isEmpty()) {
+        file.remove();
+        return false;
+    }
+
+    glProgramBinary(program, format, binary.constData(), binary.size());
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        // The driver changed without changing its strings. The binary is replaced on the next link.
+        qCDebug(LIBKWINGLUTILS) << "Driver rejected cached program" << key;
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+void GLProgramCache::prepareLink(GLuint program) const
+{
+    if (m_retrievableHint) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void GLProgramCache::store(GLuint program, const QByteArray &key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray binary(length, Qt::Uninitialized);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    if (length <= 0) {
+        return;
+    }
+    binary.truncate(length);
+
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream << s_magic << s_version << quint32(format) << binary;
+    if (!file.commit()) {
+        qCDebug(LIBKWINGLUTILS) << "Failed to store program" << key << file.errorString();
+    }
+}
+
+QVector<int> GLProgramCache::traits() const
+{
+    return m_traits;
+}
+
+void GLProgramCache::addTraits(int traits)
+{
+    if (m_traits.contains(traits)) {
+        return;
+    }
+    m_traits << traits;
+    saveTraits();
+}
+
+void GLProgramCache::saveTraits() const
+{
+    QSaveFile file(m_path + QStringLiteral("traits"));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return;
+    }
+    QTextStream stream(&file);
+    for (int traits : m_traits) {
+        stream << traits << '\n';
+    }
+    stream.flush();
+    file.commit();
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QFileInfoList>
+#include <QString>
+#include <QVector>
+
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+/**
+ * Stores linked programs on disk with glGetProgramBinary and restores them with glProgramBinary
+ * instead of compiling their sources again.
+ *
+ * Binaries are looked up by a hash of the sources and of the vendor, renderer and version strings
+ * of the driver. A driver update therefore misses the cache instead of loading stale binaries. The
+ * binaries of the previous driver are removed then, and the number of stored programs is bounded.
+ *
+ * The cache also remembers the shader traits requested through the ShaderManager, so that it can
+ * restore them eagerly on the next start.
+ *
+ * The OpenGL context must be current for all calls.
+ */
+class GLProgramCache
+{
+public:
+    /**
+     * Returns nullptr if the driver does not support program binaries or the cache is disabled.
+     */
+    static GLProgramCache *create();
+
+    /**
+     * The key of a program linked from @p sources. All inputs to the link, like the attribute
+     * locations, must be part of the sources.
+     */
+    QByteArray key(const QVector<QByteArray> &sources) const;
+
+    /**
+     * Loads the binary stored under @p key into @p program. Returns false if there is none or the
+     * driver rejects it, @p program must be linked from sources then.
+     */
+    bool load(GLuint program, const QByteArray &key);
+
+    /**
+     * Must be called before @p program is linked from sources for storing it afterwards.
+     */
+    void prepareLink(GLuint program) const;
+
+    /**
+     * Stores the binary of the linked @p program under @p key.
+     */
+    void store(GLuint program, const QByteArray &key);
+
+    QVector<int> traits() const;
+    void addTraits(int traits);
+
+private:
+    explicit GLProgramCache(const QString &path);
+
+    QString filePath(const QByteArray &key) const;
+    QFileInfoList programFiles() const;
+    /**
+     * Removes all programs if the driver changed since the last start and otherwise the oldest
+     * ones exceeding the limit.
+     */
+    void prune() const;
+    void saveTraits() const;
+
+    QString m_path;
+    QByteArray m_driver;
+    bool m_retrievableHint;
+    QVector<int> m_traits;
+};
+
+}
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 // need to call GLTexturePrivate::initStatic()
 #include "kwingltexture_p.h"
+#include "kwinglprogramcache_p.h"
 
 #include "kwineffects.h"
 #include "kwinglplatform.h"
@@ -81,6 +82,7 @@ void initGL(const std::function<resolveFuncPtr(const char*)> &resolveFunction)
     GLTexturePrivate::initStatic();
     GLRenderTarget::initStatic();
     GLVertexBuffer::initStatic();
+    GLPixelUnpackBuffer::initStatic();
 }
 
 void cleanupGL()
@@ -89,6 +91,7 @@ void cleanupGL()
     GLTexturePrivate::cleanup();
     GLRenderTarget::cleanup();
     GLVertexBuffer::cleanup();
+    GLPixelUnpackBuffer::cleanup();
     GLPlatform::cleanup();
 
     glExtensions.clear();
@@ -546,6 +549,10 @@ void ShaderManager::cleanup()
     s_shaderManager = nullptr;
 }
 
+// The attribute and fragment data locations bound for generated and for loaded shaders.
+static const QByteArray s_generatedLocations = QByteArrayLiteral("position texcoord fragColor");
+static const QByteArray s_codeLocations = QByteArrayLiteral("vertex texCoord fragColor");
+
 ShaderManager::ShaderManager()
 {
     const qint64 coreVersionNumber = GLPlatform::instance()->isGLES() ? kVersionNumber(3, 0) : kVersionNumber(1, 40);
@@ -554,6 +561,9 @@ ShaderManager::ShaderManager()
     } else {
         m_resourcePath = QStringLiteral(":/effect-shaders-1.10/");
     }
+
+    m_programCache.reset(GLProgramCache::create());
+    warmUp();
 }
 
 ShaderManager::~ShaderManager()
@@ -957,6 +967,11 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
     qCDebug(LIBKWINGLUTILS) << "**************";
 #endif
 
+    const QByteArray key = programKey(vertex, fragment, s_generatedLocations);
+    if (GLShader *shader = loadCachedShader(key)) {
+        return shader;
+    }
+
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
     shader->load(vertex, fragment);
 
@@ -964,7 +979,7 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
     shader->bindAttributeLocation("texcoord", VA_TexCoord);
     shader->bindFragDataLocation("fragColor", 0);
 
-    shader->link();
+    linkShader(shader, key);
     return shader;
 }
 
@@ -1002,6 +1017,9 @@ GLShader *ShaderManager::shader(ShaderTraits traits)
     if (!shader) {
         shader = generateShader(traits);
         m_shaderHash.insert(traits, shader);
+        if (m_programCache) {
+            m_programCache->addTraits(int(traits));
+        }
     }
 
     return shader;
@@ -1066,14 +1084,72 @@ void ShaderManager::bindAttributeLocations(GLShader *shader) const
 
 GLShader *ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
+    const QByteArray key = programKey(vertexSource, fragmentSource, s_codeLocations);
+    if (GLShader *shader = loadCachedShader(key)) {
+        return shader;
+    }
+
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
     shader->load(vertexSource, fragmentSource);
     bindAttributeLocations(shader);
     bindFragDataLocations(shader);
-    shader->link();
+    linkShader(shader, key);
     return shader;
 }
 
+QByteArray ShaderManager::programKey(const QByteArray &vertexSource, const QByteArray &fragmentSource,
+                                     const QByteArray &locations) const
+{
+    if (!m_programCache) {
+        return QByteArray();
+    }
+    return m_programCache->key({vertexSource, fragmentSource, locations});
+}
+
+GLShader *ShaderManager::loadCachedShader(const QByteArray &key) const
+{
+    if (!m_programCache) {
+        return nullptr;
+    }
+
+    // The program binary contains the attribute and fragment data locations.
+    GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+    if (!m_programCache->load(shader->mProgram, key)) {
+        delete shader;
+        return nullptr;
+    }
+    shader->mValid = true;
+    return shader;
+}
+
+void ShaderManager::linkShader(GLShader *shader, const QByteArray &key) const
+{
+    if (m_programCache) {
+        m_programCache->prepareLink(shader->mProgram);
+    }
+    if (shader->link() && m_programCache) {
+        m_programCache->store(shader->mProgram, key);
+    }
+}
+
+void ShaderManager::warmUp()
+{
+    if (!m_programCache) {
+        return;
+    }
+
+    // Restore the trait shaders used before, so that effects do not stall on their first frame.
+    // Only binaries are loaded here, shaders not in the cache are still compiled on first use.
+    for (int value : m_programCache->traits()) {
+        const ShaderTraits traits(QFlag{value});
+        const QByteArray key = programKey(generateVertexSource(traits), generateFragmentSource(traits),
+                                          s_generatedLocations);
+        if (GLShader *shader = loadCachedShader(key)) {
+            m_shaderHash.insert(traits, shader);
+        }
+    }
+}
+
 /***  GLRenderTarget  ***/
 bool GLRenderTarget::sSupported = false;
 bool GLRenderTarget::s_blitSupported = false;
@@ -1721,6 +1797,38 @@ static void deleteAll(std::deque<BufferFence> &fences)
     fences.clear();
 }
 
+static bool awaitFence(std::deque<BufferFence> &fences, intptr_t end, intptr_t &bufferEnd)
+{
+    // Skip fences until we reach the end offset
+    while (!fences.empty() && fences.front().nextEnd < end) {
+        glDeleteSync(fences.front().sync);
+        fences.pop_front();
+    }
+
+    Q_ASSERT(!fences.empty());
+
+    // Wait on the next fence
+    const BufferFence &fence = fences.front();
+
+    if (!fence.signaled()) {
+        qCDebug(LIBKWINGLUTILS) << "Stalling on buffer fence";
+        const GLenum ret = glClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+
+        if (ret == GL_TIMEOUT_EXPIRED || ret == GL_WAIT_FAILED) {
+            qCCritical(LIBKWINGLUTILS) << "Wait failed";
+            return false;
+        }
+    }
+
+    glDeleteSync(fence.sync);
+
+    // Update the end pointer
+    bufferEnd = fence.nextEnd;
+    fences.pop_front();
+
+    return true;
+}
+
 
 
 // ------------------------------------------------------------------
@@ -1937,34 +2045,7 @@ void GLVertexBufferPrivate::reallocatePersistentBuffer(size_t size)
 
 bool GLVertexBufferPrivate::awaitFence(intptr_t end)
 {
-    // Skip fences until we reach the end offset
-    while (!fences.empty() && fences.front().nextEnd < end) {
-        glDeleteSync(fences.front().sync);
-        fences.pop_front();
-    }
-
-    Q_ASSERT(!fences.empty());
-
-    // Wait on the next fence
-    const BufferFence &fence = fences.front();
-
-    if (!fence.signaled()) {
-        qCDebug(LIBKWINGLUTILS) << "Stalling on VBO fence";
-        const GLenum ret = glClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
-
-        if (ret == GL_TIMEOUT_EXPIRED || ret == GL_WAIT_FAILED) {
-            qCCritical(LIBKWINGLUTILS) << "Wait failed";
-            return false;
-        }
-    }
-
-    glDeleteSync(fence.sync);
-
-    // Update the end pointer
-    bufferEnd = fence.nextEnd;
-    fences.pop_front();
-
-    return true;
+    return KWin::awaitFence(fences, end, bufferEnd);
 }
 
 GLvoid *GLVertexBufferPrivate::getIdleRange(size_t size)
@@ -2347,4 +2428,214 @@ GLVertexBuffer *GLVertexBuffer::streamingBuffer()
     return GLVertexBufferPrivate::streamingBuffer;
 }
 
+
+
+//*********************************
+// GLPixelUnpackBufferPrivate
+//*********************************
+class GLPixelUnpackBufferPrivate
+{
+public:
+    ~GLPixelUnpackBufferPrivate() {
+        deleteAll(fences);
+
+        if (buffer != 0) {
+            glDeleteBuffers(1, &buffer);
+            map = nullptr;
+        }
+    }
+
+    void reallocate(size_t size);
+    uint8_t *getIdleRange(size_t size);
+
+    GLuint buffer = 0;
+    size_t bufferSize = 0;
+    intptr_t bufferEnd = 0;
+    intptr_t nextOffset = 0;
+    intptr_t mappedOffset = 0;
+    size_t frameSize = 0;
+    uint8_t *map = nullptr;
+    std::deque<BufferFence> fences;
+    FrameSizesArray<4> frameSizes;
+    static GLPixelUnpackBuffer *streamingBuffer;
+};
+
+GLPixelUnpackBuffer *GLPixelUnpackBufferPrivate::streamingBuffer = nullptr;
+
+void GLPixelUnpackBufferPrivate::reallocate(size_t size)
+{
+    if (buffer != 0) {
+        // This also unmaps and unbinds the buffer
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+
+        deleteAll(fences);
+    }
+
+    glGenBuffers(1, &buffer);
+
+    // Round the size up to 1 Mb
+    size_t minSize = qMax<size_t>(frameSizes.average() * 3, 4 * 1024 * 1024);
+    bufferSize = align(qMax(size, minSize), 1024 * 1024);
+
+    const GLbitfield storage = GL_DYNAMIC_STORAGE_BIT;
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, storage | access);
+
+    map = (uint8_t *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bufferSize, access);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    nextOffset = 0;
+    bufferEnd = bufferSize;
+}
+
+uint8_t *GLPixelUnpackBufferPrivate::getIdleRange(size_t size)
+{
+    if (unlikely(size > bufferSize))
+        reallocate(size * 2);
+
+    if (unlikely(!map))
+        return nullptr;
+
+    // Handle wrap-around
+    if (unlikely(nextOffset + size > bufferSize)) {
+        nextOffset = 0;
+        bufferEnd -= bufferSize;
+
+        for (BufferFence &fence : fences)
+            fence.nextEnd -= bufferSize;
+
+        // Emit a fence now
+        BufferFence fence;
+        fence.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        fence.nextEnd = bufferSize;
+        fences.emplace_back(fence);
+    }
+
+    if (unlikely(nextOffset + intptr_t(size) > bufferEnd)) {
+        if (!awaitFence(fences, nextOffset + size, bufferEnd))
+            return nullptr;
+    }
+
+    return map + nextOffset;
+}
+
+
+
+//*********************************
+// GLPixelUnpackBuffer
+//*********************************
+GLPixelUnpackBuffer::GLPixelUnpackBuffer()
+    : d(new GLPixelUnpackBufferPrivate)
+{
+}
+
+GLPixelUnpackBuffer::~GLPixelUnpackBuffer()
+{
+    delete d;
+}
+
+uint8_t *GLPixelUnpackBuffer::map(size_t size)
+{
+    uint8_t *ptr = d->getIdleRange(size);
+    if (!ptr)
+        return nullptr;
+
+    d->mappedOffset = d->nextOffset;
+
+    // Keep rows of the following range aligned for the unpack alignment and for SSE
+    d->nextOffset += align(size, 16);
+    d->frameSize += size;
+
+    return ptr;
+}
+
+const GLvoid *GLPixelUnpackBuffer::bind()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, d->buffer);
+    return (const GLvoid *) d->mappedOffset;
+}
+
+void GLPixelUnpackBuffer::unbind()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void GLPixelUnpackBuffer::endOfFrame()
+{
+    if (d->frameSize == 0)
+        return;
+
+    d->frameSizes.push(d->frameSize);
+    d->frameSize = 0;
+
+    // Force the buffer to be reallocated on the next upload
+    // if the average frame size is greater than half the size of the buffer
+    if (unlikely(d->frameSizes.average() > d->bufferSize / 2)) {
+        deleteAll(d->fences);
+        glDeleteBuffers(1, &d->buffer);
+
+        d->buffer = 0;
+        d->bufferSize = 0;
+        d->nextOffset = 0;
+        d->map = nullptr;
+    } else {
+        BufferFence fence;
+        fence.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        fence.nextEnd = d->nextOffset + d->bufferSize;
+
+        d->fences.emplace_back(fence);
+    }
+}
+
+void GLPixelUnpackBuffer::framePosted()
+{
+    // Remove finished fences from the list and update the bufferEnd offset
+    while (d->fences.size() > 1 && d->fences.front().signaled()) {
+        const BufferFence &fence = d->fences.front();
+        glDeleteSync(fence.sync);
+
+        d->bufferEnd = fence.nextEnd;
+        d->fences.pop_front();
+    }
+}
+
+void GLPixelUnpackBuffer::initStatic()
+{
+    bool haveBufferStorage;
+    bool haveSyncFences;
+    bool havePixelBuffer;
+
+    if (GLPlatform::instance()->isGLES()) {
+        haveBufferStorage = hasGLExtension("GL_EXT_buffer_storage");
+        haveSyncFences = hasGLVersion(3, 0);
+        havePixelBuffer = hasGLVersion(3, 0);
+    } else {
+        haveBufferStorage = hasGLVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage");
+        haveSyncFences = hasGLVersion(3, 2) || hasGLExtension("GL_ARB_sync");
+        havePixelBuffer = hasGLVersion(2, 1) || hasGLExtension("GL_ARB_pixel_buffer_object");
+    }
+
+    GLPixelUnpackBufferPrivate::streamingBuffer = nullptr;
+
+    if (haveBufferStorage && haveSyncFences && havePixelBuffer) {
+        if (qgetenv("KWIN_PERSISTENT_PBO") != QByteArrayLiteral("0")) {
+            GLPixelUnpackBufferPrivate::streamingBuffer = new GLPixelUnpackBuffer;
+        }
+    }
+}
+
+void GLPixelUnpackBuffer::cleanup()
+{
+    delete GLPixelUnpackBufferPrivate::streamingBuffer;
+    GLPixelUnpackBufferPrivate::streamingBuffer = nullptr;
+}
+
+GLPixelUnpackBuffer *GLPixelUnpackBuffer::streamingBuffer()
+{
+    return GLPixelUnpackBufferPrivate::streamingBuffer;
+}
+
 } // namespace
@@ -31,6 +31,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSize>
 #include <QStack>
 
+#include <memory>
+
 /** @addtogroup kwineffects */
 /** @{ */
 
@@ -45,8 +47,10 @@ template< class K, class V > class QHash;
 namespace KWin
 {
 
+class GLProgramCache;
 class GLVertexBuffer;
 class GLVertexBufferPrivate;
+class GLPixelUnpackBufferPrivate;
 
 // Initializes OpenGL stuff. This includes resolving function pointers as
 //  well as checking for GL version and extensions
@@ -324,9 +328,16 @@ private:
     QByteArray generateFragmentSource(ShaderTraits traits) const;
     GLShader *generateShader(ShaderTraits traits);
 
+    QByteArray programKey(const QByteArray &vertexSource, const QByteArray &fragmentSource,
+                          const QByteArray &locations) const;
+    GLShader *loadCachedShader(const QByteArray &key) const;
+    void linkShader(GLShader *shader, const QByteArray &key) const;
+    void warmUp();
+
     QStack<GLShader*> m_boundShaders;
     QHash<ShaderTraits, GLShader *> m_shaderHash;
     QString m_resourcePath;
+    std::unique_ptr<GLProgramCache> m_programCache;
     static ShaderManager *s_shaderManager;
 };
 
@@ -821,6 +832,75 @@ private:
     static qreal s_virtualScreenScale;
 };
 
+/**
+ * @short Streaming pixel unpack buffer for texture uploads
+ *
+ * Pixel data is written into a ring buffer that stays persistently mapped. The texture upload
+ * reading from the buffer is then an asynchronous copy done by the GPU instead of a synchronous
+ * transfer from client memory. Ranges are recycled once the fence emitted at the end of the frame
+ * that used them has signaled.
+ *
+ * The buffer is only available when buffer storage and sync objects are supported.
+ */
+class KWINGLUTILS_EXPORT GLPixelUnpackBuffer
+{
+public:
+    ~GLPixelUnpackBuffer();
+
+    /**
+     * Returns a pointer to an idle range of @p size bytes to write pixel data to, or nullptr if
+     * no range could be acquired. The range is valid until the next call to map.
+     */
+    uint8_t *map(size_t size);
+
+    /**
+     * Binds the buffer to GL_PIXEL_UNPACK_BUFFER.
+     *
+     * While bound, pointers passed to pixel transfer functions are offsets into the buffer.
+     *
+     * @return The offset of the range returned by the last call to map.
+     */
+    const GLvoid *bind();
+
+    /**
+     * Unbinds GL_PIXEL_UNPACK_BUFFER.
+     */
+    void unbind();
+
+    /**
+     * Notifies the buffer that we are done painting the frame.
+     *
+     * @internal
+     */
+    void endOfFrame();
+
+    /**
+     * Notifies the buffer that we have posted the frame.
+     *
+     * @internal
+     */
+    void framePosted();
+
+    /**
+     * @internal
+     */
+    static void initStatic();
+
+    /**
+     * @internal
+     */
+    static void cleanup();
+
+    /**
+     * @return The shared streaming buffer or nullptr if not supported.
+     */
+    static GLPixelUnpackBuffer *streamingBuffer();
+
+private:
+    GLPixelUnpackBuffer();
+    GLPixelUnpackBufferPrivate* const d;
+};
+
 } // namespace
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(KWin::ShaderTraits)
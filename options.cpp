@@ -110,6 +110,7 @@ Options::Options(QObject *parent)
     , m_maxFpsInterval(Options::defaultMaxFpsInterval())
     , m_refreshRate(Options::defaultRefreshRate())
     , m_vBlankTime(Options::defaultVBlankTime())
+    , m_latencyBudget(Options::defaultLatencyBudget() * 1000)
     , m_glStrictBinding(Options::defaultGlStrictBinding())
     , m_glStrictBindingFollowsDriver(Options::defaultGlStrictBindingFollowsDriver())
     , m_glCoreProfile(Options::defaultGLCoreProfile())
@@ -594,6 +595,15 @@ void Options::setVBlankTime(qint64 vBlankTime)
     emit vBlankTimeChanged();
 }
 
+void Options::setLatencyBudget(qint64 latencyBudget)
+{
+    if (m_latencyBudget == latencyBudget) {
+        return;
+    }
+    m_latencyBudget = latencyBudget;
+    emit latencyBudgetChanged();
+}
+
 void Options::setGlStrictBinding(bool glStrictBinding)
 {
     if (m_glStrictBinding == glStrictBinding) {
@@ -739,6 +749,7 @@ void Options::loadConfig()
     setMaxFpsInterval(1 * 1000 * 1000 * 1000 / config.readEntry("MaxFPS", Options::defaultMaxFps()));
     setRefreshRate(config.readEntry("RefreshRate", Options::defaultRefreshRate()));
     setVBlankTime(config.readEntry("VBlankTime", Options::defaultVBlankTime()) * 1000); // config in micro, value in nano resolution
+    setLatencyBudget(config.readEntry("LatencyBudget", Options::defaultLatencyBudget()) * 1000); // config in micro, value in nano resolution
 
     // Modifier Only Shortcuts
     config = KConfigGroup(m_settings->config(), "ModifierOnlyShortcuts");
@@ -160,6 +160,11 @@ class KWIN_EXPORT Options : public QObject
     Q_PROPERTY(qint64 maxFpsInterval READ maxFpsInterval WRITE setMaxFpsInterval NOTIFY maxFpsIntervalChanged)
     Q_PROPERTY(uint refreshRate READ refreshRate WRITE setRefreshRate NOTIFY refreshRateChanged)
     Q_PROPERTY(qint64 vBlankTime READ vBlankTime WRITE setVBlankTime NOTIFY vBlankTimeChanged)
+    /**
+     * Time reserved before the vblank on top of the predicted render time, in nanoseconds.
+     * Lower values reduce latency but risk missing the vblank.
+     */
+    Q_PROPERTY(qint64 latencyBudget READ latencyBudget WRITE setLatencyBudget NOTIFY latencyBudgetChanged)
     Q_PROPERTY(bool glStrictBinding READ isGlStrictBinding WRITE setGlStrictBinding NOTIFY glStrictBindingChanged)
     /**
      * Whether strict binding follows the driver or has been overwritten by a user defined config value.
@@ -527,6 +532,9 @@ public:
     qint64 vBlankTime() const {
         return m_vBlankTime;
     }
+    qint64 latencyBudget() const {
+        return m_latencyBudget;
+    }
     bool isGlStrictBinding() const {
         return m_glStrictBinding;
     }
@@ -598,6 +606,7 @@ public:
     void setMaxFpsInterval(qint64 maxFpsInterval);
     void setRefreshRate(uint refreshRate);
     void setVBlankTime(qint64 vBlankTime);
+    void setLatencyBudget(qint64 latencyBudget);
     void setGlStrictBinding(bool glStrictBinding);
     void setGlStrictBindingFollowsDriver(bool glStrictBindingFollowsDriver);
     void setGLCoreProfile(bool glCoreProfile);
@@ -687,6 +696,9 @@ public:
     static uint defaultVBlankTime() {
         return 6000; // 6ms
     }
+    static uint defaultLatencyBudget() {
+        return 1000; // 1ms
+    }
     static bool defaultGlStrictBinding() {
         return true;
     }
@@ -761,6 +773,7 @@ Q_SIGNALS:
     void maxFpsIntervalChanged();
     void refreshRateChanged();
     void vBlankTimeChanged();
+    void latencyBudgetChanged();
     void glStrictBindingChanged();
     void glStrictBindingFollowsDriverChanged();
     void glCoreProfileChanged();
@@ -801,6 +814,7 @@ private:
     // Settings that should be auto-detected
     uint m_refreshRate;
     qint64 m_vBlankTime;
+    qint64 m_latencyBudget;
     bool m_glStrictBinding;
     bool m_glStrictBindingFollowsDriver;
     bool m_glCoreProfile;
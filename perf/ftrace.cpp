@@ -61,6 +61,11 @@ bool setEnabled(bool enable)
 {
     return FtraceImpl::self()->setEnabled(enable);
 }
+
+bool enabled()
+{
+    return FtraceImpl::self() && FtraceImpl::self()->isEnabled();
+}
 #else
 void mark(const QString &message)
 {
@@ -83,6 +88,11 @@ bool valid(QObject *parent, bool create)
     Q_UNUSED(create)
     return false;
 }
+
+bool enabled()
+{
+    return false;
+}
 #endif
 
 }
@@ -42,6 +42,11 @@ void end(const QString &message, ulong ctx);
 bool valid(QObject *parent = nullptr, bool create = false);
 bool setEnabled(bool enable);
 
+/**
+ * Whether marks are currently written. Use it to avoid building expensive messages.
+ */
+bool enabled();
+
 }
 }
 }
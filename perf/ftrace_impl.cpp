@@ -18,6 +18,7 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "ftrace_impl.h"
+#include "trace.h"
 
 #include "utils.h"
 
@@ -53,6 +54,10 @@ FtraceImpl::FtraceImpl(QObject *parent)
         qCDebug(KWIN_PERF) << "Ftrace marking initially enabled via environment variable";
         setEnabled(true);
     }
+    if (qEnvironmentVariableIsSet("KWIN_PERF_TRACE")) {
+        qCDebug(KWIN_PERF) << "Trace recording initially enabled via environment variable";
+        Trace::set_recording(true);
+    }
 }
 
 bool FtraceImpl::setEnabled(bool enable)
@@ -72,6 +77,7 @@ bool FtraceImpl::setEnabled(bool enable)
         delete m_file;
         m_file = nullptr;
     }
+    Trace::detail::set_ftrace_forwarding(enable);
     return true;
 }
 
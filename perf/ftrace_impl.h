@@ -44,6 +44,9 @@ public:
      * @return True if setting enablement succeeded, else false
      */
     bool setEnabled(bool enable);
+    bool isEnabled() const {
+        return m_file;
+    }
     void print(const QString &message);
     void printBegin(const QString &message, ulong ctx);
     void printEnd(const QString &message, ulong ctx);
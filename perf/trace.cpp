@@ -0,0 +1,312 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "trace.h"
+
+#include "ftrace_impl.h"
+
+#include <QCoreApplication>
+#include <QIODevice>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace KWin::Perf::Trace
+{
+
+namespace detail
+{
+std::atomic<bool> enabled{false};
+}
+
+namespace
+{
+
+// Per thread, must be a power of two. At 32 bytes per slot this is 512 KiB for each thread
+// that records at least one event.
+constexpr uint64_t ring_size = 1 << 14;
+
+/**
+ * A record published with a sequence lock. The sequence is odd while the owning thread writes
+ * the slot and 2 * (index + 1) once the record with that ring index is complete. All fields are
+ * atomics so that a reader racing with the writer only gets a torn copy, which the sequence
+ * check then discards.
+ */
+struct ring_slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> timestamp{0};
+    std::atomic<uint64_t> value{0};
+    // Instance, event id and phase packed into one word.
+    std::atomic<uint64_t> meta{0};
+};
+
+void write_slot(ring_slot& slot, uint64_t index, record const& rec)
+{
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestamp.store(rec.timestamp, std::memory_order_relaxed);
+    slot.value.store(rec.value, std::memory_order_relaxed);
+    slot.meta.store(uint64_t(rec.instance) << 32 | uint64_t(rec.id) << 8 | uint64_t(rec.ph),
+                    std::memory_order_relaxed);
+
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+}
+
+/**
+ * Copies the record with ring @p index out of @p slot. Returns false if the slot holds another
+ * record or the owning thread wrote to it while copying.
+ */
+bool read_slot(ring_slot const& slot, uint64_t index, record& rec)
+{
+    auto const seq = slot.seq.load(std::memory_order_acquire);
+    if (seq != 2 * index + 2) {
+        return false;
+    }
+
+    rec.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+    rec.value = slot.value.load(std::memory_order_relaxed);
+    auto const meta = slot.meta.load(std::memory_order_relaxed);
+    rec.instance = static_cast<uint32_t>(meta >> 32);
+    rec.id = static_cast<event>((meta >> 8) & 0xffff);
+    rec.ph = static_cast<phase>(meta & 0xff);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == seq;
+}
+
+/**
+ * Single producer ring. Only the owning thread writes records and advances the head. Readers
+ * copy records while the owning thread continues writing and skip the ones it overwrote.
+ */
+struct thread_ring {
+    std::array<ring_slot, ring_size> slots;
+    std::atomic<uint64_t> head{0};
+    // Records before this index were recorded before the last enablement. Guarded by the
+    // registry mutex.
+    uint64_t start{0};
+    uint64_t tid{0};
+};
+
+struct ring_registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<thread_ring>> rings;
+};
+
+ring_registry& registry()
+{
+    static ring_registry reg;
+    return reg;
+}
+
+std::atomic<bool> s_recording{false};
+std::atomic<bool> s_ftrace{false};
+
+void update_enabled()
+{
+    detail::enabled.store(s_recording.load() || s_ftrace.load());
+}
+
+uint64_t current_tid()
+{
+#ifdef SYS_gettid
+    return syscall(SYS_gettid);
+#else
+    static std::atomic<uint64_t> next{1};
+    return next++;
+#endif
+}
+
+thread_ring& local_ring()
+{
+    // The registry keeps a reference so that data of finished threads can still be exported.
+    thread_local auto const ring = [] {
+        auto ring = std::make_shared<thread_ring>();
+        ring->tid = current_tid();
+
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.rings.push_back(ring);
+        return ring;
+    }();
+    return *ring;
+}
+
+char const* event_name(event id)
+{
+    switch (id) {
+    case event::paint:
+    case event::output_paint:
+        return "paint";
+    case event::paint_timer:
+        return "timer";
+    case event::count:
+        break;
+    }
+    return "unknown";
+}
+
+QString ftrace_message(event id, uint32_t instance)
+{
+    auto message = QString::fromLatin1(event_name(id));
+    if (instance) {
+        message += QLatin1Char('-') + QString::number(instance);
+    }
+    return message;
+}
+
+void forward_ftrace(event id, phase ph, uint32_t instance, uint64_t value)
+{
+    auto ftrace = FtraceImpl::self();
+    if (!ftrace) {
+        return;
+    }
+
+    auto const message = ftrace_message(id, instance);
+    switch (ph) {
+    case phase::begin:
+        ftrace->printBegin(message, value);
+        break;
+    case phase::end:
+        ftrace->printEnd(message, value);
+        break;
+    case phase::instant:
+        ftrace->print(message + QLatin1Char(' ') + QString::number(value));
+        break;
+    }
+}
+
+QByteArray chrome_json_event(record const& rec, uint64_t pid, uint64_t tid)
+{
+    QByteArray name = event_name(rec.id);
+    if (rec.instance) {
+        name += '-' + QByteArray::number(rec.instance);
+    }
+
+    char const* ph = "i";
+    char const* arg = "value";
+    switch (rec.ph) {
+    case phase::begin:
+        ph = "B";
+        arg = "ctx";
+        break;
+    case phase::end:
+        ph = "E";
+        arg = "ctx";
+        break;
+    case phase::instant:
+        break;
+    }
+
+    // Timestamps are in microseconds with sub-microsecond precision as fraction.
+    QByteArray json = "{\"name\":\"" + name + "\",\"cat\":\"kwin\",\"ph\":\"" + ph
+        + "\",\"ts\":" + QByteArray::number(rec.timestamp / 1000) + '.'
+        + QByteArray::number(rec.timestamp % 1000).rightJustified(3, '0')
+        + ",\"pid\":" + QByteArray::number(pid) + ",\"tid\":" + QByteArray::number(tid);
+    if (rec.ph == phase::instant) {
+        json += ",\"s\":\"t\"";
+    }
+    json += ",\"args\":{\"" + QByteArray(arg) + "\":" + QByteArray::number(rec.value) + "}}";
+    return json;
+}
+
+}
+
+namespace detail
+{
+
+void write(event id, phase ph, uint32_t instance, uint64_t value)
+{
+    if (s_recording.load(std::memory_order_relaxed)) {
+        auto const now = std::chrono::steady_clock::now().time_since_epoch();
+        auto& ring = local_ring();
+        auto const head = ring.head.load(std::memory_order_relaxed);
+
+        write_slot(ring.slots[head & (ring_size - 1)], head,
+                   {static_cast<uint64_t>(std::chrono::nanoseconds(now).count()), value, instance,
+                    id, ph});
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+    if (s_ftrace.load(std::memory_order_relaxed)) {
+        forward_ftrace(id, ph, instance, value);
+    }
+}
+
+void set_ftrace_forwarding(bool enable)
+{
+    s_ftrace.store(enable);
+    update_enabled();
+}
+
+}
+
+void set_recording(bool enable)
+{
+    if (enable && !s_recording.load()) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& ring : reg.rings) {
+            ring->start = ring->head.load(std::memory_order_acquire);
+        }
+    }
+    s_recording.store(enable);
+    update_enabled();
+}
+
+bool recording()
+{
+    return s_recording.load();
+}
+
+bool export_chrome_json(QIODevice* device)
+{
+    auto const pid = static_cast<uint64_t>(QCoreApplication::applicationPid());
+    bool first = true;
+
+    if (device->write("{\"traceEvents\":[") < 0) {
+        return false;
+    }
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::vector<record> copy;
+    for (auto const& ring : reg.rings) {
+        auto const head = ring->head.load(std::memory_order_acquire);
+        auto begin = std::max(ring->start, head > ring_size ? head - ring_size : 0);
+
+        // The owning thread may continue writing while copying. Records it overwrites meanwhile
+        // are skipped.
+        copy.clear();
+        for (auto index = begin; index < head; index++) {
+            record rec;
+            if (read_slot(ring->slots[index & (ring_size - 1)], index, rec)) {
+                copy.push_back(rec);
+            }
+        }
+
+        for (auto it = copy.cbegin(); it != copy.cend(); ++it) {
+            auto json = chrome_json_event(*it, pid, ring->tid);
+            if (!first) {
+                json.prepend(',');
+            }
+            first = false;
+            if (device->write(json) < 0) {
+                return false;
+            }
+        }
+    }
+
+    return device->write("],\"displayTimeUnit\":\"ms\"}") >= 0;
+}
+
+}
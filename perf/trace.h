@@ -0,0 +1,130 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <config-kwin.h>
+#include <kwin_export.h>
+
+#include <atomic>
+#include <cstdint>
+
+class QIODevice;
+
+namespace KWin::Perf::Trace
+{
+
+/**
+ * Statically known trace events. Events carry no strings; their names are only looked up when
+ * the recorded data is exported or forwarded to the ftrace marker.
+ */
+enum class event : uint16_t {
+    // X11 compositor paint pass, ctx is the paint counter.
+    paint,
+    // Wayland output paint pass, instance is the output index, ctx the paint counter.
+    output_paint,
+    // Delay until the next paint, instance is the output index (0 on X11), value in ms.
+    paint_timer,
+    count,
+};
+
+enum class phase : uint8_t {
+    begin,
+    end,
+    instant,
+};
+
+/**
+ * An instance of 0 means the event is not bound to a specific instance, for example an output.
+ */
+struct record {
+    uint64_t timestamp;
+    uint64_t value;
+    uint32_t instance;
+    event id;
+    phase ph;
+};
+
+namespace detail
+{
+KWIN_EXPORT extern std::atomic<bool> enabled;
+KWIN_EXPORT void write(event id, phase ph, uint32_t instance, uint64_t value);
+
+/**
+ * Called by the ftrace marker when it gets enabled or disabled, so events are forwarded to it.
+ */
+KWIN_EXPORT void set_ftrace_forwarding(bool enable);
+}
+
+/**
+ * Whether any sink currently consumes events. Checked inline by the recording functions so that
+ * disabled tracing costs a relaxed load and a branch. Without perf support everything compiles
+ * away.
+ */
+inline bool enabled()
+{
+#if HAVE_PERF
+    return detail::enabled.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+inline void begin(event id, uint32_t instance, uint64_t ctx)
+{
+#if HAVE_PERF
+    if (enabled()) {
+        detail::write(id, phase::begin, instance, ctx);
+    }
+#else
+    (void)id;
+    (void)instance;
+    (void)(ctx);
+#endif
+}
+
+inline void end(event id, uint32_t instance, uint64_t ctx)
+{
+#if HAVE_PERF
+    if (enabled()) {
+        detail::write(id, phase::end, instance, ctx);
+    }
+#else
+    (void)id;
+    (void)instance;
+    (void)(ctx);
+#endif
+}
+
+inline void instant(event id, uint32_t instance, uint64_t value)
+{
+#if HAVE_PERF
+    if (enabled()) {
+        detail::write(id, phase::instant, instance, value);
+    }
+#else
+    (void)id;
+    (void)instance;
+    (void)(value);
+#endif
+}
+
+/**
+ * Enables or disables recording into the per-thread ring buffers. Enabling clears previously
+ * recorded data. Recording is independent of the ftrace marker, which receives the same events
+ * while it is enabled.
+ */
+KWIN_EXPORT void set_recording(bool enable);
+KWIN_EXPORT bool recording();
+
+/**
+ * Writes the recorded events as Chrome trace event JSON to @p device. The format can be loaded
+ * into Perfetto or chrome://tracing.
+ *
+ * @return True if all data could be written, else false
+ */
+KWIN_EXPORT bool export_chrome_json(QIODevice* device);
+
+}
@@ -38,6 +38,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QOpenGLContext>
 #include <QOpenGLFramebufferObject>
 
+#include <cstring>
 #include <memory>
 
 namespace KWin
@@ -167,6 +168,18 @@ void AbstractEglBackend::initWayland()
     m_dmaBuf = EglDmabuf::factory(this);
 }
 
+void AbstractEglBackend::updateDmabufFormats()
+{
+    if (m_dmaBuf) {
+        m_dmaBuf->setSupportedFormatsAndModifiers();
+    }
+}
+
+QHash<uint32_t, QSet<uint64_t>> AbstractEglBackend::scanoutFormats() const
+{
+    return {};
+}
+
 void AbstractEglBackend::initClientExtensions()
 {
     // Get the list of client extensions
@@ -421,8 +434,10 @@ void EglTexture::updateTexture(WindowPixmap *pixmap)
     if (!shmImage || !s) {
         return;
     }
-    if (buffer->size() != m_size) {
-        // buffer size has changed, reload shm texture
+    auto const hasAlpha = shmImage->format() == Wrapland::Server::ShmImage::Format::argb8888;
+    if (buffer->size() != m_size || hasAlpha != m_shmHasAlpha
+            || shmUploadMode(shmImage.value()) != m_shmUpload) {
+        // buffer size or format has changed, reload shm texture
         if (!loadTexture(pixmap)) {
             return;
         }
@@ -431,11 +446,7 @@ void EglTexture::updateTexture(WindowPixmap *pixmap)
     const QRegion damage = s->trackedDamage();
     s->resetTrackedDamage();
 
-    if (!GLPlatform::instance()->isGLES() || m_hasSubImageUnpack) {
-        textureSubImage(s->scale(), shmImage.value(), damage);
-    } else {
-        textureSubImageFromQImage(s->scale(), shmImage->createQImage(), damage);
-    }
+    textureSubImage(s->scale(), shmImage.value(), damage);
 }
 
 bool EglTexture::createTextureImage(const QImage &image)
@@ -483,83 +494,135 @@ bool EglTexture::createTextureImage(const QImage &image)
     return true;
 }
 
-void EglTexture::textureSubImage(int scale, Wrapland::Server::ShmImage const& img, const QRegion &damage)
+EglTexture::ShmUpload EglTexture::shmUploadMode(Wrapland::Server::ShmImage const& img) const
 {
-    auto prepareSubImage = [this](Wrapland::Server::ShmImage const& img, QRect const& rect) {
-        q->bind();
-        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, img.stride() / (img.bpp() / 8));
-        glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, rect.x());
-        glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, rect.y());
-    };
-    auto finalizseSubImage = [this]() {
-        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
-        glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, 0);
-        glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, 0);
-        q->unbind();
-    };
-    auto getScaledRect = [scale](QRect const& rect) {
-        return QRect(rect.x() * scale, rect.y() * scale,
-                     rect.width() * scale, rect.height() * scale);
-    };
+    if (!GLPlatform::instance()->isGLES()) {
+        return ShmUpload::Bgra;
+    }
+    if (s_supportsARGB32 && img.format() == Wrapland::Server::ShmImage::Format::argb8888) {
+        return ShmUpload::Bgra;
+    }
+    if (s_supportsTextureSwizzle) {
+        // Upload the BGRA bytes as RGBA and let the sampler swap red and blue.
+        return ShmUpload::Swizzle;
+    }
+    return ShmUpload::Convert;
+}
 
+void EglTexture::textureSubImage(int scale, Wrapland::Server::ShmImage const& img, const QRegion &damage)
+{
     // Currently Wrapland only supports argb8888 and xrgb8888 formats, which both have the same Gl
     // counter-part. If more formats are added in the future this needs to be checked.
-    auto const glFormat = GL_BGRA;
+    auto const glFormat = m_shmUpload == ShmUpload::Swizzle ? GL_RGBA : GL_BGRA;
 
-    if (GLPlatform::instance()->isGLES()) {
-        if (s_supportsARGB32 && (img.format() == Wrapland::Server::ShmImage::Format::argb8888)) {
-            for (const QRect &rect : damage) {
-                auto const scaledRect = getScaledRect(rect);
-                prepareSubImage(img, scaledRect);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                glFormat, GL_UNSIGNED_BYTE, img.data());
-                finalizseSubImage();
+    auto const bytesPerPixel = img.bpp() / 8;
+    auto const stride = img.stride();
+    auto const imageRect = QRect(QPoint(), m_size);
+
+    // With a streaming pixel buffer the damaged rects are packed into GPU visible memory and the
+    // upload becomes an asynchronous copy on the GPU.
+    auto pixelBuffer = m_shmUpload == ShmUpload::Convert ? nullptr
+                                                         : GLPixelUnpackBuffer::streamingBuffer();
+    auto const useUnpack = !pixelBuffer
+        && (!GLPlatform::instance()->isGLES() || m_hasSubImageUnpack);
+
+    q->bind();
+    if (useUnpack) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / bytesPerPixel);
+    }
+
+    for (const QRect &rect : damage) {
+        auto const scaledRect = QRect(rect.x() * scale, rect.y() * scale,
+                                      rect.width() * scale, rect.height() * scale) & imageRect;
+        if (scaledRect.isEmpty()) {
+            continue;
+        }
+
+        // Point directly into the shm mapping. Only the damaged rect is ever read.
+        auto const src = img.data() + scaledRect.y() * stride + scaledRect.x() * bytesPerPixel;
+        auto const rowLength = scaledRect.width() * bytesPerPixel;
+
+        if (m_shmUpload == ShmUpload::Convert) {
+            // Neither BGRA textures nor swizzling available. Convert the damaged rect only.
+            auto const qformat = img.format() == Wrapland::Server::ShmImage::Format::argb8888
+                ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+            QImage const view(src, scaledRect.width(), scaledRect.height(), stride, qformat);
+            QImage const im = view.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+            glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(),
+                            scaledRect.height(), GL_RGBA, GL_UNSIGNED_BYTE, im.constBits());
+            continue;
+        }
+
+        auto copyRows = [&](uint8_t *dst) {
+            if (rowLength == stride) {
+                memcpy(dst, src, rowLength * scaledRect.height());
+                return;
             }
-        } else {
-            for (const QRect &rect : damage) {
-                auto scaledRect = getScaledRect(rect);
-                prepareSubImage(img, scaledRect);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                glFormat, GL_UNSIGNED_BYTE, img.data());
-                finalizseSubImage();
+            for (int row = 0; row < scaledRect.height(); row++) {
+                memcpy(dst + row * rowLength, src + row * stride, rowLength);
+            }
+        };
+
+        if (pixelBuffer) {
+            if (auto dst = pixelBuffer->map(rowLength * scaledRect.height())) {
+                copyRows(dst);
+                auto const offset = pixelBuffer->bind();
+                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(),
+                                scaledRect.height(), glFormat, GL_UNSIGNED_BYTE, offset);
+                pixelBuffer->unbind();
+                continue;
             }
         }
-    } else {
-        for (const QRect &rect : damage) {
-            auto const scaledRect = getScaledRect(rect);
-            prepareSubImage(img, scaledRect);
-            glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                            glFormat, GL_UNSIGNED_BYTE, img.data());
-            finalizseSubImage();
+
+        if (useUnpack || rowLength == stride) {
+            glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(),
+                            scaledRect.height(), glFormat, GL_UNSIGNED_BYTE, src);
+            continue;
         }
+
+        // Without unpack support rows must be tightly packed. Gather the damaged rows into a
+        // reused staging buffer instead of copying the whole image.
+        m_uploadBuffer.resize(rowLength * scaledRect.height());
+        copyRows(m_uploadBuffer.data());
+        glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(),
+                        scaledRect.height(), glFormat, GL_UNSIGNED_BYTE, m_uploadBuffer.data());
     }
+
+    if (useUnpack) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+    }
+    q->unbind();
 }
 
 void EglTexture::textureSubImageFromQImage(int scale, const QImage &image, const QRegion &damage)
 {
+    // Only convert the damaged parts. Converting the whole image on every update is expensive for
+    // large surfaces with small damage.
+    auto const imageRect = image.rect();
+
     q->bind();
-    if (GLPlatform::instance()->isGLES()) {
-        if (s_supportsARGB32 && (image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)) {
-            const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
+    for (const QRect &rect : damage) {
+        auto const scaledRect = QRect(rect.x() * scale, rect.y() * scale,
+                                      rect.width() * scale, rect.height() * scale) & imageRect;
+        if (scaledRect.isEmpty()) {
+            continue;
+        }
+        auto const sub = image.copy(scaledRect);
+
+        if (GLPlatform::instance()->isGLES()) {
+            if (s_supportsARGB32 && (image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)) {
+                const QImage im = sub.convertToFormat(QImage::Format_ARGB32_Premultiplied);
                 glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        } else {
-            const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
+                                GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.constBits());
+            } else {
+                const QImage im = sub.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
                 glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_RGBA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
+                                GL_RGBA, GL_UNSIGNED_BYTE, im.constBits());
             }
-        }
-    } else {
-        const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        for (const QRect &rect : damage) {
-            auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
+        } else {
+            const QImage im = sub.convertToFormat(QImage::Format_ARGB32_Premultiplied);
             glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                            GL_BGRA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
+                            GL_BGRA, GL_UNSIGNED_BYTE, im.constBits());
         }
     }
     q->unbind();
@@ -567,7 +630,69 @@ void EglTexture::textureSubImageFromQImage(int scale, const QImage &image, const
 
 bool EglTexture::loadShmTexture(Wrapland::Server::Buffer *buffer)
 {
-    return createTextureImage(buffer->shmImage()->createQImage());
+    auto shmImage = buffer->shmImage();
+    if (!shmImage) {
+        return false;
+    }
+
+    m_shmUpload = shmUploadMode(shmImage.value());
+    m_shmHasAlpha = shmImage->format() == Wrapland::Server::ShmImage::Format::argb8888;
+
+    if (m_shmUpload == ShmUpload::Convert) {
+        m_uploadBuffer.clear();
+        m_uploadBuffer.shrink_to_fit();
+        // A new texture is created for the converted image.
+        if (m_texture != 0) {
+            glDeleteTextures(1, &m_texture);
+            m_texture = 0;
+        }
+        return createTextureImage(shmImage->createQImage());
+    }
+
+    auto const hasAlpha = m_shmHasAlpha;
+    GLenum internalFormat;
+    GLenum format;
+
+    if (!GLPlatform::instance()->isGLES()) {
+        internalFormat = hasAlpha ? GL_RGBA8 : GL_RGB8;
+        format = GL_BGRA;
+    } else if (m_shmUpload == ShmUpload::Bgra) {
+        internalFormat = GL_BGRA_EXT;
+        format = GL_BGRA_EXT;
+    } else {
+        internalFormat = GL_RGBA;
+        format = GL_RGBA;
+    }
+
+    if (m_texture == 0) {
+        glGenTextures(1, &m_texture);
+    }
+    q->setFilter(GL_LINEAR);
+    q->setWrapMode(GL_CLAMP_TO_EDGE);
+
+    m_size = buffer->size();
+
+    q->bind();
+    glTexImage2D(m_target, 0, internalFormat, m_size.width(), m_size.height(), 0,
+                 format, GL_UNSIGNED_BYTE, nullptr);
+    if (m_shmUpload == ShmUpload::Swizzle) {
+        glTexParameteri(m_target, GL_TEXTURE_SWIZZLE_R, GL_BLUE);
+        glTexParameteri(m_target, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        // The X channel of xrgb8888 buffers is undefined.
+        glTexParameteri(m_target, GL_TEXTURE_SWIZZLE_A, hasAlpha ? GL_ALPHA : GL_ONE);
+    } else if (s_supportsTextureSwizzle) {
+        // The texture is reused and might have been swizzled for a previous buffer.
+        glTexParameteri(m_target, GL_TEXTURE_SWIZZLE_R, GL_RED);
+        glTexParameteri(m_target, GL_TEXTURE_SWIZZLE_B, GL_BLUE);
+        glTexParameteri(m_target, GL_TEXTURE_SWIZZLE_A, GL_ALPHA);
+    }
+    q->unbind();
+
+    q->setYInverted(true);
+    updateMatrix();
+
+    textureSubImage(1, shmImage.value(), QRect(QPoint(), m_size));
+    return true;
 }
 
 bool EglTexture::loadEglTexture(Wrapland::Server::Buffer *buffer)
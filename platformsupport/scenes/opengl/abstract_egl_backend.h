@@ -22,9 +22,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "backend.h"
 #include "texture.h"
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <epoxy/egl.h>
 
+#include <vector>
+
 class QOpenGLFramebufferObject;
 
 namespace Wrapland
@@ -63,6 +67,12 @@ public:
         return m_config;
     }
 
+    /**
+     * Formats and modifiers client buffers can be presented with directly on all outputs. The
+     * modifiers advertised to clients are narrowed down to these where possible.
+     */
+    virtual QHash<uint32_t, QSet<uint64_t>> scanoutFormats() const;
+
 protected:
     AbstractEglBackend();
     void setEglDisplay(const EGLDisplay &display);
@@ -75,6 +85,10 @@ protected:
     void initBufferAge();
     void initClientExtensions();
     void initWayland();
+    /**
+     * Advertises the formats and modifiers again, e.g. after the scanout formats changed.
+     */
+    void updateDmabufFormats();
     bool hasClientExtension(const QByteArray &ext) const;
     bool isOpenGLES() const;
 
@@ -112,6 +126,17 @@ protected:
     }
 
 private:
+    /**
+     * How shm buffers are uploaded. Bgra streams the client memory directly, Swizzle streams it as
+     * RGBA and swaps the channels at sampling time, Convert converts damaged rects on the CPU.
+     */
+    enum class ShmUpload {
+        Bgra,
+        Swizzle,
+        Convert,
+    };
+    ShmUpload shmUploadMode(Wrapland::Server::ShmImage const& img) const;
+
     void textureSubImage(int scale, Wrapland::Server::ShmImage const& img, const QRegion &damage);
     void textureSubImageFromQImage(int scale, const QImage &image, const QRegion &damage);
 
@@ -127,6 +152,10 @@ private:
     AbstractEglBackend *m_backend;
     EGLImageKHR m_image;
     bool m_hasSubImageUnpack{false};
+    ShmUpload m_shmUpload{ShmUpload::Bgra};
+    // Whether the shm buffer the texture was created for is argb8888, otherwise xrgb8888.
+    bool m_shmHasAlpha{false};
+    std::vector<uint8_t> m_uploadBuffer;
 };
 
 }
@@ -91,6 +91,20 @@ QRegion OpenGLBackend::prepareRenderingForScreen(AbstractOutput* output)
     return output->geometry();
 }
 
+bool OpenGLBackend::directScanout(AbstractOutput* output, Toplevel* window)
+{
+    Q_UNUSED(output)
+    Q_UNUSED(window)
+    return false;
+}
+
+int OpenGLBackend::overlayScanout(AbstractOutput* output, std::deque<Toplevel*> const& windows)
+{
+    Q_UNUSED(output)
+    Q_UNUSED(windows)
+    return 0;
+}
+
 void OpenGLBackend::endRenderingFrameForScreen(AbstractOutput* output, const QRegion &damage, const QRegion &damagedRegion)
 {
     Q_UNUSED(output)
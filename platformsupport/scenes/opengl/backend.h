@@ -26,6 +26,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <kwin_export.h>
 
+#include <deque>
+
 namespace KWin
 {
 class AbstractOutput;
@@ -34,6 +36,7 @@ class OverlayWindow;
 class SceneOpenGL;
 class SceneOpenGLTexture;
 class SceneOpenGLTexturePrivate;
+class Toplevel;
 class WindowPixmap;
 
 /**
@@ -88,6 +91,26 @@ public:
     virtual bool usesOverlayWindow() const = 0;
     virtual bool hasSwapEvent() const { return true; }
     virtual QRegion prepareRenderingForScreen(AbstractOutput* output);
+    /**
+     * @brief Tries to present the buffer of @p window on @p output directly, without compositing.
+     *
+     * The scene only calls this when the window is the top-most one on the output, covers it
+     * completely and is opaque. If it returns @c false the output is composited as usual.
+     *
+     * @return bool @c true if the buffer of the window was presented
+     */
+    virtual bool directScanout(AbstractOutput* output, Toplevel* window);
+    /**
+     * @brief Tries to show the buffers of @p windows on overlay planes of @p output with the
+     * next presented frame.
+     *
+     * The windows are ordered from top to bottom and the scene only passes windows that are the
+     * top-most ones on the output and show nothing but their opaque buffer. The windows put on
+     * planes must not be composited.
+     *
+     * @return the number of windows from the top that are shown on planes
+     */
+    virtual int overlayScanout(AbstractOutput* output, std::deque<Toplevel*> const& windows);
     /**
      * @brief Compositor is going into idle mode, flushes any pending paints.
      */
@@ -474,6 +474,17 @@ void EglDmabuf::setSupportedFormatsAndModifiers()
         set.insert(format, QSet<uint64_t>());
     }
 
+    // Clients pick one of the advertised modifiers for their buffers. Offering only those the
+    // outputs can present lets fullscreen buffers be scanned out instead of composited. Backends
+    // that cannot scan out client buffers provide no formats and the list is left as it is.
+    const auto scanout = m_backend->scanoutFormats();
+    for (auto it = set.begin(); it != set.end(); ++it) {
+        auto const scanoutModifiers = it.value() & scanout.value(it.key());
+        if (!scanoutModifiers.isEmpty()) {
+            it.value() = scanoutModifiers;
+        }
+    }
+
     LinuxDmabuf::setSupportedFormatsAndModifiers(set);
 }
 
@@ -84,6 +84,8 @@ public:
                                                                 const QSize &size,
                                                                 Flags flags) override;
 
+    void setSupportedFormatsAndModifiers();
+
 private:
     EGLImage createImage(const QVector<Plane> &planes,
                          uint32_t format,
@@ -94,7 +96,6 @@ private:
                                                              const QSize &size,
                                                              Flags flags);
     QVector<uint32_t> queryFormats();
-    void setSupportedFormatsAndModifiers();
 
     AbstractEglBackend *m_backend;
 
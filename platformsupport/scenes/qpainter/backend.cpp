@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "backend.h"
 #include <logging.h>
 
+#include <QRegion>
 #include <QtGlobal>
 
 namespace KWin
@@ -39,6 +40,12 @@ void QPainterBackend::screenGeometryChanged(const QSize &size)
     Q_UNUSED(size)
 }
 
+QRegion QPainterBackend::bufferDamage(AbstractOutput* output) const
+{
+    Q_UNUSED(output)
+    return QRegion();
+}
+
 void QPainterBackend::setFailed(const QString &reason)
 {
     qCWarning(KWIN_QPAINTER) << "Creating the QPainter backend failed: " << reason;
@@ -66,6 +66,20 @@ public:
      */
     virtual QImage *bufferForScreen(AbstractOutput* output) = 0;
     virtual bool needsFullRepaint() const = 0;
+    /**
+     * @brief The region the current buffer of @p output misses compared to the last presented
+     * frame.
+     *
+     * Backends cycling through multiple buffers render into a buffer that was last painted some
+     * frames ago. The scene repaints the returned region in addition to the damage of the new
+     * frame. Only queried when needsFullRepaint returns @c false.
+     *
+     * Default implementation returns an empty region.
+     *
+     * @param output The output whose current buffer is painted next
+     * @return QRegion The region in global coordinates
+     */
+    virtual QRegion bufferDamage(AbstractOutput* output) const;
 
 protected:
     QPainterBackend();
@@ -238,9 +238,23 @@ void DrmBackend::atomicFlipHandler(int fd, unsigned int frame, unsigned int sec,
     Q_UNUSED(crtc_id)
 
     auto *output = reinterpret_cast<DrmOutput*>(data);
+    output->m_msc = frameToMsc(output->m_msc, frame);
+
+    if (output->m_cursorCommitPending) {
+        // Only the cursor was updated, a frame presented meanwhile is committed now.
+        if (output->cursorCommitted()) {
+            return;
+        }
+        // The frame could not be committed. Let the compositor continue without it.
+        output->m_backend->m_pageFlipsPending--;
+        if (auto compositor = static_cast<WaylandCompositor*>(Compositor::self())) {
+            compositor->swapped(output);
+        }
+        return;
+    }
+
     output->pageFlipped();
     output->m_backend->m_pageFlipsPending--;
-    output->m_msc = frameToMsc(output->m_msc, frame);
 
     if (auto compositor = static_cast<WaylandCompositor*>(Compositor::self())) {
         if (output->m_backend->m_supportsClockId) {
@@ -812,9 +826,9 @@ OpenGLBackend *DrmBackend::createOpenGLBackend()
 #endif
 }
 
-DrmDumbBuffer *DrmBackend::createBuffer(const QSize &size)
+DrmDumbBuffer *DrmBackend::createBuffer(const QSize &size, uint32_t format)
 {
-    DrmDumbBuffer *b = new DrmDumbBuffer(m_fd, size);
+    DrmDumbBuffer *b = new DrmDumbBuffer(m_fd, size, format);
     return b;
 }
 
@@ -824,6 +838,11 @@ DrmSurfaceBuffer *DrmBackend::createBuffer(const std::shared_ptr<GbmSurface> &su
     DrmSurfaceBuffer *b = new DrmSurfaceBuffer(m_fd, surface);
     return b;
 }
+
+DrmDmabufBuffer *DrmBackend::createBuffer(const std::shared_ptr<Wrapland::Server::Buffer> &buffer)
+{
+    return new DrmDmabufBuffer(m_fd, m_gbmDevice, buffer);
+}
 #endif
 
 QVector<CompositingType> DrmBackend::supportedCompositors() const
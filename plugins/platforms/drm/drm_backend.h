@@ -69,9 +69,10 @@ public:
     void init() override;
     void prepareShutdown() override;
 
-    DrmDumbBuffer *createBuffer(const QSize &size);
+    DrmDumbBuffer *createBuffer(const QSize &size, uint32_t format = DRM_FORMAT_XRGB8888);
 #if HAVE_GBM
     DrmSurfaceBuffer *createBuffer(const std::shared_ptr<GbmSurface> &surface);
+    DrmDmabufBuffer *createBuffer(const std::shared_ptr<Wrapland::Server::Buffer> &buffer);
 #endif
     bool present(DrmBuffer *buffer, DrmOutput *output);
 
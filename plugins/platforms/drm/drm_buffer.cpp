@@ -38,7 +38,7 @@ DrmBuffer:: DrmBuffer(int fd)
 }
 
 // DrmDumbBuffer
-DrmDumbBuffer::DrmDumbBuffer(int fd, const QSize &size)
+DrmDumbBuffer::DrmDumbBuffer(int fd, const QSize &size, uint32_t format)
     : DrmBuffer(fd)
 {
     m_size = size;
@@ -54,9 +54,12 @@ DrmDumbBuffer::DrmDumbBuffer(int fd, const QSize &size)
     m_handle = createArgs.handle;
     m_bufferSize = createArgs.size;
     m_stride = createArgs.pitch;
-    if (drmModeAddFB(fd, size.width(), size.height(), 24, 32,
-                     m_stride, createArgs.handle, &m_bufferId) != 0) {
-        qCWarning(KWIN_DRM) << "drmModeAddFB failed with errno" << errno;
+    const uint32_t handles[4] = {m_handle, 0, 0, 0};
+    const uint32_t pitches[4] = {m_stride, 0, 0, 0};
+    const uint32_t offsets[4] = {0, 0, 0, 0};
+    if (drmModeAddFB2(fd, size.width(), size.height(), format,
+                      handles, pitches, offsets, &m_bufferId, 0) != 0) {
+        qCWarning(KWIN_DRM) << "drmModeAddFB2 failed with errno" << errno;
     }
 }
 
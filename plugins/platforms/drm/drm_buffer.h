@@ -23,6 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QImage>
 #include <QSize>
 
+#include <drm_fourcc.h>
+
 namespace KWin
 {
 
@@ -57,7 +59,7 @@ protected:
 class DrmDumbBuffer : public DrmBuffer
 {
 public:
-    DrmDumbBuffer(int fd, const QSize &size);
+    DrmDumbBuffer(int fd, const QSize &size, uint32_t format = DRM_FORMAT_XRGB8888);
     ~DrmDumbBuffer() override;
 
     bool needsModeChange(DrmBuffer *b) const override;
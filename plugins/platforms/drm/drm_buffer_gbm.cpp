@@ -21,8 +21,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "drm_buffer_gbm.h"
 #include "gbm_surface.h"
 
+#include "linux_dmabuf.h"
 #include "logging.h"
 
+#include <Wrapland/Server/buffer.h>
+
 // system
 #include <sys/mman.h>
 // c++
@@ -31,6 +34,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 #include <gbm.h>
+#include <drm_fourcc.h>
 
 namespace KWin
 {
@@ -66,4 +70,76 @@ void DrmSurfaceBuffer::releaseGbm()
     m_bo = nullptr;
 }
 
+// DrmDmabufBuffer
+DrmDmabufBuffer::DrmDmabufBuffer(int fd, gbm_device *device,
+                                 const std::shared_ptr<Wrapland::Server::Buffer> &buffer)
+    : DrmBuffer(fd)
+    , m_buffer(buffer)
+{
+    auto dmabuf = static_cast<DmabufBuffer*>(buffer->linuxDmabufBuffer());
+    if (!dmabuf) {
+        return;
+    }
+    const auto &planes = dmabuf->planes();
+    if (planes.isEmpty() || planes.size() > 4) {
+        return;
+    }
+
+    gbm_import_fd_modifier_data data = {};
+    data.width = dmabuf->size().width();
+    data.height = dmabuf->size().height();
+    data.format = dmabuf->format();
+    data.num_fds = planes.size();
+    data.modifier = planes.first().modifier;
+    for (int i = 0; i < planes.size(); i++) {
+        data.fds[i] = planes[i].fd;
+        data.strides[i] = planes[i].stride;
+        data.offsets[i] = planes[i].offset;
+    }
+
+    m_bo = gbm_bo_import(device, GBM_BO_IMPORT_FD_MODIFIER, &data, GBM_BO_USE_SCANOUT);
+    if (!m_bo) {
+        qCDebug(KWIN_DRM) << "Importing dmabuf for scanout failed";
+        return;
+    }
+    m_size = dmabuf->size();
+    m_format = dmabuf->format();
+
+    uint32_t handles[4] = {};
+    uint32_t strides[4] = {};
+    uint32_t offsets[4] = {};
+    uint64_t modifiers[4] = {};
+    for (int i = 0; i < gbm_bo_get_plane_count(m_bo); i++) {
+        handles[i] = gbm_bo_get_handle_for_plane(m_bo, i).u32;
+        strides[i] = gbm_bo_get_stride_for_plane(m_bo, i);
+        offsets[i] = gbm_bo_get_offset(m_bo, i);
+        modifiers[i] = data.modifier;
+    }
+
+    const bool hasModifier = data.modifier != DRM_FORMAT_MOD_INVALID;
+    if (drmModeAddFB2WithModifiers(fd, m_size.width(), m_size.height(), m_format, handles,
+                                   strides, offsets, hasModifier ? modifiers : nullptr,
+                                   &m_bufferId, hasModifier ? DRM_MODE_FB_MODIFIERS : 0) != 0) {
+        qCDebug(KWIN_DRM) << "drmModeAddFB2WithModifiers failed for dmabuf";
+        m_bufferId = 0;
+    }
+}
+
+DrmDmabufBuffer::~DrmDmabufBuffer()
+{
+    if (m_bufferId) {
+        drmModeRmFB(fd(), m_bufferId);
+    }
+    releaseGbm();
+}
+
+void DrmDmabufBuffer::releaseGbm()
+{
+    // The framebuffer keeps its own reference on the memory.
+    if (m_bo) {
+        gbm_bo_destroy(m_bo);
+        m_bo = nullptr;
+    }
+}
+
 }
@@ -26,6 +26,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <memory>
 
 struct gbm_bo;
+struct gbm_device;
+
+namespace Wrapland::Server
+{
+class Buffer;
+}
 
 namespace KWin
 {
@@ -61,6 +67,29 @@ private:
     gbm_bo *m_bo = nullptr;
 };
 
+/**
+ * A client's dmabuf imported for direct scanout. The client buffer is referenced until the buffer
+ * is deleted, so the client can not render into it while it is shown.
+ */
+class DrmDmabufBuffer : public DrmBuffer
+{
+public:
+    DrmDmabufBuffer(int fd, gbm_device *device,
+                    const std::shared_ptr<Wrapland::Server::Buffer> &buffer);
+    ~DrmDmabufBuffer() override;
+
+    uint32_t format() const {
+        return m_format;
+    }
+
+    void releaseGbm() override;
+
+private:
+    std::shared_ptr<Wrapland::Server::Buffer> m_buffer;
+    gbm_bo *m_bo = nullptr;
+    uint32_t m_format = 0;
+};
+
 }
 
 #endif
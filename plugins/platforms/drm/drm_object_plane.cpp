@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "drm_pointer.h"
 #include "logging.h"
 
+#include <drm_fourcc.h>
+
 namespace KWin
 {
 
@@ -57,18 +59,66 @@ bool DrmPlane::atomicInit()
     if (!initProps()) {
         return false;
     }
+    initFormatModifiers();
     return true;
 }
 
+void DrmPlane::initFormatModifiers()
+{
+    auto property = m_props.at(int(PropertyIndex::InFormats));
+    if (!property) {
+        return;
+    }
+    DrmScopedPointer<drmModePropertyBlobRes> blob(drmModeGetPropertyBlob(fd(), property->value()));
+    if (!blob || blob->length < sizeof(drm_format_modifier_blob)) {
+        qCWarning(KWIN_DRM) << "Failed to get format modifiers of plane" << m_id;
+        return;
+    }
+
+    auto data = static_cast<const char*>(blob->data);
+    auto header = reinterpret_cast<const drm_format_modifier_blob*>(data);
+    auto formats = reinterpret_cast<const uint32_t*>(data + header->formats_offset);
+    auto modifiers = reinterpret_cast<const drm_format_modifier*>(data + header->modifiers_offset);
+
+    // Each modifier lists the formats it supports as a bit mask over 64 formats from its offset.
+    for (uint32_t i = 0; i < header->count_modifiers; i++) {
+        const auto &modifier = modifiers[i];
+        for (uint32_t bit = 0; bit < 64; bit++) {
+            const uint32_t index = modifier.offset + bit;
+            if (index >= header->count_formats) {
+                break;
+            }
+            if (modifier.formats & (uint64_t(1) << bit)) {
+                m_formatModifiers[formats[index]] << modifier.modifier;
+            }
+        }
+    }
+}
+
+bool DrmPlane::supportsFormat(uint32_t format, uint64_t modifier) const
+{
+    if (!supportsFormat(format)) {
+        return false;
+    }
+    if (modifier == DRM_FORMAT_MOD_INVALID) {
+        // The driver chooses the layout as for the buffers it allocates itself.
+        return true;
+    }
+    return m_formatModifiers.value(format).contains(modifier);
+}
+
 bool DrmPlane::atomicPopulate(drmModeAtomicReq *req) const
 {
-    return doAtomicPopulate(req, 1);
+    // Type, zpos and the format modifiers are only read.
+    return doAtomicPopulate(req, int(PropertyIndex::SrcX));
 }
 
 bool DrmPlane::initProps()
 {
     setPropertyNames( {
         QByteArrayLiteral("type"),
+        QByteArrayLiteral("zpos"),
+        QByteArrayLiteral("IN_FORMATS"),
         QByteArrayLiteral("SRC_X"),
         QByteArrayLiteral("SRC_Y"),
         QByteArrayLiteral("SRC_W"),
@@ -148,6 +198,14 @@ DrmPlane::TypeIndex DrmPlane::type()
     return TypeIndex::Overlay;
 }
 
+int DrmPlane::zpos() const
+{
+    if (auto property = m_props.at(int(PropertyIndex::Zpos))) {
+        return property->value();
+    }
+    return -1;
+}
+
 void DrmPlane::setNext(DrmBuffer *b)
 {
     if (auto property = m_props.at(int(PropertyIndex::FbId))) {
@@ -173,6 +231,26 @@ DrmPlane::Transformations DrmPlane::transformation()
     return Transformations(Transformation::Rotate0);
 }
 
+void DrmPlane::setScanout(uint32_t crtcId, const QRect &source, const QRect &target)
+{
+    // Source coordinates are 16.16 fixed point.
+    setValue(int(PropertyIndex::SrcX), source.x() << 16);
+    setValue(int(PropertyIndex::SrcY), source.y() << 16);
+    setValue(int(PropertyIndex::SrcW), source.width() << 16);
+    setValue(int(PropertyIndex::SrcH), source.height() << 16);
+    setValue(int(PropertyIndex::CrtcX), target.x());
+    setValue(int(PropertyIndex::CrtcY), target.y());
+    setValue(int(PropertyIndex::CrtcW), target.width());
+    setValue(int(PropertyIndex::CrtcH), target.height());
+    setValue(int(PropertyIndex::CrtcId), crtcId);
+}
+
+void DrmPlane::disable()
+{
+    setValue(int(PropertyIndex::FbId), 0);
+    setScanout(0, QRect(), QRect());
+}
+
 void DrmPlane::flipBuffer()
 {
     m_current = m_next;
@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "drm_object.h"
 
+#include <QMap>
+#include <QRect>
 #include <qobjectdefs.h>
 #include <xf86drmMode.h>
 
@@ -39,6 +41,8 @@ public:
 
     enum class PropertyIndex {
         Type = 0,
+        Zpos,
+        InFormats,
         SrcX,
         SrcY,
         SrcW,
@@ -83,6 +87,25 @@ public:
     QVector<uint32_t> formats() const {
         return m_formats;
     }
+    bool supportsFormat(uint32_t format) const {
+        return m_formats.contains(format);
+    }
+    /**
+     * Whether buffers of @p format with @p modifier can be presented. Buffers without an explicit
+     * modifier are supported with any format of the plane.
+     */
+    bool supportsFormat(uint32_t format, uint64_t modifier) const;
+    /**
+     * The modifiers each format can be presented with. Empty if the kernel does not list them.
+     */
+    QMap<uint32_t, QVector<uint64_t>> formatModifiers() const {
+        return m_formatModifiers;
+    }
+
+    /**
+     * Position of the plane in the stacking order of its CRTC, -1 if the kernel does not tell.
+     */
+    int zpos() const;
 
     DrmBuffer *current() const {
         return m_current;
@@ -97,6 +120,15 @@ public:
     void setTransformation(Transformations t);
     Transformations transformation();
 
+    /**
+     * Shows the @p source rect of the next buffer in @p target on the CRTC @p crtcId.
+     */
+    void setScanout(uint32_t crtcId, const QRect &source, const QRect &target);
+    /**
+     * Detaches the plane from its CRTC.
+     */
+    void disable();
+
     void flipBuffer();
     void flipBufferWithDelete();
 
@@ -107,11 +139,14 @@ public:
     bool atomicPopulate(drmModeAtomicReq *req) const override;
 
 private:
+    void initFormatModifiers();
+
     DrmBuffer *m_current = nullptr;
     DrmBuffer *m_next = nullptr;
 
     // TODO: See weston drm_output_check_plane_format for future use of these member variables
     QVector<uint32_t> m_formats;        // Possible formats, which can be presented on this plane
+    QMap<uint32_t, QVector<uint64_t>> m_formatModifiers;
 
     // TODO: when using overlay planes in the future: restrict possible screens / crtcs of planes
     uint32_t m_possibleCrtcs;
@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "main.h"
 #include "screens.h"
 #include "wayland_server.h"
+
 // Wrapland
 #include <Wrapland/Server/output.h>
 // KF5
@@ -54,6 +55,12 @@ DrmOutput::DrmOutput(DrmBackend *backend)
     , m_backend(backend)
 {
     connect(this, &DrmOutput::modeChanged, this, [this] { m_modesetRequested = true; });
+    connect(this, &DrmOutput::frameSkipped, this, [this] {
+        if (m_cursorDirty) {
+            // The cursor waited for a frame that is not coming.
+            commitCursorPlane();
+        }
+    });
 }
 
 DrmOutput::~DrmOutput()
@@ -83,13 +90,28 @@ void DrmOutput::teardown()
     if (m_cursorPlane) {
         m_cursorPlane->setOutput(nullptr);
     }
+    for (auto plane : m_overlayPlanes) {
+        plane->setOutput(nullptr);
+
+        if (m_backend->deleteBufferAfterPageFlip()) {
+            if (plane->next() != plane->current()) {
+                delete plane->next();
+            }
+            delete plane->current();
+        }
+        plane->setCurrent(nullptr);
+        plane->setNext(nullptr);
+    }
+    m_overlayAssignment.reset();
+    m_overlayPlanes.clear();
 
     m_crtc->setOutput(nullptr);
     m_conn->setOutput(nullptr);
 
     m_cursor[0].reset(nullptr);
     m_cursor[1].reset(nullptr);
-    if (!m_pageFlipPending) {
+    m_cursorPlaneBuffer = nullptr;
+    if (!m_pageFlipPending && !m_cursorCommitPending) {
         deleteLater();
     } //else will be deleted in the page flip handler
     //this is needed so that the pageflipcallback handle isn't deleted
@@ -107,11 +129,21 @@ void DrmOutput::releaseGbm()
 
 bool DrmOutput::hideCursor()
 {
+    if (m_cursorPlane) {
+        m_cursorPlaneBuffer = nullptr;
+        commitCursorPlane();
+        return true;
+    }
     return drmModeSetCursor(m_backend->fd(), m_crtc->id(), 0, 0, 0) == 0;
 }
 
 bool DrmOutput::showCursor(DrmDumbBuffer *c)
 {
+    if (m_cursorPlane) {
+        m_cursorPlaneBuffer = c;
+        commitCursorPlane();
+        return true;
+    }
     const QSize &s = c->size();
     return drmModeSetCursor(m_backend->fd(), m_crtc->id(), c->handle(), s.width(), s.height()) == 0;
 }
@@ -230,9 +262,93 @@ void DrmOutput::moveCursor(const QPoint &globalPos)
     }
 
     pos -= hotspotMatrix.map(m_backend->softwareCursorHotspot());
+
+    if (m_cursorPlane) {
+        m_cursorPlanePos = pos;
+        commitCursorPlane();
+        return;
+    }
     drmModeMoveCursor(m_backend->fd(), m_crtc->id(), pos.x(), pos.y());
 }
 
+bool DrmOutput::populateCursorPlane(drmModeAtomicReq *req)
+{
+    if (m_cursorPlaneBuffer && m_dpmsModePending == DpmsMode::On) {
+        const QSize size = m_cursorPlaneBuffer->size();
+        m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::FbId),
+                                m_cursorPlaneBuffer->bufferId());
+        m_cursorPlane->setScanout(m_crtc->id(), QRect(QPoint(), size),
+                                  QRect(m_cursorPlanePos, size));
+    } else {
+        m_cursorPlane->disable();
+    }
+    return m_cursorPlane->atomicPopulate(req);
+}
+
+void DrmOutput::commitCursorPlane()
+{
+    m_cursorDirty = true;
+
+    // Only one nonblocking commit can be in flight on a CRTC. While a frame or a previous cursor
+    // update waits for the vblank the new state is sent with the next commit, the latest one wins.
+    if (m_deleted || m_pageFlipPending || m_cursorCommitPending || m_modesetRequested
+            || m_dpmsModePending != DpmsMode::On || !kwinApp()->session()->isActiveSession()) {
+        return;
+    }
+    if (frameScheduled()) {
+        // The cursor goes out with the frame. Otherwise the cursor-only commit would make the
+        // frame wait for the next vblank.
+        return;
+    }
+
+    DrmScopedPointer<drmModeAtomicReq> req(drmModeAtomicAlloc());
+    if (!req || !populateCursorPlane(req.data())) {
+        qCWarning(KWIN_DRM) << "Failed to populate atomic cursor plane.";
+        return;
+    }
+
+    // The event tells when the next commit on the CRTC is possible again.
+    if (drmModeAtomicCommit(m_backend->fd(), req.data(),
+                            DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, this) != 0) {
+        qCWarning(KWIN_DRM) << "Atomic cursor commit failed:" << strerror(errno);
+        return;
+    }
+    m_cursorDirty = false;
+    m_cursorCommitPending = true;
+}
+
+bool DrmOutput::frameScheduled() const
+{
+    auto compositor = Compositor::self();
+    return compositor && compositor->is_frame_scheduled(const_cast<DrmOutput*>(this));
+}
+
+bool DrmOutput::cursorCommitted()
+{
+    m_cursorCommitPending = false;
+
+    DrmBuffer *buffer = m_deferredBuffer;
+    m_deferredBuffer = nullptr;
+    if (buffer) {
+        m_pageFlipPending = false;
+        if (!m_deleted && present(buffer)) {
+            return true;
+        }
+        if (m_backend->deleteBufferAfterPageFlip()) {
+            delete buffer;
+        }
+    }
+
+    if (m_deleted) {
+        deleteLater();
+    } else if (m_atomicOffPending) {
+        dpmsAtomicOff();
+    } else if (m_cursorDirty) {
+        commitCursorPlane();
+    }
+    return !buffer;
+}
+
 namespace {
 quint64 refreshRateForMode(_drmModeModeInfo *m)
 {
@@ -261,6 +377,7 @@ bool DrmOutput::init(drmModeConnector *connector)
         if (!initPrimaryPlane()) {
             return false;
         }
+        initCursorPlane();
     }
 
     setInternal(connector->connector_type == DRM_MODE_CONNECTOR_LVDS || connector->connector_type == DRM_MODE_CONNECTOR_eDP
@@ -452,8 +569,11 @@ bool DrmOutput::initPrimaryPlane()
     return false;
 }
 
-bool DrmOutput::initCursorPlane()       // TODO: Add call in init (but needs layer support in general first)
+bool DrmOutput::initCursorPlane()
 {
+    if (qEnvironmentVariableIsSet("KWIN_DRM_NO_CURSOR_PLANE")) {
+        return false;
+    }
     for (int i = 0; i < m_backend->planes().size(); ++i) {
         DrmPlane* p = m_backend->planes()[i];
         if (!p) {
@@ -479,10 +599,123 @@ bool DrmOutput::initCursorPlane()       // TODO: Add call in init (but needs lay
     return false;
 }
 
+void DrmOutput::claimOverlayPlanes()
+{
+    if (qEnvironmentVariableIsSet("KWIN_DRM_NO_OVERLAY_PLANES")) {
+        return;
+    }
+    bool claimed = false;
+    for (auto plane : m_backend->overlayPlanes()) {
+        // Planes of other outputs are released by them once they show nothing anymore.
+        if (plane->output() || !plane->isCrtcSupported(m_crtc->resIndex())) {
+            continue;
+        }
+        plane->setOutput(this);
+        m_overlayPlanes << plane;
+        claimed = true;
+    }
+    if (claimed) {
+        m_overlayAssignment.reset(new DrmPlaneAssignment(m_crtc->id(), m_overlayPlanes));
+        qCDebug(KWIN_DRM) << "Claimed" << m_overlayAssignment->planes().size()
+                          << "overlay planes on CRTC" << m_crtc->id();
+    }
+}
+
+void DrmOutput::releaseOverlayPlanes()
+{
+    bool released = false;
+    for (auto it = m_overlayPlanes.begin(); it != m_overlayPlanes.end();) {
+        auto plane = *it;
+        if (plane->current() || plane->next()) {
+            ++it;
+            continue;
+        }
+        plane->setOutput(nullptr);
+        it = m_overlayPlanes.erase(it);
+        released = true;
+    }
+    if (!released) {
+        return;
+    }
+    if (m_overlayPlanes.isEmpty()) {
+        m_overlayAssignment.reset();
+    } else {
+        m_overlayAssignment.reset(new DrmPlaneAssignment(m_crtc->id(), m_overlayPlanes));
+    }
+}
+
+int DrmOutput::setOverlayLayers(const QVector<DrmLayer> &layers)
+{
+    if (!m_backend->atomicModeSetting() || !m_backend->deleteBufferAfterPageFlip()
+            || m_pageFlipPending) {
+        return 0;
+    }
+
+    disableOverlayPlanes();
+    m_overlayLayersSet = true;
+
+    if (layers.isEmpty() || m_modesetRequested || m_dpmsModePending != DpmsMode::On
+            || !m_primaryPlane->current() || transform() != Transform::Normal) {
+        return 0;
+    }
+
+    claimOverlayPlanes();
+    if (!m_overlayAssignment) {
+        return 0;
+    }
+    return m_overlayAssignment->assign(layers, [this] { return testPlanes(m_overlayPlanes); });
+}
+
+bool DrmOutput::testScanout(DrmBuffer *buffer)
+{
+    if (!m_primaryPlane || !m_backend->deleteBufferAfterPageFlip()
+            || m_pageFlipPending || m_modesetRequested || m_dpmsModePending != DpmsMode::On
+            || transform() != Transform::Normal) {
+        return false;
+    }
+    if (!buffer->bufferId() || buffer->size() != QSize(m_mode.hdisplay, m_mode.vdisplay)) {
+        return false;
+    }
+
+    // The buffer is only set for the test. It is presented like a composited one afterwards.
+    m_primaryPlane->setNext(buffer);
+    const bool supported = testPlanes({m_primaryPlane});
+    m_primaryPlane->setNext(nullptr);
+    return supported;
+}
+
+bool DrmOutput::testPlanes(const QVector<DrmPlane*> &planes) const
+{
+    // The other objects of the output are tested in their current state.
+    DrmScopedPointer<drmModeAtomicReq> req(drmModeAtomicAlloc());
+    if (!req) {
+        return false;
+    }
+    for (auto plane : planes) {
+        if (!plane->atomicPopulate(req.data())) {
+            return false;
+        }
+    }
+    return drmModeAtomicCommit(m_backend->fd(), req.data(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+void DrmOutput::disableOverlayPlanes()
+{
+    for (auto plane : m_overlayPlanes) {
+        // A buffer that was assigned but never presented.
+        if (plane->next() != plane->current()) {
+            delete plane->next();
+        }
+        plane->setNext(nullptr);
+        plane->disable();
+    }
+}
+
 bool DrmOutput::initCursor(const QSize &cursorSize)
 {
     auto createCursor = [this, cursorSize] (int index) {
-        m_cursor[index].reset(m_backend->createBuffer(cursorSize));
+        // With alpha for the cursor plane, legacy cursors ignore the framebuffer format.
+        m_cursor[index].reset(m_backend->createBuffer(cursorSize, DRM_FORMAT_ARGB8888));
         if (!m_cursor[index]->map(QImage::Format_ARGB32_Premultiplied)) {
             return false;
         }
@@ -759,6 +992,7 @@ void DrmOutput::pageFlipped()
     if (!m_crtc) {
         return;
     }
+
     // Egl based surface buffers get destroyed, QPainter based dumb buffers not
     // TODO: split up DrmOutput in two for dumb and egl/gbm surface buffer compatible subclasses completely?
     if (m_backend->deleteBufferAfterPageFlip()) {
@@ -777,6 +1011,7 @@ void DrmOutput::pageFlipped()
                 p->flipBufferWithDelete();
             }
             m_nextPlanesFlipList.clear();
+            releaseOverlayPlanes();
         } else {
             if (!m_crtc->next()) {
                 // on manual vt switch
@@ -819,11 +1054,17 @@ bool DrmOutput::dpmsAtomicOff()
 {
     m_atomicOffPending = false;
 
-    // TODO: With multiple planes: deactivate all of them here
     delete m_primaryPlane->next();
     m_primaryPlane->setNext(nullptr);
     m_nextPlanesFlipList << m_primaryPlane;
 
+    disableOverlayPlanes();
+    for (auto plane : m_overlayPlanes) {
+        if (plane->current()) {
+            m_nextPlanesFlipList << plane;
+        }
+    }
+
     if (!doAtomicCommit(AtomicCommitMode::Test)) {
         qCDebug(KWIN_DRM) << "Atomic test commit to Dpms Off failed. Aborting.";
         return false;
@@ -832,7 +1073,12 @@ bool DrmOutput::dpmsAtomicOff()
         qCDebug(KWIN_DRM) << "Atomic commit to Dpms Off failed. This should have never happened! Aborting.";
         return false;
     }
+    for (auto plane : m_overlayPlanes) {
+        // No page flip event follows, the buffers are not shown anymore.
+        plane->flipBufferWithDelete();
+    }
     m_nextPlanesFlipList.clear();
+    releaseOverlayPlanes();
     dpmsFinishOff();
 
     return true;
@@ -859,9 +1105,28 @@ bool DrmOutput::presentAtomically(DrmBuffer *buffer)
     }
 #endif
 
+    if (m_cursorCommitPending) {
+        // The CRTC is busy with a cursor update. The frame is committed once it completed.
+        m_deferredBuffer = buffer;
+        m_pageFlipPending = true;
+        return true;
+    }
+
     m_primaryPlane->setNext(buffer);
     m_nextPlanesFlipList << m_primaryPlane;
 
+    if (!m_overlayLayersSet) {
+        // Everything was composited.
+        disableOverlayPlanes();
+    }
+    m_overlayLayersSet = false;
+    for (auto plane : m_overlayPlanes) {
+        // Planes that get a new layer or that are disabled after showing one.
+        if (plane->next() || plane->current()) {
+            m_nextPlanesFlipList << plane;
+        }
+    }
+
     if (!doAtomicCommit(AtomicCommitMode::Test)) {
         //TODO: When we use planes for layered rendering, fallback to renderer instead. Also for direct scanout?
         //TODO: Probably should undo setNext and reset the flip list
@@ -963,6 +1228,10 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
 
         // TODO: see above, rework later for overlay planes!
         for (DrmPlane *p : m_nextPlanesFlipList) {
+            if (m_overlayPlanes.contains(p) && p->next() != p->current()) {
+                // The output owns the buffers of layers.
+                delete p->next();
+            }
             p->setNext(nullptr);
         }
         m_nextPlanesFlipList.clear();
@@ -1018,6 +1287,13 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
         DrmPlane *p = m_nextPlanesFlipList[i];
         ret &= p->atomicPopulate(req);
     }
+    // Pending cursor changes go with the frame. Modesets always carry the cursor state since it
+    // depends on the DPMS mode.
+    const bool withCursor = m_cursorPlane
+        && (m_cursorDirty || (flags & DRM_MODE_ATOMIC_ALLOW_MODESET));
+    if (withCursor) {
+        ret &= populateCursorPlane(req);
+    }
 
     if (!ret) {
         qCWarning(KWIN_DRM) << "Failed to populate atomic planes. Abort atomic commit!";
@@ -1035,6 +1311,9 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
         qCDebug(KWIN_DRM) << "Atomic Modeset successful.";
         m_modesetRequested = false;
     }
+    if (mode == AtomicCommitMode::Real && withCursor) {
+        m_cursorDirty = false;
+    }
 
     drmModeAtomicFree(req);
     return true;
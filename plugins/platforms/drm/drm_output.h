@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "drm_pointer.h"
 #include "drm_object.h"
 #include "drm_object_plane.h"
+#include "drm_plane_assignment.h"
 #include "edid.h"
 
 #include <QObject>
@@ -60,6 +61,22 @@ public:
     bool present(DrmBuffer *buffer);
     void pageFlipped();
 
+    /**
+     * Tries to show @p layers, ordered from top to bottom, on overlay planes with the next present.
+     * The output takes ownership of the buffers of layers put on a plane. All other layers must be
+     * composited. Free overlay planes are claimed for this and released again once they show
+     * nothing anymore.
+     *
+     * @return the number of layers from the top that were put on a plane
+     */
+    int setOverlayLayers(const QVector<DrmLayer> &layers);
+
+    /**
+     * Tests whether @p buffer can be presented on the primary plane as it is, instead of a
+     * composited buffer. The buffer must have the size of the mode.
+     */
+    bool testScanout(DrmBuffer *buffer);
+
     const DrmCrtc *crtc() const {
         return m_crtc;
     }
@@ -115,6 +132,10 @@ private:
     void initUuid();
     bool initPrimaryPlane();
     bool initCursorPlane();
+    void claimOverlayPlanes();
+    void releaseOverlayPlanes();
+    bool testPlanes(const QVector<DrmPlane*> &planes) const;
+    void disableOverlayPlanes();
 
     void atomicEnable();
     void atomicDisable();
@@ -127,6 +148,22 @@ private:
     void dpmsFinishOff();
 
     bool atomicReqModesetPopulate(drmModeAtomicReq *req, bool enable);
+    bool populateCursorPlane(drmModeAtomicReq *req);
+    /**
+     * Sends the cursor state on its own, or with the next commit if the CRTC is busy or a frame
+     * is about to be presented.
+     */
+    void commitCursorPlane();
+    /**
+     * Whether the compositor presents a frame on the output soon, i.e. a frame waits for its page
+     * flip or the next paint is scheduled.
+     */
+    bool frameScheduled() const;
+    /**
+     * Called on completion of a cursor-only commit. Returns false if a frame deferred meanwhile
+     * could not be committed and was dropped.
+     */
+    bool cursorCommitted();
     void updateDpms(DpmsMode mode) override;
     void updateMode(int modeIndex) override;
     void setWaylandMode(bool force_update);
@@ -150,6 +187,9 @@ private:
     uint32_t m_blobId = 0;
     DrmPlane* m_primaryPlane = nullptr;
     DrmPlane* m_cursorPlane = nullptr;
+    QVector<DrmPlane*> m_overlayPlanes;
+    QScopedPointer<DrmPlaneAssignment> m_overlayAssignment;
+    bool m_overlayLayersSet = false;
     QVector<DrmPlane*> m_nextPlanesFlipList;
     bool m_pageFlipPending = false;
     bool m_atomicOffPending = false;
@@ -167,6 +207,13 @@ private:
     QScopedPointer<DrmDumbBuffer> m_cursor[2];
     int m_cursorIndex = 0;
     bool m_hasNewCursor = false;
+    // Cursor state shown on the cursor plane, not owned.
+    DrmDumbBuffer *m_cursorPlaneBuffer = nullptr;
+    QPoint m_cursorPlanePos;
+    bool m_cursorDirty = false;
+    bool m_cursorCommitPending = false;
+    // Frame presented while a cursor-only commit was pending.
+    DrmBuffer *m_deferredBuffer = nullptr;
     bool m_deleted = false;
 };
 
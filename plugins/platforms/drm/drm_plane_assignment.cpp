@@ -0,0 +1,72 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "drm_plane_assignment.h"
+
+#include "drm_object_plane.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+DrmPlaneAssignment::DrmPlaneAssignment(uint32_t crtcId, const QVector<DrmPlane*> &planes)
+    : m_crtcId(crtcId)
+    , m_planes(planes)
+{
+    std::stable_sort(m_planes.begin(), m_planes.end(), [](DrmPlane *a, DrmPlane *b) {
+        return a->zpos() > b->zpos();
+    });
+
+    const bool stackingKnown = std::all_of(m_planes.cbegin(), m_planes.cend(),
+                                           [](DrmPlane *plane) { return plane->zpos() >= 0; });
+    if (!stackingKnown && m_planes.size() > 1) {
+        // Layers could end up in the wrong order. Use only one plane, which is always above the
+        // primary plane.
+        m_planes.resize(1);
+    }
+}
+
+int DrmPlaneAssignment::assign(const QVector<DrmLayer> &layers, const std::function<bool()> &test)
+{
+    m_assigned.clear();
+    for (auto plane : m_planes) {
+        plane->setNext(nullptr);
+        plane->disable();
+    }
+
+    // Index of the top-most plane that is still free. Planes above the last assigned one are
+    // skipped, since a layer put on them would be above the layers before it.
+    int nextPlane = 0;
+
+    for (const auto &layer : layers) {
+        bool assigned = false;
+
+        while (!assigned && nextPlane < m_planes.size()) {
+            auto plane = m_planes.at(nextPlane++);
+            if (!plane->supportsFormat(layer.format)) {
+                continue;
+            }
+
+            plane->setNext(layer.buffer);
+            plane->setScanout(m_crtcId, layer.source, layer.target);
+            if (test()) {
+                m_assigned << plane;
+                assigned = true;
+            } else {
+                plane->setNext(nullptr);
+                plane->disable();
+            }
+        }
+
+        if (!assigned) {
+            break;
+        }
+    }
+
+    return m_assigned.size();
+}
+
+}
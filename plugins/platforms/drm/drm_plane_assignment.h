@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QRect>
+#include <QVector>
+
+#include <functional>
+
+namespace KWin
+{
+
+class DrmBuffer;
+class DrmPlane;
+
+/**
+ * A buffer that can be shown on a plane instead of being composited.
+ */
+struct DrmLayer {
+    DrmBuffer *buffer = nullptr;
+    // DRM fourcc code of the buffer's format.
+    uint32_t format = 0;
+    // The part of the buffer that is shown, in buffer pixels.
+    QRect source;
+    // Where the buffer is shown, in pixels of the CRTC.
+    QRect target;
+};
+
+/**
+ * Assigns layers to the overlay planes of a CRTC.
+ *
+ * Layers are assigned from the top. Each assignment is checked with a test-only commit. If a layer
+ * can not be put on any of the remaining planes, it and all layers below it must be composited on
+ * the primary plane. Otherwise they would end up above layers on overlay planes.
+ */
+class DrmPlaneAssignment
+{
+public:
+    DrmPlaneAssignment(uint32_t crtcId, const QVector<DrmPlane*> &planes);
+
+    /**
+     * Puts the buffers of @p layers, ordered from top to bottom, on the planes. Planes without a
+     * layer are disabled. After every change @p test is called, which must return whether the
+     * current state of the planes is supported by the hardware.
+     *
+     * @return the number of layers from the top that were put on a plane
+     */
+    int assign(const QVector<DrmLayer> &layers, const std::function<bool()> &test);
+
+    /**
+     * The planes with a layer from the last assignment, in the order of the layers.
+     */
+    QVector<DrmPlane*> assignedPlanes() const {
+        return m_assigned;
+    }
+
+    /**
+     * The planes used for assignments, ordered from top to bottom.
+     */
+    QVector<DrmPlane*> planes() const {
+        return m_planes;
+    }
+
+private:
+    uint32_t m_crtcId;
+    QVector<DrmPlane*> m_planes;
+    QVector<DrmPlane*> m_assigned;
+};
+
+}
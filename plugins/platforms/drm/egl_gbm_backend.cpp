@@ -21,15 +21,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // kwin
 #include "composite.h"
 #include "drm_backend.h"
+#include "drm_object_plane.h"
 #include "drm_output.h"
 #include "gbm_surface.h"
+#include "linux_dmabuf.h"
 #include "logging.h"
 #include "options.h"
 #include "screens.h"
+#include "toplevel.h"
+
+#include "win/geo.h"
 // kwin libs
 #include <kwinglplatform.h>
 // Qt
 #include <QOpenGLContext>
+// Wrapland
+#include <Wrapland/Server/buffer.h>
+#include <Wrapland/Server/surface.h>
 // system
 #include <gbm.h>
 
@@ -45,9 +53,11 @@ EglGbmBackend::EglGbmBackend(DrmBackend *drmBackend)
 
     connect(m_backend, &DrmBackend::output_added, this, [this](auto output) {
         createOutput(static_cast<DrmOutput*>(output));
+        updateDmabufFormats();
     });
     connect(m_backend, &DrmBackend::output_removed, this, [this](auto output) {
         removeOutput(static_cast<DrmOutput*>(output));
+        updateDmabufFormats();
     });
 }
 
@@ -527,6 +537,109 @@ QRegion EglGbmBackend::prepareRenderingForScreen(AbstractOutput* output)
     return region;
 }
 
+bool EglGbmBackend::directScanout(AbstractOutput* output, Toplevel* window)
+{
+    auto& out = get_output(output);
+
+    auto buffer = window->surface()->buffer();
+    if (!buffer || !buffer->linuxDmabufBuffer()) {
+        return false;
+    }
+    auto dmabuf = static_cast<DmabufBuffer*>(buffer->linuxDmabufBuffer());
+    auto plane = out.output->primaryPlane();
+    if (!plane || dmabuf->planes().isEmpty()
+            || !plane->supportsFormat(dmabuf->format(), dmabuf->planes().first().modifier)) {
+        return false;
+    }
+
+    // Everything else the kernel might reject is validated by the test commit.
+    auto drmBuffer = m_backend->createBuffer(buffer);
+    if (!out.output->testScanout(drmBuffer)) {
+        delete drmBuffer;
+        return false;
+    }
+
+    // On failure the buffer has been deleted already.
+    if (!m_backend->present(drmBuffer, out.output)) {
+        return false;
+    }
+
+    // The back buffers of the surface do not contain what was shown in the meantime. The next
+    // composited frame must be painted fully.
+    out.bufferAge = 0;
+    out.damageHistory.clear();
+    return true;
+}
+
+int EglGbmBackend::overlayScanout(AbstractOutput* output, std::deque<Toplevel*> const& windows)
+{
+    auto& out = get_output(output);
+    auto const origin = output->geometry().topLeft();
+
+    QVector<DrmLayer> layers;
+    for (auto window : windows) {
+        auto buffer = window->surface()->buffer();
+        if (!buffer || !buffer->linuxDmabufBuffer()) {
+            break;
+        }
+        auto const target = win::render_geometry(window).translated(-origin);
+
+        auto drmBuffer = m_backend->createBuffer(buffer);
+        if (!drmBuffer->bufferId() || drmBuffer->size() != target.size()) {
+            delete drmBuffer;
+            break;
+        }
+        layers.append({drmBuffer, drmBuffer->format(), QRect(QPoint(), drmBuffer->size()), target});
+    }
+
+    // The output owns the buffers of layers put on planes.
+    const int count = out.output->setOverlayLayers(layers);
+    for (int i = count; i < layers.size(); i++) {
+        delete layers.at(i).buffer;
+    }
+    return count;
+}
+
+QHash<uint32_t, QSet<uint64_t>> EglGbmBackend::scanoutFormats() const
+{
+    // Without atomic mode setting, e.g. with KWIN_DRM_NO_AMS, nothing is scanned out directly.
+    if (!m_backend->atomicModeSetting()
+            || qEnvironmentVariableIsSet("KWIN_DRM_NO_SCANOUT_MODIFIERS")) {
+        return {};
+    }
+
+    QHash<uint32_t, QSet<uint64_t>> formats;
+
+    for (auto it = m_outputs.cbegin(); it != m_outputs.cend(); ++it) {
+        auto plane = it->output->primaryPlane();
+        if (!plane) {
+            return {};
+        }
+
+        QHash<uint32_t, QSet<uint64_t>> planeFormats;
+        const auto modifiers = plane->formatModifiers();
+        for (auto mod = modifiers.cbegin(); mod != modifiers.cend(); ++mod) {
+            planeFormats.insert(mod.key(), QSet<uint64_t>(mod->cbegin(), mod->cend()));
+        }
+
+        if (it == m_outputs.cbegin()) {
+            formats = planeFormats;
+            continue;
+        }
+        // A fullscreen window can move to any of the outputs.
+        for (auto format = formats.begin(); format != formats.end();) {
+            *format &= planeFormats.value(format.key());
+            if (format->isEmpty()) {
+                format = formats.erase(format);
+            } else {
+                ++format;
+            }
+        }
+    }
+
+    return formats;
+}
+
 void EglGbmBackend::endRenderingFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     Q_UNUSED(renderedRegion)
@@ -48,6 +48,9 @@ public:
     void endRenderingFrameForScreen(AbstractOutput* output, const QRegion &damage, const QRegion &damagedRegion) override;
     bool usesOverlayWindow() const override;
     QRegion prepareRenderingForScreen(AbstractOutput* output) override;
+    bool directScanout(AbstractOutput* output, Toplevel* window) override;
+    int overlayScanout(AbstractOutput* output, std::deque<Toplevel*> const& windows) override;
+    QHash<uint32_t, QSet<uint64_t>> scanoutFormats() const override;
     void init() override;
 
 protected:
@@ -89,7 +89,9 @@ void DrmQPainterBackend::initOutput(DrmOutput *output)
                 if (it->buffer[index]->map()) {
                     it->buffer[index]->image()->fill(Qt::black);
                 }
+                it->age[index] = 0;
             };
+            it->damageHistory.clear();
             initBuffer(0);
             initBuffer(1);
         }
@@ -111,6 +113,11 @@ DrmQPainterBackend::Output& DrmQPainterBackend::get_output(AbstractOutput* outpu
     return m_outputs[0];
 }
 
+DrmQPainterBackend::Output const& DrmQPainterBackend::get_output(AbstractOutput* output) const
+{
+    return const_cast<DrmQPainterBackend*>(this)->get_output(output);
+}
+
 QImage *DrmQPainterBackend::buffer()
 {
     return bufferForScreen(0);
@@ -124,25 +131,56 @@ QImage *DrmQPainterBackend::bufferForScreen(AbstractOutput* output)
 
 bool DrmQPainterBackend::needsFullRepaint() const
 {
-    return true;
+    return false;
 }
 
-void DrmQPainterBackend::prepareRenderingFrame()
+QRegion DrmQPainterBackend::bufferDamage(AbstractOutput* output) const
 {
-    for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
-        (*it).index = ((*it).index + 1) % 2;
+    auto const& out = get_output(output);
+    auto const age = out.age[out.index];
+
+    if (age == 0 || age > out.damageHistory.count() + 1) {
+        // The content is undefined or older than the recorded damage.
+        return output->geometry();
     }
+
+    QRegion region;
+    for (int i = 0; i < age - 1; i++) {
+        region |= out.damageHistory[i];
+    }
+    return region;
+}
+
+void DrmQPainterBackend::prepareRenderingFrame()
+{
+    // The buffers are swapped per output on present.
 }
 
 void DrmQPainterBackend::present(AbstractOutput* output, const QRegion &damage)
 {
-    Q_UNUSED(damage)
+    auto& out = get_output(output);
+
     if (!kwinApp()->session()->isActiveSession()) {
+        // Nothing is shown and the next frame after resuming is repainted fully anyway.
+        out.age[0] = out.age[1] = 0;
+        out.damageHistory.clear();
         return;
     }
 
-    auto const& out = get_output(output);
     m_backend->present(out.buffer[out.index], out.output);
+
+    if (out.damageHistory.count() >= 10) {
+        out.damageHistory.removeLast();
+    }
+    out.damageHistory.prepend(damage.intersected(output->geometry()));
+
+    // The presented buffer holds the latest frame now, the other one gets a frame older.
+    auto const other = (out.index + 1) % 2;
+    out.age[out.index] = 1;
+    if (out.age[other] > 0) {
+        out.age[other]++;
+    }
+    out.index = other;
 }
 
 }
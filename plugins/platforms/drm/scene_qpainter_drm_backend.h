@@ -20,7 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef KWIN_SCENE_QPAINTER_DRM_BACKEND_H
 #define KWIN_SCENE_QPAINTER_DRM_BACKEND_H
 #include <platformsupport/scenes/qpainter/backend.h>
+#include <QList>
 #include <QObject>
+#include <QRegion>
 #include <QVector>
 
 namespace KWin
@@ -40,6 +42,7 @@ public:
     QImage *buffer() override;
     QImage *bufferForScreen(AbstractOutput* output) override;
     bool needsFullRepaint() const override;
+    QRegion bufferDamage(AbstractOutput* output) const override;
     void prepareRenderingFrame() override;
     void present(AbstractOutput* output, const QRegion &damage) override;
 
@@ -47,10 +50,15 @@ private:
     void initOutput(DrmOutput *output);
     struct Output {
         DrmDumbBuffer *buffer[2];
+        // Number of frames since the buffer was presented, 0 if its content is undefined.
+        int age[2] = {0, 0};
         DrmOutput *output;
         int index = 0;
+        // Damage of the last presented frames, the most recent first.
+        QList<QRegion> damageHistory;
     };
     Output& get_output(AbstractOutput* output);
+    Output const& get_output(AbstractOutput* output) const;
 
     QVector<Output> m_outputs;
     DrmBackend *m_backend;
@@ -51,6 +51,8 @@ FramebufferQPainterBackend::FramebufferQPainterBackend(FramebufferBackend *backe
         [this] (bool active) {
             auto compositor = static_cast<WaylandCompositor*>(Compositor::self());
             if (active) {
+                // Another terminal might have drawn to the framebuffer meanwhile.
+                m_needsFullRepaint = true;
                 compositor->addRepaintFull();
             } else {
                 compositor->outputs.begin()->second->swap_pending = true;
@@ -80,20 +82,34 @@ bool FramebufferQPainterBackend::needsFullRepaint() const
 
 void FramebufferQPainterBackend::prepareRenderingFrame()
 {
-    m_needsFullRepaint = true;
+    // The render buffer persists between frames, so only the damage must be repainted.
 }
 
 void FramebufferQPainterBackend::present(AbstractOutput* output, const QRegion &damage)
 {
-    Q_UNUSED(damage)
+    Q_UNUSED(output)
 
     if (!kwinApp()->session()->isActiveSession()) {
         return;
     }
-    m_needsFullRepaint = false;
 
     QPainter p(&m_backBuffer);
-    p.drawImage(QPoint(0, 0), m_backend->isBGR() ? m_renderBuffer.rgbSwapped() : m_renderBuffer);
+
+    if (m_needsFullRepaint) {
+        m_needsFullRepaint = false;
+        p.drawImage(QPoint(0, 0),
+                    m_backend->isBGR() ? m_renderBuffer.rgbSwapped() : m_renderBuffer);
+        return;
+    }
+
+    // Only copy what changed in the render buffer.
+    for (auto const& rect : damage.intersected(m_renderBuffer.rect())) {
+        if (m_backend->isBGR()) {
+            p.drawImage(rect.topLeft(), m_renderBuffer.copy(rect).rgbSwapped());
+        } else {
+            p.drawImage(rect.topLeft(), m_renderBuffer, rect);
+        }
+    }
 }
 
 }
@@ -0,0 +1,182 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "decoration_atlas.h"
+
+#include <kwingltexture.h>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+namespace
+{
+
+// Holds about ten decorations of maximized windows on a 4K screen.
+constexpr int s_pageWidth = 4096;
+constexpr int s_pageHeight = 512;
+
+// Allocations are put on shelves at most this fraction higher than them.
+constexpr int s_shelfSlackDivisor = 4;
+
+}
+
+DecorationAtlas::DecorationAtlas()
+{
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    m_pageSize = QSize(s_pageWidth, s_pageHeight);
+    if (maxSize > 0) {
+        m_pageSize = m_pageSize.boundedTo(QSize(maxSize, maxSize));
+    }
+}
+
+DecorationAtlas::~DecorationAtlas() = default;
+
+DecorationAtlas::Slot DecorationAtlas::allocate(const QSize &size)
+{
+    if (size.isEmpty()) {
+        return {};
+    }
+
+    QRect rect;
+    for (auto const &page : m_pages) {
+        if (allocateOnPage(*page, size, rect)) {
+            return {page->texture.get(), rect};
+        }
+    }
+
+    const bool oversized = size.width() > m_pageSize.width()
+        || size.height() > m_pageSize.height();
+    auto page = createPage(oversized ? size : m_pageSize);
+    if (!page || !allocateOnPage(*page, size, rect)) {
+        return {};
+    }
+    m_pages.push_back(std::move(page));
+    return {m_pages.back()->texture.get(), rect};
+}
+
+void DecorationAtlas::release(const Slot &slot)
+{
+    auto it = std::find_if(m_pages.begin(), m_pages.end(), [&slot](auto const &page) {
+        return page->texture.get() == slot.texture;
+    });
+    if (it == m_pages.end()) {
+        return;
+    }
+
+    releaseOnPage(**it, slot.rect);
+
+    // The first page is kept to not recreate it when windows are closed and opened one by one.
+    if (!(*it)->allocations && it != m_pages.begin()) {
+        m_pages.erase(it);
+    }
+}
+
+std::unique_ptr<DecorationAtlas::Page> DecorationAtlas::createPage(const QSize &size) const
+{
+    auto page = std::make_unique<Page>();
+    page->texture.reset(new GLTexture(GL_RGBA8, size.width(), size.height()));
+    if (page->texture->isNull()) {
+        return nullptr;
+    }
+    page->texture->setYInverted(true);
+    page->texture->setWrapMode(GL_CLAMP_TO_EDGE);
+    page->texture->clear();
+    return page;
+}
+
+bool DecorationAtlas::allocateOnPage(Page &page, const QSize &size, QRect &rect) const
+{
+    const int maxShelfHeight = size.height() + size.height() / s_shelfSlackDivisor;
+
+    // The lowest shelf with room for the size.
+    Shelf *shelf = nullptr;
+    size_t spanIndex = 0;
+
+    for (auto &candidate : page.shelves) {
+        if (candidate.height < size.height() || candidate.height > maxShelfHeight) {
+            continue;
+        }
+        if (shelf && shelf->height <= candidate.height) {
+            continue;
+        }
+        auto span = std::find_if(candidate.free.cbegin(), candidate.free.cend(),
+                                 [&size](const Span &span) { return span.width >= size.width(); });
+        if (span != candidate.free.cend()) {
+            shelf = &candidate;
+            spanIndex = span - candidate.free.cbegin();
+        }
+    }
+
+    if (!shelf) {
+        const QSize pageSize = page.texture->size();
+        if (size.width() > pageSize.width()
+                || page.shelvesHeight + size.height() > pageSize.height()) {
+            return false;
+        }
+        page.shelves.push_back({page.shelvesHeight, size.height(), {{0, pageSize.width()}}});
+        page.shelvesHeight += size.height();
+        shelf = &page.shelves.back();
+        spanIndex = 0;
+    }
+
+    auto &span = shelf->free[spanIndex];
+    rect = QRect(QPoint(span.x, shelf->y), size);
+
+    span.x += size.width();
+    span.width -= size.width();
+    if (!span.width) {
+        shelf->free.erase(shelf->free.begin() + spanIndex);
+    }
+
+    page.allocations++;
+    return true;
+}
+
+void DecorationAtlas::releaseOnPage(Page &page, const QRect &rect) const
+{
+    auto shelf = std::find_if(page.shelves.begin(), page.shelves.end(),
+                              [&rect](const Shelf &shelf) { return shelf.y == rect.y(); });
+    Q_ASSERT(shelf != page.shelves.end());
+    if (shelf == page.shelves.end()) {
+        return;
+    }
+
+    auto &free = shelf->free;
+    auto span = std::lower_bound(free.begin(), free.end(), rect.x(),
+                                 [](const Span &span, int x) { return span.x < x; });
+    span = free.insert(span, {rect.x(), rect.width()});
+
+    // Merge with the adjacent free spans.
+    auto next = span + 1;
+    if (next != free.end() && span->x + span->width == next->x) {
+        span->width += next->width;
+        free.erase(next);
+    }
+    if (span != free.begin()) {
+        auto previous = span - 1;
+        if (previous->x + previous->width == span->x) {
+            previous->width += span->width;
+            free.erase(span);
+        }
+    }
+
+    page.allocations--;
+
+    // Empty shelves at the end are dropped, their space might be used for other heights.
+    const int pageWidth = page.texture->width();
+    while (!page.shelves.empty()) {
+        auto const &last = page.shelves.back();
+        if (last.free.size() != 1 || last.free.front().width != pageWidth) {
+            break;
+        }
+        page.shelvesHeight = last.y;
+        page.shelves.pop_back();
+    }
+}
+
+}
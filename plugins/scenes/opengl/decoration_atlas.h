@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QRect>
+#include <QSize>
+
+#include <memory>
+#include <vector>
+
+namespace KWin
+{
+class GLTexture;
+
+/**
+ * Sub-allocates the decorations of all windows from a few large textures, so that painting them
+ * binds the same texture instead of one texture per window.
+ *
+ * Pages are split into shelves, rows with the height of the first allocation put on them. The
+ * decorations of a theme have similar heights and fill the shelves well. Decorations too wide for
+ * a page get a page of their own.
+ *
+ * The OpenGL context must be current for all calls.
+ */
+class DecorationAtlas
+{
+public:
+    struct Slot {
+        GLTexture *texture{nullptr};
+        // In device pixels of the texture.
+        QRect rect;
+
+        bool isValid() const {
+            return texture;
+        }
+    };
+
+    DecorationAtlas();
+    ~DecorationAtlas();
+
+    /**
+     * The content of the returned slot is undefined. Returns an invalid slot if the size can not be
+     * allocated.
+     */
+    Slot allocate(const QSize &size);
+    void release(const Slot &slot);
+
+private:
+    struct Span {
+        int x;
+        int width;
+    };
+    struct Shelf {
+        int y;
+        int height;
+        // Sorted by position.
+        std::vector<Span> free;
+    };
+    struct Page {
+        std::unique_ptr<GLTexture> texture;
+        std::vector<Shelf> shelves;
+        int shelvesHeight{0};
+        int allocations{0};
+    };
+
+    std::unique_ptr<Page> createPage(const QSize &size) const;
+    bool allocateOnPage(Page &page, const QSize &size, QRect &rect) const;
+    void releaseOnPage(Page &page, const QRect &rect) const;
+
+    std::vector<std::unique_ptr<Page>> m_pages;
+    QSize m_pageSize;
+};
+
+}
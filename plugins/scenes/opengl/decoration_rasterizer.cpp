@@ -0,0 +1,215 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "decoration_rasterizer.h"
+
+#include <QFontDatabase>
+#include <QPainter>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace KWin
+{
+
+namespace
+{
+
+// Factor by which a kept buffer may be larger than the part it was last used for.
+constexpr qint64 s_maxBufferWaste = 4;
+
+void clampRow(int left, int width, int right, const uint32_t *src, uint32_t *dest)
+{
+    std::fill_n(dest, left, *src);
+    std::copy(src, src + width, dest + left);
+    std::fill_n(dest + left + width, right, *(src + width - 1));
+}
+
+void clampSides(int left, int width, int right, const uint32_t *src, uint32_t *dest)
+{
+    std::fill_n(dest, left, *src);
+    std::fill_n(dest + left + width, right, *(src + width - 1));
+}
+
+// Fills the part of the area outside of the viewport with the edge pixels of the viewport.
+void clamp(QImage &image, const QRect &area, const QRect &viewport)
+{
+    Q_ASSERT(image.depth() == 32);
+
+    const int left = viewport.left() - area.left();
+    const int top = viewport.top() - area.top();
+    const int right = area.right() - viewport.right();
+    const int bottom = area.bottom() - viewport.bottom();
+
+    const int width = area.width() - left - right;
+    const int height = area.height() - top - bottom;
+
+    auto row = [&](int y) {
+        return reinterpret_cast<uint32_t *>(image.scanLine(area.top() + y)) + area.left();
+    };
+
+    const uint32_t *firstRow = row(top);
+    const uint32_t *lastRow = row(top + height - 1);
+
+    for (int i = 0; i < top; ++i) {
+        clampRow(left, width, right, firstRow + left, row(i));
+    }
+
+    for (int i = 0; i < height; ++i) {
+        uint32_t *dest = row(top + i);
+        clampSides(left, width, right, dest + left, dest);
+    }
+
+    for (int i = 0; i < bottom; ++i) {
+        clampRow(left, width, right, lastRow + left, row(top + height + i));
+    }
+}
+
+QRect transposedRect(const QRect &rect)
+{
+    return QRect(rect.y(), rect.x(), rect.height(), rect.width());
+}
+
+}
+
+QTransform DecorationRasterizer::Part::transform() const
+{
+    auto transform = QTransform::fromTranslate(-paddedGeometry.x(), -paddedGeometry.y())
+        * QTransform::fromScale(scale, scale);
+    if (transposed) {
+        transform *= QTransform(0, 1, 1, 0, 0, 0);
+    }
+    return transform * QTransform::fromTranslate(area.x(), area.y());
+}
+
+QRect DecorationRasterizer::Part::viewport() const
+{
+    const QRect viewport((geometry.topLeft() - paddedGeometry.topLeft()) * scale,
+                         geometry.size() * scale);
+    // Rounding with fractional scales must not move it out of the area.
+    return (transposed ? transposedRect(viewport) : viewport).translated(area.topLeft()) & area;
+}
+
+DecorationRasterizer::DecorationRasterizer()
+    // Text is replayed on the workers.
+    : m_threaded(QFontDatabase::supportsThreadedFontRendering())
+{
+    // The main thread takes part in rasterizing as well.
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+    // Keep the workers alive between frames.
+    m_pool.setExpiryTimeout(-1);
+}
+
+DecorationRasterizer::~DecorationRasterizer()
+{
+    m_pool.waitForDone();
+}
+
+DecorationRasterizer::Part *DecorationRasterizer::add(const QRect &geometry,
+                                                      const QRect &paddedGeometry, qreal scale,
+                                                      bool transposed,
+                                                      const std::function<void(QPainter*)> &paint)
+{
+    const size_t index = m_parts.size();
+    m_parts.emplace_back();
+    auto &part = m_parts.back();
+    part.geometry = geometry;
+    part.paddedGeometry = paddedGeometry;
+    part.scale = scale;
+    part.transposed = transposed;
+
+    QSize size = paddedGeometry.size() * scale;
+    if (transposed) {
+        size.transpose();
+    }
+
+    if (m_buffers.size() <= index) {
+        m_buffers.emplace_back();
+    }
+    auto &buffer = m_buffers.at(index);
+    if (buffer.width() < size.width() || buffer.height() < size.height()) {
+        buffer = QImage(size.expandedTo(buffer.size()), QImage::Format_ARGB32_Premultiplied);
+    }
+    part.buffer = &buffer;
+    part.area = QRect(QPoint(), size);
+
+    if (m_threaded && qFuzzyCompare(scale, 1.)) {
+        QPainter painter(&part.picture);
+        paint(&painter);
+        part.recorded = true;
+    } else {
+        rasterize(part, paint);
+    }
+
+    return &part;
+}
+
+void DecorationRasterizer::run()
+{
+    std::vector<Part*> parts;
+    for (auto &part : m_parts) {
+        if (part.recorded) {
+            parts.push_back(&part);
+        }
+    }
+    if (parts.empty()) {
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t index; (index = next++) < parts.size();) {
+            auto part = parts[index];
+            rasterize(*part, [part](QPainter *painter) {
+                painter->drawPicture(0, 0, part->picture);
+            });
+            part->picture = QPicture();
+            part->recorded = false;
+        }
+    };
+
+    const int workers = std::min<int>(m_pool.maxThreadCount(), parts.size() - 1);
+    for (int i = 0; i < workers; ++i) {
+        m_pool.start(work);
+    }
+    work();
+    m_pool.waitForDone();
+}
+
+void DecorationRasterizer::clear()
+{
+    // Buffers only grow while they are reused. Release the ones this frame did not need and the
+    // ones far larger than their part, so a single large update does not hold the memory for good.
+    for (size_t i = 0; i < m_parts.size(); ++i) {
+        auto &buffer = m_buffers.at(i);
+        const QRect &area = m_parts.at(i).area;
+        if (qint64(buffer.width()) * buffer.height()
+                > s_maxBufferWaste * qint64(area.width()) * area.height()) {
+            buffer = QImage();
+        }
+    }
+    m_buffers.resize(m_parts.size());
+    m_parts.clear();
+}
+
+void DecorationRasterizer::rasterize(Part &part, const std::function<void(QPainter*)> &paint)
+{
+    QPainter painter(part.buffer);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(part.area, Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setTransform(part.transform());
+    painter.setClipRect(part.geometry);
+    paint(&painter);
+    painter.end();
+
+    clamp(*part.buffer, part.area, part.viewport());
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QImage>
+#include <QPicture>
+#include <QRect>
+#include <QThreadPool>
+#include <QTransform>
+
+#include <deque>
+#include <functional>
+
+class QPainter;
+
+namespace KWin
+{
+
+/**
+ * Rasterizes the parts of decorations, concurrently on a pool of worker threads where possible.
+ *
+ * Decorations live on the main thread and can only paint there. Their painting is recorded into a
+ * QPicture, which is cheap, and the recording is replayed into pixels on the workers. Decorations
+ * on scaled screens are painted directly since a picture has no device pixel ratio to pick images
+ * by. The pixel buffers are kept for the parts of later frames.
+ *
+ * Parts laid out rotated in the texture are painted transposed right away.
+ */
+class DecorationRasterizer
+{
+public:
+    struct Part {
+        // Logical rect of the part to update, in window coordinates.
+        QRect geometry;
+        // The geometry with padding. The padding is filled with the edge pixels of the geometry.
+        QRect paddedGeometry;
+        qreal scale{1.};
+        bool transposed{false};
+
+        // The rasterized padded geometry is in this area of the buffer.
+        QImage *buffer{nullptr};
+        QRect area;
+
+    private:
+        friend class DecorationRasterizer;
+        QTransform transform() const;
+        QRect viewport() const;
+
+        QPicture picture;
+        bool recorded{false};
+    };
+
+    DecorationRasterizer();
+    ~DecorationRasterizer();
+
+    /**
+     * Adds a part to be rasterized. The decoration paints it right away through @p paint, on a
+     * painter in logical window coordinates. The returned part stays valid until clear().
+     */
+    Part *add(const QRect &geometry, const QRect &paddedGeometry, qreal scale, bool transposed,
+              const std::function<void(QPainter*)> &paint);
+
+    /**
+     * Rasterizes all added parts. Blocks until they are done.
+     */
+    void run();
+
+    /**
+     * Removes the parts. Their buffers are reused for the next ones, except for buffers that were
+     * not needed or are much larger than their part.
+     */
+    void clear();
+
+private:
+    static void rasterize(Part &part, const std::function<void(QPainter*)> &paint);
+
+    std::deque<Part> m_parts;
+    std::deque<QImage> m_buffers;
+    QThreadPool m_pool;
+    bool m_threaded;
+};
+
+}
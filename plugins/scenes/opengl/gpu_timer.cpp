@@ -0,0 +1,236 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "gpu_timer.h"
+
+#include "abstract_output.h"
+#include "toplevel.h"
+
+#include "perf/ftrace.h"
+
+#include <kwinglplatform.h>
+#include <kwinglutils.h>
+
+namespace KWin
+{
+
+// Frames whose results are still outstanding after this many newer frames are dropped.
+static constexpr size_t s_maxPendingFrames = 8;
+
+GpuTimer::GpuTimer()
+    : m_gles(GLPlatform::instance()->isGLES())
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    if (m_queries.empty()) {
+        return;
+    }
+    if (m_gles) {
+        glDeleteQueriesEXT(m_queries.size(), m_queries.data());
+    } else {
+        glDeleteQueries(m_queries.size(), m_queries.data());
+    }
+}
+
+bool GpuTimer::supported()
+{
+    if (qgetenv("KWIN_GPU_TIMER") == QByteArrayLiteral("0")) {
+        return false;
+    }
+    if (GLPlatform::instance()->isGLES()) {
+        return hasGLExtension(QByteArrayLiteral("GL_EXT_disjoint_timer_query"));
+    }
+    return hasGLVersion(3, 3) || hasGLExtension(QByteArrayLiteral("GL_ARB_timer_query"));
+}
+
+GLuint GpuTimer::acquireQuery()
+{
+    if (!m_pool.empty()) {
+        auto const query = m_pool.back();
+        m_pool.pop_back();
+        return query;
+    }
+
+    GLuint query = 0;
+    if (m_gles) {
+        glGenQueriesEXT(1, &query);
+    } else {
+        glGenQueries(1, &query);
+    }
+    m_queries.push_back(query);
+    return query;
+}
+
+void GpuTimer::queryTimestamp(GLuint query)
+{
+    if (m_gles) {
+        glQueryCounterEXT(query, GL_TIMESTAMP_EXT);
+    } else {
+        glQueryCounter(query, GL_TIMESTAMP);
+    }
+}
+
+quint64 GpuTimer::timestamp(GLuint query) const
+{
+    GLuint64 value = 0;
+    if (m_gles) {
+        glGetQueryObjectui64vEXT(query, GL_QUERY_RESULT_EXT, &value);
+    } else {
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &value);
+    }
+    return value;
+}
+
+void GpuTimer::releaseFrame(Frame &frame)
+{
+    m_pool.push_back(frame.begin);
+    m_pool.push_back(frame.end);
+    for (auto const& sample : frame.windows) {
+        m_pool.push_back(sample.begin);
+        if (sample.end != 0) {
+            m_pool.push_back(sample.end);
+        }
+    }
+}
+
+void GpuTimer::beginFrame(AbstractOutput *output)
+{
+    collect();
+
+    m_current = Frame();
+    m_current.output = output;
+    if (Perf::Ftrace::enabled()) {
+        m_current.name = output ? output->name() : QStringLiteral("screen");
+    }
+    m_current.begin = acquireQuery();
+    queryTimestamp(m_current.begin);
+    m_recording = true;
+}
+
+void GpuTimer::endFrame()
+{
+    if (!m_recording) {
+        return;
+    }
+    m_current.end = acquireQuery();
+    queryTimestamp(m_current.end);
+    m_pending.push_back(std::move(m_current));
+    m_recording = false;
+
+    while (m_pending.size() > s_maxPendingFrames) {
+        releaseFrame(m_pending.front());
+        m_pending.pop_front();
+    }
+}
+
+int GpuTimer::beginWindow(Toplevel *window)
+{
+    // Per-window durations are only reported through ftrace. Don't spend queries otherwise.
+    if (!m_recording || m_current.name.isEmpty()) {
+        return -1;
+    }
+    WindowSample sample;
+    sample.id = window->internalId();
+    sample.begin = acquireQuery();
+    sample.end = 0;
+    queryTimestamp(sample.begin);
+    m_current.windows.push_back(sample);
+    return m_current.windows.size() - 1;
+}
+
+void GpuTimer::endWindow(int handle)
+{
+    if (!m_recording || handle < 0 || handle >= int(m_current.windows.size())) {
+        return;
+    }
+    auto &sample = m_current.windows[handle];
+    sample.end = acquireQuery();
+    queryTimestamp(sample.end);
+}
+
+void GpuTimer::collect()
+{
+    if (m_gles) {
+        // The GPU was reset or changed its clock. Results in flight are meaningless.
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (disjoint) {
+            for (auto &frame : m_pending) {
+                releaseFrame(frame);
+            }
+            m_pending.clear();
+            return;
+        }
+    }
+
+    auto const trace = Perf::Ftrace::enabled();
+
+    while (!m_pending.empty()) {
+        auto &frame = m_pending.front();
+
+        // Timestamps complete in submission order, so once the last query of a frame is available
+        // all others are too.
+        GLuint available = 0;
+        if (m_gles) {
+            glGetQueryObjectuivEXT(frame.end, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        } else {
+            glGetQueryObjectuiv(frame.end, GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+        if (!available) {
+            break;
+        }
+
+        auto const duration = qint64(timestamp(frame.end) - timestamp(frame.begin));
+        if (frame.output) {
+            m_lastDurations[frame.output] = duration;
+        }
+        m_lastDuration = duration;
+
+        if (trace && !frame.name.isEmpty()) {
+            Perf::Ftrace::mark(QStringLiteral("gpu-paint-%1 %2").arg(frame.name).arg(duration));
+            for (auto const& sample : frame.windows) {
+                if (sample.end == 0) {
+                    continue;
+                }
+                auto const window_duration = qint64(timestamp(sample.end) - timestamp(sample.begin));
+                Perf::Ftrace::mark(QStringLiteral("gpu-window-%1 %2")
+                                   .arg(sample.id.toString()).arg(window_duration));
+            }
+        }
+
+        releaseFrame(frame);
+        m_pending.pop_front();
+    }
+}
+
+qint64 GpuTimer::lastFrameDuration(AbstractOutput *output) const
+{
+    if (!output) {
+        return m_lastDuration;
+    }
+    auto it = m_lastDurations.find(output);
+    if (it == m_lastDurations.end()) {
+        return 0;
+    }
+    return it->second;
+}
+
+void GpuTimer::removeOutput(AbstractOutput *output)
+{
+    m_lastDurations.erase(output);
+
+    if (m_current.output == output) {
+        m_current.output = nullptr;
+    }
+    for (auto &frame : m_pending) {
+        if (frame.output == output) {
+            frame.output = nullptr;
+        }
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QString>
+#include <QUuid>
+
+#include <epoxy/gl.h>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace KWin
+{
+class AbstractOutput;
+class Toplevel;
+
+/**
+ * Measures the GPU execution time of frames and of single windows with timestamp queries.
+ *
+ * Results of a frame are only read back once the GPU reports them as available, usually a few
+ * frames later. Measuring therefore never stalls the pipeline but the reported durations lag
+ * behind the frames currently painted.
+ *
+ * The OpenGL context must be current for all calls.
+ */
+class GpuTimer
+{
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    static bool supported();
+
+    void beginFrame(AbstractOutput *output);
+    void endFrame();
+
+    /**
+     * Starts measuring @p window in the current frame. Windows are only measured while ftrace
+     * marking is enabled, since that is where their durations are reported.
+     * @return Handle to pass to endWindow or -1 if the window is not measured.
+     */
+    int beginWindow(Toplevel *window);
+    void endWindow(int handle);
+
+    /**
+     * GPU duration in nanoseconds of the last finished frame of @p output, or of any output if
+     * @p output is null. 0 if nothing has been measured yet.
+     */
+    qint64 lastFrameDuration(AbstractOutput *output = nullptr) const;
+
+    /**
+     * Forgets the durations of @p output. Frames of it still in flight only count for any output.
+     */
+    void removeOutput(AbstractOutput *output);
+
+private:
+    struct WindowSample {
+        QUuid id;
+        GLuint begin;
+        GLuint end;
+    };
+    struct Frame {
+        AbstractOutput *output{nullptr};
+        QString name;
+        GLuint begin{0};
+        GLuint end{0};
+        std::vector<WindowSample> windows;
+    };
+
+    GLuint acquireQuery();
+    void queryTimestamp(GLuint query);
+    quint64 timestamp(GLuint query) const;
+    void releaseFrame(Frame &frame);
+    void collect();
+
+    bool m_gles;
+    std::vector<GLuint> m_pool;
+    std::vector<GLuint> m_queries;
+    std::deque<Frame> m_pending;
+    Frame m_current;
+    bool m_recording{false};
+
+    std::unordered_map<AbstractOutput*, qint64> m_lastDurations;
+    qint64 m_lastDuration{0};
+};
+
+}
@@ -40,6 +40,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace KWin
 {
 
+// Parameter a of the lanczos kernel
+static const float s_lanczosSize = 2.0;
+// Source pixels filtered per frame before windows fall back to outdated or bilinear scaling. The
+// first window in a frame is always filtered and so is the first window that had been deferred.
+static const qint64 s_frameBudget = 1920 * 1080 * 2;
+
 LanczosFilter::LanczosFilter(Scene *parent)
     : QObject(parent)
     , m_offscreenTex(nullptr)
@@ -49,6 +55,8 @@ LanczosFilter::LanczosFilter(Scene *parent)
     , m_uOffsets(0)
     , m_uKernel(0)
     , m_scene(parent)
+    , m_filteredPixels(0)
+    , m_deferredFiltered(false)
 {
 }
 
@@ -137,15 +145,50 @@ static float lanczos(float x, float a)
     return sinc(x) * sinc(x / a);
 }
 
-void LanczosFilter::createKernel(float delta, int *size)
+static int kernelSizeFor(float delta)
 {
-    const float a = 2.0;
-
     // The two outermost samples always fall at points where the lanczos
     // function returns 0, so we'll skip them.
-    const int sampleCount = qBound(3, qCeil(delta * a) * 2 + 1 - 2, 29);
-    const int center = sampleCount / 2;
-    const int kernelSize = center + 1;
+    const int sampleCount = qBound(3, qCeil(delta * s_lanczosSize) * 2 + 1 - 2, 29);
+    return sampleCount / 2 + 1;
+}
+
+// Draws a quad from the origin with the texture coordinates @p topLeft and @p bottomRight.
+static void renderQuad(const QSize &size, const QPointF &topLeft, const QPointF &bottomRight)
+{
+    const float w = size.width();
+    const float h = size.height();
+    const float verts[] = {
+        w, 0, // Top right
+        0, 0, // Top left
+        0, h, // Bottom left
+        0, h, // Bottom left
+        w, h, // Bottom right
+        w, 0, // Top right
+    };
+    const float left = topLeft.x();
+    const float top = topLeft.y();
+    const float right = bottomRight.x();
+    const float bottom = bottomRight.y();
+    const float texCoords[] = {
+        right, top,
+        left, top,
+        left, bottom,
+        left, bottom,
+        right, bottom,
+        right, top,
+    };
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setData(6, 2, verts, texCoords);
+    vbo->render(GL_TRIANGLES);
+}
+
+void LanczosFilter::createKernel(float delta, int *size)
+{
+    const float a = s_lanczosSize;
+    const int kernelSize = kernelSizeFor(delta);
     const float factor = 1.0 / delta;
 
     QVector<float> values(kernelSize);
@@ -177,6 +220,13 @@ void LanczosFilter::createOffsets(int count, float width, Qt::Orientation direct
     }
 }
 
+void LanczosFilter::beginFrame()
+{
+    m_filteredPixels = 0;
+    m_deferredFiltered = false;
+    m_deferred.removeAll(QPointer<EffectWindow>());
+}
+
 void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data)
 {
     if (data.xScale() < 0.9 || data.yScale() < 0.9) {
@@ -201,186 +251,231 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
 
             int sw = width;
             int sh = height;
-
-            GLTexture *cachedTexture = static_cast< GLTexture*>(w->data(LanczosCacheRole).value<void*>());
-            if (cachedTexture) {
-                if (cachedTexture->width() == tw && cachedTexture->height() == th) {
-                    cachedTexture->bind();
-                    if (hardwareClipping) {
-                        glEnable(GL_SCISSOR_TEST);
-                    }
-
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
-                    const qreal rgb = data.brightness() * data.opacity();
-                    const qreal a = data.opacity();
-
-                    ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
-                    GLShader *shader = binder.shader();
-                    QMatrix4x4 mvp = data.screenProjectionMatrix();
-                    mvp.translate(textureRect.x(), textureRect.y());
-                    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-                    shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
-                    shader->setUniform(GLShader::Saturation, data.saturation());
-
-                    cachedTexture->render(region, textureRect, hardwareClipping);
-
-                    glDisable(GL_BLEND);
-                    if (hardwareClipping) {
-                        glDisable(GL_SCISSOR_TEST);
-                    }
-                    cachedTexture->unbind();
-                    m_timer.start(5000, this);
-                    return;
-                } else {
-                    // offscreen texture not matching - delete
-                    delete cachedTexture;
-                    cachedTexture = nullptr;
-                    w->setData(LanczosCacheRole, QVariant());
-                }
+            // The filtered part of the window relative to its frame geometry.
+            const QRect sourceGeometry(winGeo.topLeft(), QSize(sw, sh));
+
+            auto &lanczosCache = static_cast<EffectsHandlerImpl*>(effects)->lanczosCache();
+            LanczosCache *cache = lanczosCache.get(w);
+            if (cache && cache->texture->size() != QSize(tw, th)) {
+                // offscreen texture not matching - delete
+                lanczosCache.reset(w);
+                cache = nullptr;
             }
 
-            WindowPaintData thumbData = data;
-            thumbData.setXScale(1.0);
-            thumbData.setYScale(1.0);
-            thumbData.setXTranslation(-w->x() - left);
-            thumbData.setYTranslation(-w->y() - top);
-            thumbData.setBrightness(1.0);
-            thumbData.setOpacity(1.0);
-            thumbData.setSaturation(1.0);
-
-            // Bind the offscreen FBO and draw the window on it unscaled
-            updateOffscreenSurfaces();
-            GLRenderTarget::pushRenderTarget(m_offscreenTarget);
-
-            QMatrix4x4 modelViewProjectionMatrix;
-            modelViewProjectionMatrix.ortho(0, m_offscreenTex->width(), m_offscreenTex->height(), 0 , 0, 65535);
-            thumbData.setProjectionMatrix(modelViewProjectionMatrix);
-
-            glClearColor(0.0, 0.0, 0.0, 0.0);
-            glClear(GL_COLOR_BUFFER_BIT);
-            w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
-
-            // Create a scratch texture and copy the rendered window into it
-            GLTexture tex(GL_RGBA8, sw, sh);
-            tex.setFilter(GL_LINEAR);
-            tex.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex.bind();
-
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, sw, sh);
-
-            // Set up the shader for horizontal scaling
-            float dx = sw / float(tw);
-            int kernelSize;
-            createKernel(dx, &kernelSize);
-            createOffsets(kernelSize, sw, Qt::Horizontal);
-
-            ShaderManager::instance()->pushShader(m_shader.data());
-            m_shader->setUniform(GLShader::ModelViewProjectionMatrix, modelViewProjectionMatrix);
-            setUniforms();
-
-            // Draw the window back into the FBO, this time scaled horizontally
-            glClear(GL_COLOR_BUFFER_BIT);
-            QVector<float> verts;
-            QVector<float> texCoords;
-            verts.reserve(12);
-            texCoords.reserve(12);
-
-            texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
-            texCoords << 0.0 << 0.0; verts << 0.0 << 0.0; // Top left
-            texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
-            texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
-            texCoords << 1.0 << 1.0; verts << tw  << sh;  // Bottom right
-            texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
-            GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
-            vbo->reset();
-            vbo->setData(6, 2, verts.constData(), texCoords.constData());
-            vbo->render(GL_TRIANGLES);
-
-            // At this point we don't need the scratch texture anymore
-            tex.unbind();
-            tex.discard();
-
-            // create scratch texture for second rendering pass
-            GLTexture tex2(GL_RGBA8, tw, sh);
-            tex2.setFilter(GL_LINEAR);
-            tex2.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex2.bind();
-
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, tw, sh);
-
-            // Set up the shader for vertical scaling
-            float dy = sh / float(th);
-            createKernel(dy, &kernelSize);
-            createOffsets(kernelSize, m_offscreenTex->height(), Qt::Vertical);
-            setUniforms();
-
-            // Now draw the horizontally scaled window in the FBO at the right
-            // coordinates on the screen, while scaling it vertically and blending it.
-            glClear(GL_COLOR_BUFFER_BIT);
-
-            verts.clear();
-
-            verts << tw  << 0.0; // Top right
-            verts << 0.0 << 0.0; // Top left
-            verts << 0.0 << th;  // Bottom left
-            verts << 0.0 << th;  // Bottom left
-            verts << tw  << th;  // Bottom right
-            verts << tw  << 0.0; // Top right
-            vbo->setData(6, 2, verts.constData(), texCoords.constData());
-            vbo->render(GL_TRIANGLES);
-
-            tex2.unbind();
-            tex2.discard();
-            ShaderManager::instance()->popShader();
-
-            // create cache texture
-            GLTexture *cache = new GLTexture(GL_RGBA8, tw, th);
-
-            cache->setFilter(GL_LINEAR);
-            cache->setWrapMode(GL_CLAMP_TO_EDGE);
-            cache->bind();
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - th, tw, th);
-            GLRenderTarget::popRenderTarget();
-
-            if (hardwareClipping) {
-                glEnable(GL_SCISSOR_TEST);
+            // Only the damaged part of a cached texture is filtered again.
+            QRect dirty(QPoint(0, 0), sourceGeometry.size());
+            if (cache) {
+                dirty &= cache->damage.boundingRect().translated(-sourceGeometry.topLeft());
             }
 
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            const qint64 pixels = qint64(dirty.width()) * dirty.height();
+            if (dirty.isEmpty()) {
+                if (cache) {
+                    cache->damage = QRegion();
+                }
+            } else if (m_filteredPixels > 0 && m_filteredPixels + pixels > s_frameBudget
+                       && (m_deferredFiltered || !m_deferred.contains(w))) {
+                // Over budget. Paint the outdated texture or, if there is none yet, scale the
+                // window bilinearly and filter it in one of the next frames.
+                if (!m_deferred.contains(w)) {
+                    m_deferred.append(w);
+                }
+                w->addRepaintFull();
+            } else {
+                // Windows damaged in every frame would otherwise starve the ones painted after
+                // them, so a deferred window is let through even when over budget.
+                if (m_deferred.removeOne(w)) {
+                    m_deferredFiltered = true;
+                }
+                m_filteredPixels += pixels;
+                if (!cache) {
+                    cache = &lanczosCache.emplace(w);
+                    cache->texture.reset(new GLTexture(GL_RGBA8, tw, th));
+                    cache->texture->setFilter(GL_LINEAR);
+                    cache->texture->setWrapMode(GL_CLAMP_TO_EDGE);
+                }
+                filter(w, mask, data, sourceGeometry, QSize(tw, th), dirty, cache->texture.get());
+                cache->damage = QRegion();
+            }
 
-            const qreal rgb = data.brightness() * data.opacity();
-            const qreal a = data.opacity();
+            if (cache) {
+                GLTexture *texture = cache->texture.get();
+                texture->bind();
+                if (hardwareClipping) {
+                    glEnable(GL_SCISSOR_TEST);
+                }
 
-            ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
-            GLShader *shader = binder.shader();
-            QMatrix4x4 mvp = data.screenProjectionMatrix();
-            mvp.translate(textureRect.x(), textureRect.y());
-            shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-            shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
-            shader->setUniform(GLShader::Saturation, data.saturation());
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
-            cache->render(region, textureRect, hardwareClipping);
+                const qreal rgb = data.brightness() * data.opacity();
+                const qreal a = data.opacity();
 
-            glDisable(GL_BLEND);
+                ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
+                GLShader *shader = binder.shader();
+                QMatrix4x4 mvp = data.screenProjectionMatrix();
+                mvp.translate(textureRect.x(), textureRect.y());
+                shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+                shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
+                shader->setUniform(GLShader::Saturation, data.saturation());
 
-            if (hardwareClipping) {
-                glDisable(GL_SCISSOR_TEST);
-            }
+                texture->render(region, textureRect, hardwareClipping);
 
-            cache->unbind();
-            w->setData(LanczosCacheRole, QVariant::fromValue(static_cast<void*>(cache)));
+                glDisable(GL_BLEND);
+                if (hardwareClipping) {
+                    glDisable(GL_SCISSOR_TEST);
+                }
+                texture->unbind();
 
-            // Delete the offscreen surface after 5 seconds
-            m_timer.start(5000, this);
-            return;
+                // Delete the offscreen surface after 5 seconds
+                m_timer.start(5000, this);
+                return;
+            }
         }
     } // if ( effects->compositingType() == KWin::OpenGLCompositing )
     w->sceneWindow()->performPaint(mask, region, data);
 } // End of function
 
+void LanczosFilter::filter(EffectWindowImpl *w, int mask, const WindowPaintData &data,
+                           const QRect &geometry, const QSize &size, const QRect &dirty,
+                           GLTexture *cache)
+{
+    const int sw = geometry.width();
+    const int sh = geometry.height();
+    const int tw = size.width();
+    const int th = size.height();
+    const float dx = sw / float(tw);
+    const float dy = sh / float(th);
+
+    // Distance in source pixels a target pixel reads around its center, including the texel
+    // touched by linear interpolation.
+    const int reachX = kernelSizeFor(dx) + 1;
+    const int reachY = kernelSizeFor(dy) + 1;
+
+    // The target pixels reading from the dirty rect
+    const int tx0 = qBound(0, qFloor((dirty.left() - reachX) / dx), tw);
+    const int tx1 = qBound(0, qCeil((dirty.right() + 1 + reachX) / dx), tw);
+    const int ty0 = qBound(0, qFloor((dirty.top() - reachY) / dy), th);
+    const int ty1 = qBound(0, qCeil((dirty.bottom() + 1 + reachY) / dy), th);
+    const QRect targetRect(tx0, ty0, tx1 - tx0, ty1 - ty0);
+    if (targetRect.isEmpty()) {
+        return;
+    }
+
+    // The source pixels these read from and the horizontally scaled rows the vertical pass needs
+    const int sx0 = qBound(0, qFloor(tx0 * dx) - reachX, sw);
+    const int sx1 = qBound(0, qCeil(tx1 * dx) + reachX, sw);
+    const int sy0 = qBound(0, qFloor(ty0 * dy) - reachY, sh);
+    const int sy1 = qBound(0, qCeil(ty1 * dy) + reachY, sh);
+    const QRect sourceRect(sx0, sy0, sx1 - sx0, sy1 - sy0);
+    const QRect horizontalRect(tx0, sy0, targetRect.width(), sourceRect.height());
+
+    WindowPaintData thumbData = data;
+    thumbData.setXScale(1.0);
+    thumbData.setYScale(1.0);
+    thumbData.setXTranslation(-w->x() - geometry.x());
+    thumbData.setYTranslation(-w->y() - geometry.y());
+    thumbData.setBrightness(1.0);
+    thumbData.setOpacity(1.0);
+    thumbData.setSaturation(1.0);
+
+    // Bind the offscreen FBO and draw the window on it unscaled
+    updateOffscreenSurfaces();
+    GLRenderTarget::pushRenderTarget(m_offscreenTarget);
+
+    QMatrix4x4 modelViewProjectionMatrix;
+    modelViewProjectionMatrix.ortho(0, m_offscreenTex->width(), m_offscreenTex->height(), 0 , 0, 65535);
+    thumbData.setProjectionMatrix(modelViewProjectionMatrix);
+
+    // Each pass only touches the part of the FBO needed for the dirty rect.
+    glEnable(GL_SCISSOR_TEST);
+    scissorOffscreen(sourceRect);
+
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
+
+    // Create a scratch texture and copy the rendered part of the window into it
+    GLTexture tex(GL_RGBA8, sourceRect.width(), sourceRect.height());
+    tex.setFilter(GL_LINEAR);
+    tex.setWrapMode(GL_CLAMP_TO_EDGE);
+    tex.bind();
+
+    copyOffscreen(sourceRect, QPoint(0, 0), sourceRect.height());
+
+    // Set up the shader for horizontal scaling
+    int kernelSize;
+    createKernel(dx, &kernelSize);
+    createOffsets(kernelSize, sourceRect.width(), Qt::Horizontal);
+
+    ShaderManager::instance()->pushShader(m_shader.data());
+    m_shader->setUniform(GLShader::ModelViewProjectionMatrix, modelViewProjectionMatrix);
+    setUniforms();
+
+    // Draw the window back into the FBO, this time scaled horizontally. The scratch textures are
+    // bottom-up, their first row is the last one of the copied rect.
+    scissorOffscreen(horizontalRect);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    const float texWidth = sourceRect.width();
+    const float texHeight = sourceRect.height();
+    renderQuad(QSize(tw, sh), QPointF(-sx0 / texWidth, sy1 / texHeight),
+               QPointF((sw - sx0) / texWidth, (sy1 - sh) / texHeight));
+
+    // At this point we don't need the scratch texture anymore
+    tex.unbind();
+    tex.discard();
+
+    // create scratch texture for second rendering pass
+    GLTexture tex2(GL_RGBA8, horizontalRect.width(), horizontalRect.height());
+    tex2.setFilter(GL_LINEAR);
+    tex2.setWrapMode(GL_CLAMP_TO_EDGE);
+    tex2.bind();
+
+    copyOffscreen(horizontalRect, QPoint(0, 0), horizontalRect.height());
+
+    // Set up the shader for vertical scaling
+    createKernel(dy, &kernelSize);
+    createOffsets(kernelSize, horizontalRect.height(), Qt::Vertical);
+    setUniforms();
+
+    // Now draw the horizontally scaled window in the FBO at the right
+    // coordinates on the screen, while scaling it vertically.
+    scissorOffscreen(targetRect);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    const float tex2Width = horizontalRect.width();
+    const float tex2Height = horizontalRect.height();
+    renderQuad(QSize(tw, th), QPointF(-tx0 / tex2Width, sy1 / tex2Height),
+               QPointF((tw - tx0) / tex2Width, (sy1 - sh) / tex2Height));
+
+    tex2.unbind();
+    tex2.discard();
+    ShaderManager::instance()->popShader();
+    glDisable(GL_SCISSOR_TEST);
+
+    // Update the filtered part of the cache texture
+    cache->bind();
+    copyOffscreen(targetRect, targetRect.topLeft(), th);
+    cache->unbind();
+
+    GLRenderTarget::popRenderTarget();
+}
+
+void LanczosFilter::copyOffscreen(const QRect &rect, const QPoint &offset, int textureHeight)
+{
+    // Textures and the FBO are bottom-up, @p rect and @p offset are top-down.
+    const int fboHeight = m_offscreenTex->height();
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, offset.x(), textureHeight - offset.y() - rect.height(),
+                        rect.x(), fboHeight - rect.y() - rect.height(), rect.width(), rect.height());
+}
+
+void LanczosFilter::scissorOffscreen(const QRect &rect)
+{
+    const int fboHeight = m_offscreenTex->height();
+    glScissor(rect.x(), fboHeight - rect.y() - rect.height(), rect.width(), rect.height());
+}
+
 void LanczosFilter::timerEvent(QTimerEvent *event)
 {
     if (event->timerId() == m_timer.timerId()) {
@@ -403,11 +498,7 @@ void LanczosFilter::timerEvent(QTimerEvent *event)
 
 void LanczosFilter::discardCacheTexture(EffectWindow *w)
 {
-    QVariant cachedTextureVariant = w->data(LanczosCacheRole);
-    if (cachedTextureVariant.isValid()) {
-        delete static_cast< GLTexture*>(cachedTextureVariant.value<void*>());
-        w->setData(LanczosCacheRole, QVariant());
-    }
+    static_cast<EffectsHandlerImpl*>(effects)->lanczosCache().reset(w);
 }
 
 void LanczosFilter::setUniforms()
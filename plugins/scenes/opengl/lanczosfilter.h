@@ -24,6 +24,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QBasicTimer>
+#include <QPointer>
+#include <QRect>
 #include <QVector>
 #include <QVector2D>
 #include <QVector4D>
@@ -48,6 +50,10 @@ public:
     explicit LanczosFilter(Scene *parent);
     ~LanczosFilter() override;
     void performPaint(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data);
+    /**
+     * Resets the budget of pixels filtered in a frame.
+     */
+    void beginFrame();
 
 protected:
     void timerEvent(QTimerEvent*) override;
@@ -56,6 +62,10 @@ private:
     void updateOffscreenSurfaces();
     void setUniforms();
     void discardCacheTexture(EffectWindow *w);
+    void filter(EffectWindowImpl *w, int mask, const WindowPaintData &data, const QRect &geometry,
+                const QSize &size, const QRect &dirty, GLTexture *cache);
+    void copyOffscreen(const QRect &rect, const QPoint &offset, int textureHeight);
+    void scissorOffscreen(const QRect &rect);
 
     void createKernel(float delta, int *kernelSize);
     void createOffsets(int count, float width, Qt::Orientation direction);
@@ -69,6 +79,11 @@ private:
     std::array<QVector2D, 16> m_offsets;
     std::array<QVector4D, 16> m_kernel;
     Scene *m_scene;
+    // Source pixels filtered in the current frame.
+    qint64 m_filteredPixels;
+    // Windows over budget in an earlier frame that have not been filtered since.
+    QVector<QPointer<EffectWindow>> m_deferred;
+    bool m_deferredFiltered;
 };
 
 } // namespace
@@ -40,6 +40,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "utils.h"
 #include "composite.h"
 #include "effects.h"
+#include "gpu_timer.h"
 #include "lanczosfilter.h"
 #include "main.h"
 #include "overlaywindow.h"
@@ -49,11 +50,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <logging.h>
 
 #include "win/geo.h"
+#include "win/scene.h"
 #include "win/transient.h"
 
 #include <Wrapland/Server/buffer.h>
 #include <Wrapland/Server/surface.h>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
@@ -366,6 +369,19 @@ SceneOpenGL::SceneOpenGL(OpenGLBackend *backend, QObject *parent)
             qCDebug(KWIN_OPENGL) << "Explicit synchronization with the X command stream disabled by environment variable";
         }
     }
+
+    if (GpuTimer::supported()) {
+        m_gpuTimer = std::make_unique<GpuTimer>();
+    }
+    connect(kwinApp()->platform(), &Platform::output_removed, this, [this](auto output) {
+        if (m_gpuTimer) {
+            m_gpuTimer->removeOutput(output);
+        }
+        m_overlayWindows.erase(output);
+    });
+
+    m_decorationAtlas = std::make_shared<DecorationAtlas>();
+    m_decorationRasterizer = std::make_unique<DecorationRasterizer>();
 }
 
 SceneOpenGL::~SceneOpenGL()
@@ -375,6 +391,9 @@ SceneOpenGL::~SceneOpenGL()
     }
     SceneOpenGL::EffectFrame::cleanup();
 
+    m_gpuTimer.reset();
+    m_decorationRasterizer.reset();
+    m_decorationAtlas.reset();
     delete m_syncManager;
 
     // backend might be still needed for a different scene
@@ -648,6 +667,12 @@ qint64 SceneOpenGL::paint(QRegion damage, std::deque<Toplevel*> const& toplevels
     int mask = 0;
     updateProjectionMatrix();
 
+    if (m_gpuTimer) {
+        m_gpuTimer->beginFrame(nullptr);
+    }
+
+    updateDecorations();
+
     // Call generic implementation.
     paintScreen(&mask, damage, repaint, &update, &valid, presentTime, projectionMatrix());
 
@@ -666,9 +691,21 @@ qint64 SceneOpenGL::paint(QRegion damage, std::deque<Toplevel*> const& toplevels
         }
     }
 
+    if (m_gpuTimer) {
+        m_gpuTimer->endFrame();
+    }
+
+    auto pixelBuffer = GLPixelUnpackBuffer::streamingBuffer();
+
     GLVertexBuffer::streamingBuffer()->endOfFrame();
+    if (pixelBuffer) {
+        pixelBuffer->endOfFrame();
+    }
     m_backend->endRenderingFrame(valid, update);
     GLVertexBuffer::streamingBuffer()->framePosted();
+    if (pixelBuffer) {
+        pixelBuffer->framePosted();
+    }
 
     if (m_currentFence) {
         if (!m_syncManager->updateFences()) {
@@ -693,6 +730,31 @@ int64_t SceneOpenGL::paint(AbstractOutput* output, QRegion damage,
     // Trigger render timer start.
     m_backend->prepareRenderingFrame();
 
+    if (auto window = direct_scanout_candidate(output)) {
+        if (m_backend->directScanout(output, window)) {
+            // Nothing is painted, but the windows on the output are up to date.
+            for (auto scene_window : qAsConst(stacking_order)) {
+                scene_window->window()->resetRepaints(output);
+            }
+            // Overlay planes are disabled with the scanout. The windows leaving them are painted
+            // once the output is composited again.
+            Compositor::self()->addRepaint(set_overlay_windows(output, {}));
+            clearStackingOrder();
+            return m_backend->renderTime();
+        }
+    }
+
+    // The top-most windows that the backend shows on overlay planes are not composited.
+    auto overlays = overlay_candidates(output);
+    overlays.resize(overlays.empty() ? 0 : m_backend->overlayScanout(output, overlays));
+    damage += set_overlay_windows(output, overlays);
+    for (auto toplevel : overlays) {
+        auto it = std::find_if(stacking_order.begin(), stacking_order.end(),
+                               [toplevel](auto window) { return window->window() == toplevel; });
+        stacking_order.erase(it);
+        toplevel->resetRepaints(output);
+    }
+
     // Makes context current on the output.
     auto const repaint = m_backend->prepareRenderingForScreen(output);
 
@@ -717,14 +779,32 @@ int64_t SceneOpenGL::paint(AbstractOutput* output, QRegion damage,
     QRegion valid;
     repaint_output = output;
 
+    if (m_gpuTimer) {
+        m_gpuTimer->beginFrame(output);
+    }
+
+    updateDecorations();
+
     // Call generic implementation.
     paintScreen(&mask, damage.intersected(geo), repaint, &update, &valid, presentTime,
                 projectionMatrix());
     paintCursor();
 
+    if (m_gpuTimer) {
+        m_gpuTimer->endFrame();
+    }
+
+    auto pixelBuffer = GLPixelUnpackBuffer::streamingBuffer();
+
     GLVertexBuffer::streamingBuffer()->endOfFrame();
+    if (pixelBuffer) {
+        pixelBuffer->endOfFrame();
+    }
     m_backend->endRenderingFrameForScreen(output, valid, update);
     GLVertexBuffer::streamingBuffer()->framePosted();
+    if (pixelBuffer) {
+        pixelBuffer->framePosted();
+    }
 
     clearStackingOrder();
     repaint_output = nullptr;
@@ -732,6 +812,14 @@ int64_t SceneOpenGL::paint(AbstractOutput* output, QRegion damage,
     return m_backend->renderTime();
 }
 
+int64_t SceneOpenGL::gpuPaintDuration(AbstractOutput* output) const
+{
+    if (!m_gpuTimer) {
+        return 0;
+    }
+    return m_gpuTimer->lastFrameDuration(output);
+}
+
 std::deque<Toplevel*> SceneOpenGL::get_leads(std::deque<Toplevel*> const& windows)
 {
     std::deque<Toplevel*> leads;
@@ -763,6 +851,125 @@ std::deque<Toplevel*> SceneOpenGL::get_leads(std::deque<Toplevel*> const& window
     return leads;
 }
 
+/**
+ * Whether @p window shows nothing but its buffer in its render geometry, such that the buffer can
+ * be put on a plane as it is.
+ */
+static bool shows_plain_buffer(Scene::Window* window)
+{
+    auto toplevel = window->window();
+    if (!window->isOpaque() || win::decoration(toplevel) || !toplevel->surface()) {
+        return false;
+    }
+    if (toplevel->bufferScale() != 1 || toplevel->surface()->sourceRectangle().isValid()) {
+        return false;
+    }
+
+    // Subsurfaces are painted together with their lead.
+    auto const& children = toplevel->transient()->children;
+    return std::none_of(children.cbegin(), children.cend(),
+                        [](auto child) { return child->transient()->annexed; });
+}
+
+Toplevel* SceneOpenGL::direct_scanout_candidate(AbstractOutput* output) const
+{
+    // Effects and the software cursor paint on top of the windows.
+    if (static_cast<EffectsHandlerImpl*>(effects)->blocksDirectScanout()) {
+        return nullptr;
+    }
+    auto platform = kwinApp()->platform();
+    if (platform->usesSoftwareCursor() && !platform->isCursorHidden()) {
+        return nullptr;
+    }
+    if (output->scale() != 1) {
+        return nullptr;
+    }
+
+    auto const output_geo = output->geometry();
+
+    for (auto it = stacking_order.crbegin(); it != stacking_order.crend(); ++it) {
+        auto window = *it;
+        auto toplevel = window->window();
+
+        window->resetPaintingEnabled();
+        if (!window->isPaintingEnabled() || !win::visible_rect(toplevel).intersects(output_geo)) {
+            continue;
+        }
+
+        // The top-most window on the output must show nothing but its buffer on all of it.
+        if (!shows_plain_buffer(window) || win::render_geometry(toplevel) != output_geo) {
+            return nullptr;
+        }
+        return toplevel;
+    }
+
+    return nullptr;
+}
+
+std::deque<Toplevel*> SceneOpenGL::overlay_candidates(AbstractOutput* output) const
+{
+    // Same as for direct scanout, nothing may be painted on top of the windows.
+    if (static_cast<EffectsHandlerImpl*>(effects)->blocksDirectScanout()) {
+        return {};
+    }
+    auto platform = kwinApp()->platform();
+    if (platform->usesSoftwareCursor() && !platform->isCursorHidden()) {
+        return {};
+    }
+    if (output->scale() != 1) {
+        return {};
+    }
+
+    auto const output_geo = output->geometry();
+    std::deque<Toplevel*> candidates;
+
+    // Only windows from the top qualify. A window below a composited one would cover it.
+    for (auto it = stacking_order.crbegin(); it != stacking_order.crend(); ++it) {
+        auto window = *it;
+        auto toplevel = window->window();
+
+        window->resetPaintingEnabled();
+        auto const visible = win::visible_rect(toplevel);
+        if (!window->isPaintingEnabled() || !visible.intersects(output_geo)) {
+            continue;
+        }
+
+        // Shadows are painted with the window, so there must be none.
+        if (!shows_plain_buffer(window) || visible != win::render_geometry(toplevel)
+            || !output_geo.contains(visible)) {
+            break;
+        }
+        candidates.push_back(toplevel);
+    }
+
+    return candidates;
+}
+
+QRegion SceneOpenGL::set_overlay_windows(AbstractOutput* output,
+                                         std::deque<Toplevel*> const& windows)
+{
+    auto& current = m_overlayWindows[output];
+
+    // The composited content below a window on a plane is outdated. Where a window leaves the
+    // planes or moves on them, the output must be painted again. Windows are only compared, they
+    // might be gone already.
+    QRegion damage;
+    for (auto const& [toplevel, geo] : current) {
+        auto const kept = std::any_of(windows.cbegin(), windows.cend(), [&](auto window) {
+            return window == toplevel && win::render_geometry(window) == geo;
+        });
+        if (!kept) {
+            damage += geo;
+        }
+    }
+
+    current.clear();
+    for (auto window : windows) {
+        current.emplace_back(window, win::render_geometry(window));
+    }
+    return damage;
+}
+
 QMatrix4x4 SceneOpenGL::transformation(int mask, const ScreenPaintData &data) const
 {
     QMatrix4x4 matrix;
@@ -937,7 +1144,35 @@ Shadow *SceneOpenGL::createShadow(Toplevel *toplevel)
 
 Decoration::Renderer *SceneOpenGL::createDecorationRenderer(Decoration::DecoratedClientImpl *impl)
 {
-    return new SceneOpenGLDecorationRenderer(impl);
+    return new SceneOpenGLDecorationRenderer(impl, this);
+}
+
+void SceneOpenGL::updateDecorations()
+{
+    // Rasterize the decorations of all windows at once so they are spread over the workers.
+    std::vector<SceneOpenGLDecorationRenderer*> renderers;
+
+    for (auto window : qAsConst(stacking_order)) {
+        auto toplevel = window->window();
+        if (!toplevel->control || toplevel->noBorder() || !win::decoration(toplevel)) {
+            continue;
+        }
+        auto renderer
+            = static_cast<SceneOpenGLDecorationRenderer*>(toplevel->control->deco().client->renderer());
+        if (renderer && renderer->prepare(m_decorationRasterizer.get())) {
+            renderers.push_back(renderer);
+        }
+    }
+
+    if (renderers.empty()) {
+        return;
+    }
+
+    m_decorationRasterizer->run();
+    for (auto renderer : renderers) {
+        renderer->upload();
+    }
+    m_decorationRasterizer->clear();
 }
 
 bool SceneOpenGL::animationsSupported() const
@@ -1068,6 +1303,9 @@ void SceneOpenGL2::updateProjectionMatrix()
 void SceneOpenGL2::paintSimpleScreen(int mask, QRegion region)
 {
     m_screenProjectionMatrix = m_projectionMatrix;
+    if (m_lanczosFilter) {
+        m_lanczosFilter->beginFrame();
+    }
 
     Scene::paintSimpleScreen(mask, region);
 }
@@ -1077,6 +1315,9 @@ void SceneOpenGL2::paintGenericScreen(int mask, ScreenPaintData data)
     const QMatrix4x4 screenMatrix = transformation(mask, data);
 
     m_screenProjectionMatrix = m_projectionMatrix * screenMatrix;
+    if (m_lanczosFilter) {
+        m_lanczosFilter->beginFrame();
+    }
 
     Scene::paintGenericScreen(mask, data);
 }
@@ -1109,6 +1350,9 @@ void SceneOpenGL2::finalDrawWindow(EffectWindowImpl* w, int mask, QRegion region
 
 void SceneOpenGL2::performPaintWindow(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data)
 {
+    auto const timer = gpuTimer();
+    auto const gpuSample = timer ? timer->beginWindow(w->window()) : -1;
+
     if (mask & PAINT_WINDOW_LANCZOS) {
         if (!m_lanczosFilter) {
             m_lanczosFilter = new LanczosFilter(this);
@@ -1123,6 +1367,10 @@ void SceneOpenGL2::performPaintWindow(EffectWindowImpl* w, int mask, QRegion reg
         m_lanczosFilter->performPaint(w, mask, region, data);
     } else
         w->sceneWindow()->performPaint(mask, region, data);
+
+    if (timer) {
+        timer->endWindow(gpuSample);
+    }
 }
 
 //****************************************
@@ -1261,7 +1509,7 @@ void OpenGLWindow::endRenderWindow()
     }
 }
 
-GLTexture *OpenGLWindow::getDecorationTexture() const
+const SceneOpenGLDecorationRenderer *OpenGLWindow::decorationRenderer() const
 {
     if (toplevel->control) {
         if (toplevel->noBorder()) {
@@ -1274,15 +1522,13 @@ GLTexture *OpenGLWindow::getDecorationTexture() const
         if (auto renderer
                 = static_cast<SceneOpenGLDecorationRenderer*>(toplevel->control->deco().client->renderer())) {
             renderer->render();
-            return renderer->texture();
+            return renderer;
         }
     } else if (auto remnant = toplevel->remnant()) {
         if (!remnant->control || remnant->no_border) {
             return nullptr;
         }
-        if (auto renderer = static_cast<const SceneOpenGLDecorationRenderer*>(remnant->decoration_renderer)) {
-            return renderer->texture();
-        }
+        return static_cast<const SceneOpenGLDecorationRenderer*>(remnant->decoration_renderer);
     }
     return nullptr;
 }
@@ -1325,7 +1571,10 @@ void OpenGLWindow::setupLeafNodes(std::vector<LeafNode>& nodes,
     }
 
     if (!quads[DecorationLeaf].isEmpty()) {
-        nodes[DecorationLeaf].texture = getDecorationTexture();
+        if (auto renderer = decorationRenderer()) {
+            nodes[DecorationLeaf].texture = renderer->texture();
+            nodes[DecorationLeaf].textureOffset = renderer->textureOffset();
+        }
         nodes[DecorationLeaf].opacity = data.opacity();
         nodes[DecorationLeaf].hasAlpha = true;
         nodes[DecorationLeaf].coordinateType = UnnormalizedCoordinates;
@@ -1546,7 +1795,8 @@ void OpenGLWindow::performPaint(int mask, QRegion region, WindowPaintData data)
         nodes[i].firstVertex = v;
         nodes[i].vertexCount = quads[i].count() * verticesPerQuad;
 
-        const QMatrix4x4 matrix = nodes[i].texture->matrix(nodes[i].coordinateType);
+        QMatrix4x4 matrix = nodes[i].texture->matrix(nodes[i].coordinateType);
+        matrix.translate(nodes[i].textureOffset.x(), nodes[i].textureOffset.y());
 
         quads[i].makeInterleavedArrays(primitiveType, &map[v], matrix);
         v += quads[i].count() * verticesPerQuad;
@@ -2535,9 +2785,11 @@ bool SceneOpenGLShadow::prepareBackend()
     return true;
 }
 
-SceneOpenGLDecorationRenderer::SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client)
+SceneOpenGLDecorationRenderer::SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client,
+                                                             SceneOpenGL *scene)
     : Renderer(client)
-    , m_texture()
+    , m_scene(scene)
+    , m_atlas(scene->decorationAtlas())
 {
     connect(this, &Renderer::renderScheduled,
             client->client(), static_cast<void (Toplevel::*)(const QRect&)>(&Toplevel::addRepaint));
@@ -2548,105 +2800,50 @@ SceneOpenGLDecorationRenderer::~SceneOpenGLDecorationRenderer()
     if (Scene *scene = Compositor::self()->scene()) {
         scene->makeOpenGLContextCurrent();
     }
-}
-
-// Rotates the given source rect 90° counter-clockwise,
-// and flips it vertically
-static QImage rotate(const QImage &srcImage, const QRect &srcRect)
-{
-    auto dpr = srcImage.devicePixelRatio();
-    QImage image(srcRect.height() * dpr, srcRect.width() * dpr, srcImage.format());
-    image.setDevicePixelRatio(dpr);
-    const QPoint srcPoint(srcRect.x() * dpr, srcRect.y() * dpr);
-
-    const uint32_t *src = reinterpret_cast<const uint32_t *>(srcImage.bits());
-    uint32_t *dst = reinterpret_cast<uint32_t *>(image.bits());
-
-    for (int x = 0; x < image.width(); x++) {
-        const uint32_t *s = src + (srcPoint.y() + x) * srcImage.width() + srcPoint.x();
-        uint32_t *d = dst + x;
-
-        for (int y = 0; y < image.height(); y++) {
-            *d = s[y];
-            d += image.width();
-        }
+    if (m_atlas) {
+        m_atlas->release(m_slot);
     }
-
-    return image;
-}
-
-static void clamp_row(int left, int width, int right, const uint32_t *src, uint32_t *dest)
-{
-    std::fill_n(dest, left, *src);
-    std::copy(src, src + width, dest + left);
-    std::fill_n(dest + left + width, right, *(src + width - 1));
 }
 
-static void clamp_sides(int left, int width, int right, const uint32_t *src, uint32_t *dest)
-{
-    std::fill_n(dest, left, *src);
-    std::fill_n(dest + left + width, right, *(src + width - 1));
-}
-
-static void clamp(QImage &image, const QRect &viewport)
+void SceneOpenGLDecorationRenderer::render()
 {
-    Q_ASSERT(image.depth() == 32);
-
-    const QRect rect = image.rect();
-
-    const int left = viewport.left() - rect.left();
-    const int top = viewport.top() - rect.top();
-    const int right = rect.right() - viewport.right();
-    const int bottom = rect.bottom() - viewport.bottom();
-
-    const int width = rect.width() - left - right;
-    const int height = rect.height() - top - bottom;
-
-    const uint32_t *firstRow = reinterpret_cast<uint32_t *>(image.scanLine(top));
-    const uint32_t *lastRow = reinterpret_cast<uint32_t *>(image.scanLine(top + height - 1));
-
-    for (int i = 0; i < top; ++i) {
-        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(i));
-        clamp_row(left, width, right, firstRow + left, dest);
-    }
-
-    for (int i = 0; i < height; ++i) {
-        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(top + i));
-        clamp_sides(left, width, right, dest + left, dest);
-    }
-
-    for (int i = 0; i < bottom; ++i) {
-        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(top + height + i));
-        clamp_row(left, width, right, lastRow + left, dest);
+    auto rasterizer = m_scene->decorationRasterizer();
+    if (!rasterizer || !prepare(rasterizer)) {
+        return;
     }
+    rasterizer->run();
+    upload();
+    rasterizer->clear();
 }
 
-void SceneOpenGLDecorationRenderer::render()
+bool SceneOpenGLDecorationRenderer::prepare(DecorationRasterizer *rasterizer)
 {
     const QRegion scheduled = getScheduled();
     const bool dirty = areImageSizesDirty();
     if (scheduled.isEmpty() && !dirty) {
-        return;
+        return false;
     }
     if (dirty) {
-        resizeTexture();
+        resizeSlot();
         resetImageSizesDirty();
     }
 
-    if (!m_texture) {
+    if (!m_slot.isValid()) {
         // for invalid sizes we get no texture, see BUG 361551
-        return;
+        return false;
     }
 
     QRect left, top, right, bottom;
     client()->client()->layoutDecorationRects(left, top, right, bottom);
 
     const QRect geometry = dirty ? QRect(QPoint(0, 0), client()->client()->size()) : scheduled.boundingRect();
+    const qreal devicePixelRatio = client()->client()->screenScale();
 
     // We pad each part in the decoration atlas in order to avoid texture bleeding.
     const int padding = 1;
 
-    auto renderPart = [=](const QRect &geo, const QRect &partRect, const QPoint &position, bool rotated = false) {
+    auto addPart = [&](const QRect &partRect, const QPoint &position, bool rotated = false) {
+        const QRect geo = partRect.intersected(geometry);
         if (!geo.isValid()) {
             return;
         }
@@ -2669,31 +2866,17 @@ void SceneOpenGLDecorationRenderer::render()
             rect.setBottom(rect.bottom() + padding);
         }
 
-        QRect viewport = geo.translated(-rect.x(), -rect.y());
-        const qreal devicePixelRatio = client()->client()->screenScale();
-
-        QImage image(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
-        image.setDevicePixelRatio(devicePixelRatio);
-        image.fill(Qt::transparent);
-
-        QPainter painter(&image);
-        painter.setRenderHint(QPainter::Antialiasing);
-        painter.setViewport(QRect(viewport.topLeft(), viewport.size() * devicePixelRatio));
-        painter.setWindow(QRect(geo.topLeft(), geo.size() * devicePixelRatio));
-        painter.setClipRect(geo);
-        renderToPainter(&painter, geo);
-        painter.end();
-
-        clamp(image, QRect(viewport.topLeft(), viewport.size() * devicePixelRatio));
+        auto part = rasterizer->add(geo, rect, devicePixelRatio, rotated,
+                                    [this, geo](QPainter *painter) {
+                                        renderToPainter(painter, geo);
+                                    });
 
+        // Rotated parts are stored transposed.
+        QPoint offset = rect.topLeft() - partRect.topLeft();
         if (rotated) {
-            // TODO: get this done directly when rendering to the image
-            image = rotate(image, QRect(QPoint(), rect.size()));
-            viewport = QRect(viewport.y(), viewport.x(), viewport.height(), viewport.width());
+            offset = QPoint(offset.y(), offset.x());
         }
-
-        const QPoint dirtyOffset = geo.topLeft() - partRect.topLeft();
-        m_texture->update(image, (position + dirtyOffset - viewport.topLeft()) * image.devicePixelRatio());
+        m_pendingParts.push_back({part, m_slot.rect.topLeft() + (position + offset) * devicePixelRatio});
     };
 
     const QPoint topPosition(padding, padding);
@@ -2701,19 +2884,28 @@ void SceneOpenGLDecorationRenderer::render()
     const QPoint leftPosition(padding, bottomPosition.y() + bottom.height() + 2 * padding);
     const QPoint rightPosition(padding, leftPosition.y() + left.width() + 2 * padding);
 
-    renderPart(left.intersected(geometry), left, leftPosition, true);
-    renderPart(top.intersected(geometry), top, topPosition);
-    renderPart(right.intersected(geometry), right, rightPosition, true);
-    renderPart(bottom.intersected(geometry), bottom, bottomPosition);
+    addPart(left, leftPosition, true);
+    addPart(top, topPosition);
+    addPart(right, rightPosition, true);
+    addPart(bottom, bottomPosition);
+
+    return !m_pendingParts.empty();
 }
 
-static int align(int value, int align)
+void SceneOpenGLDecorationRenderer::upload()
 {
-    return (value + align - 1) & ~(align - 1);
+    for (auto const &pending : m_pendingParts) {
+        m_slot.texture->update(*pending.part->buffer, pending.target, pending.part->area);
+    }
+    m_pendingParts.clear();
 }
 
-void SceneOpenGLDecorationRenderer::resizeTexture()
+void SceneOpenGLDecorationRenderer::resizeSlot()
 {
+    if (!m_atlas) {
+        return;
+    }
+
     QRect left, top, right, bottom;
     client()->client()->layoutDecorationRects(left, top, right, bottom);
     QSize size;
@@ -2728,20 +2920,13 @@ void SceneOpenGLDecorationRenderer::resizeTexture()
     size.rwidth() += 2 * padding;
     size.rheight() += 4 * 2 * padding;
 
-    size.rwidth() = align(size.width(), 128);
-
     size *= client()->client()->screenScale();
-    if (m_texture && m_texture->size() == size)
+    if (m_slot.isValid() && m_slot.rect.size() == size) {
         return;
-
-    if (!size.isEmpty()) {
-        m_texture.reset(new GLTexture(GL_RGBA8, size.width(), size.height()));
-        m_texture->setYInverted(true);
-        m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
-        m_texture->clear();
-    } else {
-        m_texture.reset();
     }
+
+    m_atlas->release(m_slot);
+    m_slot = m_atlas->allocate(size);
 }
 
 void SceneOpenGLDecorationRenderer::reparent(Toplevel* window)
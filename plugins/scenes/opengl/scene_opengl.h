@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef KWIN_SCENE_OPENGL_H
 #define KWIN_SCENE_OPENGL_H
 
+#include "decoration_atlas.h"
+#include "decoration_rasterizer.h"
 #include "scene.h"
 #include "shadow.h"
 
@@ -30,8 +32,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "decorations/decorationrenderer.h"
 #include "platformsupport/scenes/opengl/backend.h"
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
 namespace KWin
 {
+class GpuTimer;
 class LanczosFilter;
 class OpenGLBackend;
 class OpenGLWindow;
@@ -53,6 +61,7 @@ public:
     int64_t paint(AbstractOutput* output, QRegion damage,
                   std::deque<Toplevel*> const& windows,
                   std::chrono::milliseconds presentTime) override;
+    int64_t gpuPaintDuration(AbstractOutput* output = nullptr) const override;
 
     Scene::EffectFrame *createEffectFrame(EffectFrameImpl *frame) override;
     Shadow *createShadow(Toplevel *toplevel) override;
@@ -86,6 +95,17 @@ public:
         return m_backend;
     }
 
+    GpuTimer *gpuTimer() const {
+        return m_gpuTimer.get();
+    }
+
+    std::shared_ptr<DecorationAtlas> decorationAtlas() const {
+        return m_decorationAtlas;
+    }
+    DecorationRasterizer *decorationRasterizer() const {
+        return m_decorationRasterizer.get();
+    }
+
     QVector<QByteArray> openGLPlatformInterfaceExtensions() const override;
 
     static SceneOpenGL *createScene(QObject *parent);
@@ -110,10 +130,19 @@ protected:
 private:
     bool viewportLimitsMatched(const QSize &size) const;
     std::deque<Toplevel*> get_leads(std::deque<Toplevel*> const& windows);
+    Toplevel* direct_scanout_candidate(AbstractOutput* output) const;
+    std::deque<Toplevel*> overlay_candidates(AbstractOutput* output) const;
+    QRegion set_overlay_windows(AbstractOutput* output, std::deque<Toplevel*> const& windows);
+    void updateDecorations();
 
     OpenGLBackend *m_backend;
     SyncManager *m_syncManager;
     SyncObject *m_currentFence;
+    std::unique_ptr<GpuTimer> m_gpuTimer;
+    std::shared_ptr<DecorationAtlas> m_decorationAtlas;
+    std::unique_ptr<DecorationRasterizer> m_decorationRasterizer;
+    // Windows shown on overlay planes per output, with their geometries at that time.
+    std::map<AbstractOutput*, std::vector<std::pair<Toplevel*, QRect>>> m_overlayWindows;
     bool m_debug;
 };
 
@@ -154,6 +183,7 @@ private:
 };
 
 class OpenGLWindowPixmap;
+class SceneOpenGLDecorationRenderer;
 
 class OpenGLWindow final : public Scene::Window
 {
@@ -173,6 +203,8 @@ public:
         }
 
         GLTexture *texture;
+        // Position of the texture coordinates in the texture, in pixels.
+        QPoint textureOffset;
         int firstVertex;
         int vertexCount;
         float opacity;
@@ -188,7 +220,7 @@ public:
 
 private:
     QMatrix4x4 transformation(int mask, const WindowPaintData &data) const;
-    GLTexture *getDecorationTexture() const;
+    const SceneOpenGLDecorationRenderer *decorationRenderer() const;
     QMatrix4x4 modelViewProjectionMatrix(int mask, const WindowPaintData &data) const;
     QVector4D modulate(float opacity, float brightness) const;
     void setBlendEnabled(bool enabled);
@@ -288,22 +320,47 @@ public:
         Bottom,
         Count
     };
-    explicit SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client);
+    SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client, SceneOpenGL *scene);
     ~SceneOpenGLDecorationRenderer() override;
 
     void render() override;
     void reparent(Toplevel *window) override;
 
-    GLTexture *texture() {
-        return m_texture.data();
-    }
+    /**
+     * Adds the scheduled repaints to @p rasterizer. Returns false if there are none.
+     */
+    bool prepare(DecorationRasterizer *rasterizer);
+    /**
+     * Uploads the parts added by prepare once the rasterizer has run.
+     */
+    void upload();
+
+    /**
+     * The texture is shared with the decorations of other windows.
+     */
     GLTexture *texture() const {
-        return m_texture.data();
+        return m_slot.texture;
+    }
+    /**
+     * Position of the decoration in the texture, in device pixels.
+     */
+    QPoint textureOffset() const {
+        return m_slot.rect.topLeft();
     }
 
 private:
-    void resizeTexture();
-    QScopedPointer<GLTexture> m_texture;
+    struct PendingPart {
+        DecorationRasterizer::Part *part;
+        // Position of the buffer area in the texture.
+        QPoint target;
+    };
+
+    void resizeSlot();
+
+    SceneOpenGL *m_scene;
+    std::shared_ptr<DecorationAtlas> m_atlas;
+    DecorationAtlas::Slot m_slot;
+    std::vector<PendingPart> m_pendingParts;
 };
 
 inline bool SceneOpenGL::hasPendingFlush() const
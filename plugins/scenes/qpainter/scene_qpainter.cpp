@@ -18,6 +18,7 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "scene_qpainter.h"
+#include "tile_renderer.h"
 
 #include "abstract_output.h"
 #include "composite.h"
@@ -42,6 +43,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QDebug>
 #include <QPainter>
+#include <QThread>
 #include <KDecoration2/Decoration>
 
 #include <cmath>
@@ -69,6 +71,12 @@ SceneQPainter::SceneQPainter(QPainterBackend *backend, QObject *parent)
     , m_backend(backend)
     , m_painter(new QPainter())
 {
+    // Tiles are composited in parallel, which only pays off with more than one core. Setting
+    // KWIN_QPAINTER_TILED=0 disables it.
+    if (QThread::idealThreadCount() > 1
+            && qEnvironmentVariable("KWIN_QPAINTER_TILED") != QLatin1String("0")) {
+        m_tileRenderer.reset(new QPainterTileRenderer);
+    }
 }
 
 SceneQPainter::~SceneQPainter()
@@ -106,10 +114,15 @@ int64_t SceneQPainter::paint(AbstractOutput* output, QRegion damage,
     int mask = 0;
     m_backend->prepareRenderingFrame();
 
+    // What changed since the buffer was painted last is repaired but not part of the damage.
+    QRegion repaint;
+
     auto const needsFullRepaint = m_backend->needsFullRepaint();
     if (needsFullRepaint) {
         mask |= Scene::PAINT_SCREEN_BACKGROUND_FIRST;
         damage = screens()->geometry();
+    } else {
+        repaint = m_backend->bufferDamage(output);
     }
 
     auto const geometry = output->geometry();
@@ -126,8 +139,19 @@ int64_t SceneQPainter::paint(AbstractOutput* output, QRegion damage,
     repaint_output = output;
     QRegion updateRegion, validRegion;
 
-    paintScreen(&mask, damage.intersected(geometry), QRegion(), &updateRegion, &validRegion,
-                presentTime);
+    // Effects paint directly with the scene painter in any order, so the draw operations can
+    // only be recorded and rendered in tiles when no effect takes part in the frame.
+    m_recording = m_tileRenderer
+        && !static_cast<EffectsHandlerImpl*>(effects)->hasActiveEffects();
+
+    paintScreen(&mask, damage.intersected(geometry), repaint.intersected(geometry), &updateRegion,
+                &validRegion, presentTime);
+
+    if (m_recording) {
+        m_recording = false;
+        m_tileRenderer->render(buffer,
+                               m_painter->combinedTransform().map(validRegion & geometry));
+    }
     paintCursor();
 
     m_painter->restore();
@@ -143,12 +167,28 @@ int64_t SceneQPainter::paint(AbstractOutput* output, QRegion damage,
 
 void SceneQPainter::paintBackground(QRegion region)
 {
+    if (m_recording) {
+        for (const QRect &rect : region) {
+            m_tileRenderer->fillRect(m_painter.data(), rect, Qt::black);
+        }
+        return;
+    }
     m_painter->setBrush(Qt::black);
     for (const QRect &rect : region) {
         m_painter->drawRect(rect);
     }
 }
 
+void SceneQPainter::drawImage(QPainter *painter, const QRectF &target, const QImage &image,
+                              const QRectF &source)
+{
+    if (m_recording && painter == m_painter.data()) {
+        m_tileRenderer->drawImage(painter, target, image, source);
+        return;
+    }
+    painter->drawImage(target, image, source);
+}
+
 void SceneQPainter::paintCursor()
 {
     if (!kwinApp()->platform()->usesSoftwareCursor()) {
@@ -294,7 +334,7 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
         }
         target = win::render_geometry(toplevel).translated(-pos());
     }
-    painter->drawImage(target, pixmap->image(), source);
+    m_scene->drawImage(painter, target, pixmap->image(), source);
 
     if (!opaque) {
         tempPainter.restore();
@@ -304,7 +344,8 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
         tempPainter.fillRect(QRect(QPoint(0, 0), win::visible_rect(toplevel).size()), translucent);
         tempPainter.end();
         painter = scenePainter;
-        painter->drawImage(win::visible_rect(toplevel).topLeft() - toplevel->frameGeometry().topLeft(), tempImage);
+        const QPoint topLeft = win::visible_rect(toplevel).topLeft() - toplevel->frameGeometry().topLeft();
+        m_scene->drawImage(painter, QRectF(topLeft, tempImage.size()), tempImage, tempImage.rect());
     }
 
     painter->restore();
@@ -329,7 +370,7 @@ void SceneQPainter::Window::renderShadow(QPainter* painter)
         QRectF source(topLeft.textureX(), topLeft.textureY(),
                       bottomRight.textureX() - topLeft.textureX(),
                       bottomRight.textureY() - topLeft.textureY());
-        painter->drawImage(target, shadowTexture, source);
+        m_scene->drawImage(painter, target, shadowTexture, source);
     }
 }
 
@@ -364,10 +405,14 @@ void SceneQPainter::Window::renderWindowDecorations(QPainter *painter)
         return;
     }
 
-    painter->drawImage(dtr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Top));
-    painter->drawImage(dlr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Left));
-    painter->drawImage(drr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Right));
-    painter->drawImage(dbr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Bottom));
+    auto drawPart = [&](const QRect &rect, SceneQPainterDecorationRenderer::DecorationPart part) {
+        const QImage image = renderer->image(part);
+        m_scene->drawImage(painter, rect, image, image.rect());
+    };
+    drawPart(dtr, SceneQPainterDecorationRenderer::DecorationPart::Top);
+    drawPart(dlr, SceneQPainterDecorationRenderer::DecorationPart::Left);
+    drawPart(drr, SceneQPainterDecorationRenderer::DecorationPart::Right);
+    drawPart(dbr, SceneQPainterDecorationRenderer::DecorationPart::Bottom);
 }
 
 WindowPixmap *SceneQPainter::Window::createWindowPixmap()
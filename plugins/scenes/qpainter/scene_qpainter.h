@@ -28,6 +28,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace KWin {
 
+class QPainterTileRenderer;
+
 class KWIN_EXPORT SceneQPainter : public Scene
 {
     Q_OBJECT
@@ -71,8 +73,18 @@ protected:
 
 private:
     explicit SceneQPainter(QPainterBackend *backend, QObject *parent = nullptr);
+
+    /**
+     * Draws with @p painter or records the operation for the tile renderer if the painter is
+     * the scene painter and the frame is rendered in tiles.
+     */
+    void drawImage(QPainter *painter, const QRectF &target, const QImage &image,
+                   const QRectF &source);
+
     QScopedPointer<QPainterBackend> m_backend;
     QScopedPointer<QPainter> m_painter;
+    QScopedPointer<QPainterTileRenderer> m_tileRenderer;
+    bool m_recording = false;
     class Window;
 };
 
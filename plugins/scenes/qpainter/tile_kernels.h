@@ -0,0 +1,101 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace KWin
+{
+
+/**
+ * Pixel kernels of the QPainterTileRenderer. All pixels are 32 bit premultiplied ARGB.
+ */
+namespace TileKernels
+{
+
+// Multiplies all channels of the premultiplied pixel with alpha / 255, rounding like QPainter.
+inline uint32_t byteMul(uint32_t pixel, uint32_t alpha)
+{
+    uint32_t rb = (pixel & 0xff00ff) * alpha;
+    rb = ((rb + ((rb >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+    uint32_t ag = ((pixel >> 8) & 0xff00ff) * alpha;
+    ag = (ag + ((ag >> 8) & 0xff00ff) + 0x800080) & 0xff00ff00;
+    return ag | rb;
+}
+
+inline void blendPixel(uint32_t &dst, uint32_t src)
+{
+    const uint32_t alpha = src >> 24;
+    if (alpha == 0xff) {
+        dst = src;
+    } else if (alpha) {
+        dst = src + byteMul(dst, 0xff - alpha);
+    }
+}
+
+inline void copyPixels(uint32_t *dst, const uint32_t *src, int count)
+{
+    std::memcpy(dst, src, count * sizeof(uint32_t));
+}
+
+// Source over for premultiplied ARGB32.
+inline void blendPixels(uint32_t *dst, const uint32_t *src, int count)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+    const __m128i max = _mm_set1_epi32(0xff);
+    const __m128i half = _mm_set1_epi16(0x80);
+
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+        const __m128i alpha = _mm_and_si128(s, alphaMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xffff) {
+            // All opaque.
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), s);
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xffff) {
+            // All transparent.
+            continue;
+        }
+
+        // Inverse alpha of each pixel in both 16 bit halves of its 32 bit lane.
+        __m128i inv = _mm_sub_epi32(max, _mm_srli_epi32(s, 24));
+        inv = _mm_or_si128(inv, _mm_slli_epi32(inv, 16));
+
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+
+        auto mul = [&](__m128i channels, __m128i factors) {
+            __m128i t = _mm_mullo_epi16(channels, factors);
+            t = _mm_add_epi16(t, _mm_srli_epi16(t, 8));
+            t = _mm_add_epi16(t, half);
+            return _mm_srli_epi16(t, 8);
+        };
+        const __m128i lo = mul(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi32(inv, inv));
+        const __m128i hi = mul(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi32(inv, inv));
+
+        const __m128i result = _mm_add_epi8(s, _mm_packus_epi16(lo, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), result);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        blendPixel(dst[i], src[i]);
+    }
+}
+
+}
+
+}
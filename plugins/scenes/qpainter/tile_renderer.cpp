@@ -0,0 +1,237 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "tile_renderer.h"
+#include "tile_kernels.h"
+
+#include <QPainter>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace KWin
+{
+
+namespace
+{
+
+using namespace TileKernels;
+
+// Rows of a band. Smaller bands balance better between the workers, larger ones reduce the
+// per-band overhead of iterating the operations.
+constexpr int s_minBandHeight = 32;
+
+bool isPlain32(QImage::Format format)
+{
+    return format == QImage::Format_RGB32 || format == QImage::Format_ARGB32_Premultiplied;
+}
+
+bool isIntegral(qreal value)
+{
+    return qFuzzyCompare(value + 1, std::round(value) + 1);
+}
+
+/**
+ * Draws an untransformed image operation with the kernels. Returns false if the operation is not
+ * supported by them.
+ */
+bool blitImage(uchar *bits, const QImage &buffer, const QTransform &transform,
+               const QRectF &target, const QImage &image, const QRectF &source,
+               const QRegion &region)
+{
+    if (!isPlain32(buffer.format()) || !isPlain32(image.format())) {
+        return false;
+    }
+    if (transform.type() > QTransform::TxTranslate || target.size() != source.size()) {
+        return false;
+    }
+
+    const QPointF deviceTopLeft = transform.map(target.topLeft());
+    for (auto value : {deviceTopLeft.x(), deviceTopLeft.y(), source.x(), source.y(),
+                       source.width(), source.height()}) {
+        if (!isIntegral(value)) {
+            return false;
+        }
+    }
+
+    // Device position = image position + offset
+    const QPoint offset = deviceTopLeft.toPoint() - source.topLeft().toPoint();
+    const QRect sourceRect = source.toRect() & image.rect();
+    const auto kernel = image.format() == QImage::Format_RGB32 ? copyPixels : blendPixels;
+    const int stride = buffer.bytesPerLine();
+
+    for (const QRect &rect : region & sourceRect.translated(offset)) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            auto dst = reinterpret_cast<uint32_t *>(bits + y * stride) + rect.x();
+            auto src = reinterpret_cast<const uint32_t *>(image.constScanLine(y - offset.y()))
+                + rect.x() - offset.x();
+            kernel(dst, src, rect.width());
+        }
+    }
+    return true;
+}
+
+bool fillColor(uchar *bits, const QImage &buffer, const QColor &color, const QRegion &region)
+{
+    if (!isPlain32(buffer.format()) || color.alpha() != 0xff) {
+        return false;
+    }
+
+    const uint32_t pixel = color.rgba();
+    const int stride = buffer.bytesPerLine();
+
+    for (const QRect &rect : region) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            auto dst = reinterpret_cast<uint32_t *>(bits + y * stride) + rect.x();
+            std::fill_n(dst, rect.width(), pixel);
+        }
+    }
+    return true;
+}
+
+}
+
+QPainterTileRenderer::QPainterTileRenderer()
+{
+    // The compositing thread takes part in rendering as well.
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+    // Keep the workers alive between frames.
+    m_pool.setExpiryTimeout(-1);
+}
+
+QPainterTileRenderer::~QPainterTileRenderer()
+{
+    m_pool.waitForDone();
+}
+
+void QPainterTileRenderer::record(QPainter *painter, DrawOp &&op)
+{
+    op.transform = painter->combinedTransform();
+    op.bounds = op.transform.mapRect(op.target).toAlignedRect();
+
+    op.clipped = painter->hasClipping();
+    if (op.clipped) {
+        // The clip region is returned in logical coordinates.
+        op.clip = op.transform.map(painter->clipRegion());
+        op.bounds &= op.clip.boundingRect();
+    }
+
+    if (!op.bounds.isEmpty()) {
+        m_ops.push_back(std::move(op));
+    }
+}
+
+void QPainterTileRenderer::drawImage(QPainter *painter, const QRectF &target, const QImage &image,
+                                     const QRectF &source)
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    DrawOp op;
+    op.image = image;
+    op.target = target;
+    op.source = source;
+    record(painter, std::move(op));
+}
+
+void QPainterTileRenderer::fillRect(QPainter *painter, const QRect &rect, const QColor &color)
+{
+    DrawOp op;
+    op.target = rect;
+    op.color = color;
+    record(painter, std::move(op));
+}
+
+void QPainterTileRenderer::render(QImage *buffer, const QRegion &damage)
+{
+    const QRegion region = damage & buffer->rect();
+    if (m_ops.empty() || region.isEmpty()) {
+        m_ops.clear();
+        return;
+    }
+
+    const QRect bounds = region.boundingRect();
+    const int threads = m_pool.maxThreadCount() + 1;
+    const int bandHeight = std::max(s_minBandHeight, bounds.height() / (threads * 4) + 1);
+
+    std::vector<QRect> bands;
+    for (int y = bounds.top(); y <= bounds.bottom(); y += bandHeight) {
+        const QRect band(0, y, buffer->width(), std::min(bandHeight, bounds.bottom() + 1 - y));
+        if (region.intersects(band)) {
+            bands.push_back(band);
+        }
+    }
+
+    // Detaches the buffer once here and not concurrently in the workers.
+    uchar *bits = buffer->bits();
+
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t index; (index = next++) < bands.size();) {
+            renderBand(bits, *buffer, bands[index], region);
+        }
+    };
+
+    const int workers = std::min<int>(m_pool.maxThreadCount(), bands.size() - 1);
+    for (int i = 0; i < workers; ++i) {
+        m_pool.start(work);
+    }
+    work();
+    m_pool.waitForDone();
+
+    m_ops.clear();
+}
+
+void QPainterTileRenderer::renderBand(uchar *bits, const QImage &buffer, const QRect &band,
+                                      const QRegion &damage) const
+{
+    const QRegion bandRegion = damage & band;
+
+    // Operations the kernels can not handle are painted with a QPainter on the band's rows.
+    QImage bandImage(bits + band.y() * buffer.bytesPerLine(), band.width(), band.height(),
+                     buffer.bytesPerLine(), buffer.format());
+    QPainter painter;
+    const auto toBand = QTransform::fromTranslate(0, -band.y());
+
+    for (const auto &op : m_ops) {
+        if (!op.bounds.intersects(band)) {
+            continue;
+        }
+        QRegion region = bandRegion & op.bounds;
+        if (op.clipped) {
+            region &= op.clip;
+        }
+        if (region.isEmpty()) {
+            continue;
+        }
+
+        if (op.image.isNull()) {
+            if (fillColor(bits, buffer, op.color, region)) {
+                continue;
+            }
+        } else if (blitImage(bits, buffer, op.transform, op.target, op.image, op.source,
+                             region)) {
+            continue;
+        }
+
+        if (!painter.isActive()) {
+            painter.begin(&bandImage);
+        }
+        // The clip is set in device coordinates before the operation's transformation.
+        painter.setTransform(toBand);
+        painter.setClipRegion(region);
+        painter.setTransform(op.transform * toBand);
+        if (op.image.isNull()) {
+            painter.fillRect(op.target, op.color);
+        } else {
+            painter.drawImage(op.target, op.image, op.source);
+        }
+    }
+}
+
+}
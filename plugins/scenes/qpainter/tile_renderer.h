@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QColor>
+#include <QImage>
+#include <QRegion>
+#include <QThreadPool>
+#include <QTransform>
+
+#include <vector>
+
+class QPainter;
+
+namespace KWin
+{
+
+/**
+ * Composites the draw operations of a frame in parallel.
+ *
+ * While the scene is traversed the operations are only recorded together with the transformation
+ * and clip of the painter they were issued on. Afterwards the damaged part of the buffer is split
+ * into horizontal bands which are painted concurrently by a pool of worker threads, each with its
+ * own QPainter on the rows of its band. Untransformed images in the common 32 bit formats are
+ * blended with dedicated kernels instead of a QPainter.
+ */
+class QPainterTileRenderer
+{
+public:
+    QPainterTileRenderer();
+    ~QPainterTileRenderer();
+
+    /**
+     * Records drawing the @p source rectangle of @p image into @p target with the current
+     * transformation and clip of @p painter.
+     */
+    void drawImage(QPainter *painter, const QRectF &target, const QImage &image,
+                   const QRectF &source);
+    void fillRect(QPainter *painter, const QRect &rect, const QColor &color);
+
+    /**
+     * Paints the recorded operations into @p buffer and clears the recording. Only the @p damage
+     * region, given in device coordinates of the buffer, is touched.
+     */
+    void render(QImage *buffer, const QRegion &damage);
+
+private:
+    struct DrawOp {
+        QTransform transform;
+        // In device coordinates, only valid if clipped is set.
+        QRegion clip;
+        bool clipped = false;
+        // Bounding rect of the operation in device coordinates.
+        QRect bounds;
+
+        // An image is drawn if set, else the target is filled with the color.
+        QImage image;
+        QRectF target;
+        QRectF source;
+        QColor color;
+    };
+
+    void record(QPainter *painter, DrawOp &&op);
+    void renderBand(uchar *bits, const QImage &buffer, const QRect &band,
+                    const QRegion &damage) const;
+
+    std::vector<DrawOp> m_ops;
+    QThreadPool m_pool;
+};
+
+}
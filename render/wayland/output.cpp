@@ -8,15 +8,13 @@
 #include "abstract_wayland_output.h"
 #include "composite.h"
 #include "effects.h"
+#include "options.h"
 #include "platform.h"
 #include "presentation.h"
 #include "wayland_server.h"
 #include "workspace.h"
 
-#include "win/transient.h"
-#include <kwingltexture.h>
-
-#include "perf/ftrace.h"
+#include "perf/trace.h"
 
 namespace KWin::render::wayland
 {
@@ -40,7 +38,7 @@ void output::add_repaint(QRegion const& region)
     set_delay_timer();
 }
 
-bool output::prepare_run(QRegion& repaints, std::deque<Toplevel*>& windows)
+bool output::prepare_run(QRegion& repaints)
 {
     delay_timer.stop();
 
@@ -55,15 +53,16 @@ bool output::prepare_run(QRegion& repaints, std::deque<Toplevel*>& windows)
         return false;
     }
 
-    // Create a list of all windows in the stacking order
-    windows = Workspace::self()->xStackingOrder();
+    // All windows in the stacking order. This is a reference, the list is only copied when
+    // the painted windows must be recomputed.
+    auto const& stacking = Workspace::self()->xStackingOrder();
     bool has_window_repaints{false};
 
-    for (auto win : windows) {
+    for (auto win : stacking) {
         if (win->has_pending_repaints()) {
             auto const window_repaint = win->repaints();
             if (window_repaint.intersected(base->geometry()).isEmpty()) {
-                // TODO(romangg): Remove win from windows list?
+                // Windows not on this output are culled by the scene when it paints untransformed.
                 continue;
             }
             has_window_repaints = true;
@@ -79,27 +78,10 @@ bool output::prepare_run(QRegion& repaints, std::deque<Toplevel*>& windows)
             }
         }
         if (win->resetAndFetchDamage()) {
-            // Discard the cached lanczos texture
-            if (win->transient()->annexed) {
-                win = win::lead_of_annexed_transient(win);
-            }
-            if (win->effectWindow()) {
-                auto const texture = win->effectWindow()->data(LanczosCacheRole);
-                if (texture.isValid()) {
-                    delete static_cast<GLTexture*>(texture.value<void*>());
-                    win->effectWindow()->setData(LanczosCacheRole, QVariant());
-                }
-            }
+            static_cast<EffectsHandlerImpl*>(effects)->addLanczosDamage(win);
         }
     }
 
-    // Move elevated windows to the top of the stacking order
-    for (auto effect_window : static_cast<EffectsHandlerImpl*>(effects)->elevatedWindows()) {
-        auto window = static_cast<EffectWindowImpl*>(effect_window)->window();
-        remove_all(windows, window);
-        windows.push_back(window);
-    }
-
     if (repaints_region.isEmpty() && !has_window_repaints) {
         idle = true;
         compositor->check_idle();
@@ -110,6 +92,37 @@ bool output::prepare_run(QRegion& repaints, std::deque<Toplevel*>& windows)
     }
 
     idle = false;
+    update_paint_windows();
+
+    // Submit pending output repaints and clear the pending field, so that post-pass can add new
+    // repaints for the next repaint.
+    repaints = repaints_region;
+    repaints_region = QRegion();
+
+    return true;
+}
+
+void output::update_paint_windows()
+{
+    auto ws = Workspace::self();
+    auto const generation = ws->xStackingGeneration();
+    auto const screen_locked = waylandServer()->isScreenLocked();
+    auto const elevated = static_cast<EffectsHandlerImpl*>(effects)->elevatedWindows();
+
+    // Windows only ever become ready for painting. So as long as none was skipped for not being
+    // ready the list stays valid until one of the inputs changes.
+    if (paint_windows.valid && paint_windows.generation == generation
+        && paint_windows.screen_locked == screen_locked && !paint_windows.has_unready
+        && paint_windows.elevated == elevated) {
+        return;
+    }
+
+    paint_windows.valid = true;
+    paint_windows.generation = generation;
+    paint_windows.screen_locked = screen_locked;
+    paint_windows.has_unready = false;
+    paint_windows.elevated = elevated;
+    paint_windows.windows.clear();
 
     // Skip windows that are not yet ready for being painted and if screen is locked skip windows
     // that are neither lockscreen nor inputmethod windows.
@@ -117,57 +130,84 @@ bool output::prepare_run(QRegion& repaints, std::deque<Toplevel*>& windows)
     // TODO? This cannot be used so carelessly - needs protections against broken clients, the
     // window should not get focus before it's displayed, handle unredirected windows properly and
     // so on.
-    for (auto win : windows) {
+    auto is_painted = [&](Toplevel* win) {
         if (!win->readyForPainting()) {
-            windows.erase(std::remove(windows.begin(), windows.end(), win), windows.end());
-        }
-        if (waylandServer()->isScreenLocked() && !win->isLockScreen() && !win->isInputMethod()) {
-            windows.erase(std::remove(windows.begin(), windows.end(), win), windows.end());
+            paint_windows.has_unready = true;
+            return false;
         }
+        return !screen_locked || win->isLockScreen() || win->isInputMethod();
+    };
+
+    std::vector<Toplevel*> elevated_windows;
+    for (auto effect_window : elevated) {
+        elevated_windows.push_back(static_cast<EffectWindowImpl*>(effect_window)->window());
     }
+    auto is_elevated = [&](Toplevel* win) {
+        return std::find(elevated_windows.cbegin(), elevated_windows.cend(), win)
+            != elevated_windows.cend();
+    };
 
-    // Submit pending output repaints and clear the pending field, so that post-pass can add new
-    // repaints for the next repaint.
-    repaints = repaints_region;
-    repaints_region = QRegion();
+    for (auto win : ws->xStackingOrder()) {
+        if (!is_elevated(win) && is_painted(win)) {
+            paint_windows.windows.push_back(win);
+        }
+    }
 
-    return true;
+    // Move elevated windows to the top of the stacking order
+    for (auto win : elevated_windows) {
+        if (is_painted(win)) {
+            paint_windows.windows.push_back(win);
+        }
+    }
 }
 
-std::deque<Toplevel*> output::run()
+void output::run()
 {
     QRegion repaints;
-    std::deque<Toplevel*> windows;
 
-    if (!prepare_run(repaints, windows)) {
-        return std::deque<Toplevel*>();
+    auto const prepare_start = std::chrono::steady_clock::now();
+    if (!prepare_run(repaints)) {
+        if (!swap_pending) {
+            Q_EMIT base->frameSkipped();
+        }
+        return;
     }
+    last_run.prepare = std::chrono::steady_clock::now() - prepare_start;
 
-    auto const ftrace_identifier = QString::fromStdString("paint-" + std::to_string(index));
-
-    Perf::Ftrace::begin(ftrace_identifier, ++msc);
+    Perf::Trace::begin(Perf::Trace::event::output_paint, index, ++msc);
 
     auto now_ns = std::chrono::steady_clock::now().time_since_epoch();
     auto now = std::chrono::duration_cast<std::chrono::milliseconds>(now_ns);
 
+    auto const& windows = paint_windows.windows;
+
     // Start the actual painting process.
     auto const duration = compositor->scene()->paint(base, repaints, windows, now);
+    last_run.paint = std::chrono::nanoseconds(duration);
 
-    update_paint_periods(duration);
+    // The GPU result is read without stalling and therefore belongs to an earlier frame. It still
+    // tells whether painting is bound by the GPU.
+    auto const gpu_duration = compositor->scene()->gpuPaintDuration(base);
+    scheduler.add_render_duration(std::chrono::nanoseconds(duration),
+                                  std::chrono::nanoseconds(gpu_duration));
     retard_next_run();
 
     if (!windows.empty()) {
         compositor->presentation->lock(this, windows);
     }
 
-    Perf::Ftrace::end(ftrace_identifier, msc);
+    Perf::Trace::end(Perf::Trace::event::output_paint, index, msc);
 
-    return windows;
+    if (!swap_pending) {
+        // Nothing was damaged or the backend did not present.
+        Q_EMIT base->frameSkipped();
+    }
 }
 
 void output::swapped_sw()
 {
     compositor->presentation->softwarePresented(Presentation::Kind::Vsync);
+    scheduler.presented(std::chrono::steady_clock::now().time_since_epoch());
     swapped();
 }
 
@@ -176,6 +216,9 @@ void output::swapped_hw(unsigned int sec, unsigned int usec)
     auto const flags = Presentation::Kind::Vsync | Presentation::Kind::HwClock
         | Presentation::Kind::HwCompletion;
     compositor->presentation->presented(this, sec, usec, flags);
+
+    // The flip timestamp is on the monotonic clock which is what steady_clock uses.
+    scheduler.presented(std::chrono::seconds(sec) + std::chrono::microseconds(usec));
     swapped();
 }
 
@@ -187,26 +230,14 @@ void output::swapped()
     }
     swap_pending = false;
 
-    // We delay the next paint shortly before next vblank. For that we assume that the swap
-    // event is close to the actual vblank (TODO: it would be better to take the actual flip
-    // time that for example DRM events provide). We take 10% of refresh cycle length.
-    // We also assume the paint duration is relatively constant over time. We take 3 times the
-    // previous paint duration.
-    //
-    // All temporary calculations are in nanoseconds but the final timer offset in the end in
-    // milliseconds. Atleast we take here one millisecond.
-    auto const refresh = refresh_length();
-    auto const vblankMargin = refresh / 10;
-
-    auto max_paint_duration = [this]() {
-        if (last_paint_durations[0] > last_paint_durations[1]) {
-            return last_paint_durations[0];
-        }
-        return last_paint_durations[1];
-    };
+    // We delay the next paint to shortly before the next vblank. The scheduler predicts when
+    // that is from the last flip timestamp and how long painting will take from the recent
+    // paint durations. With software swaps we assume the swap happened at the vblank.
+    scheduler.set_refresh_rate(base->refreshRate());
+    scheduler.set_latency_budget(std::chrono::nanoseconds(options->latencyBudget()));
 
-    auto const paint_margin = max_paint_duration();
-    delay = std::max(refresh - vblankMargin - paint_margin, int64_t(0));
+    auto const now = std::chrono::steady_clock::now().time_since_epoch();
+    delay = scheduler.next_delay(now).count();
 
     delay_timer.stop();
     set_delay_timer();
@@ -214,23 +245,8 @@ void output::swapped()
 
 int64_t output::refresh_length() const
 {
-    return 1000 * 1000 / base->refreshRate();
-}
-
-void output::update_paint_periods(int64_t duration)
-{
-    if (duration > last_paint_durations[1]) {
-        last_paint_durations[1] = duration;
-    }
-
-    paint_periods++;
-
-    // We take the maximum over the last 100 frames.
-    if (paint_periods == 100) {
-        last_paint_durations[0] = last_paint_durations[1];
-        last_paint_durations[1] = 0;
-        paint_periods = 0;
-    }
+    // Refresh rate is in mHz.
+    return int64_t(1000) * 1000 * 1000 * 1000 / base->refreshRate();
 }
 
 void output::set_delay_timer()
@@ -243,14 +259,17 @@ void output::set_delay_timer()
 
     // In milliseconds.
     uint const wait_time = delay / 1000 / 1000;
-
-    auto const ftrace_identifier = QString::fromStdString("timer-" + std::to_string(index));
-    Perf::Ftrace::mark(ftrace_identifier + QString::number(wait_time));
+    Perf::Trace::instant(Perf::Trace::event::paint_timer, index, wait_time);
 
     // Force 4fps minimum:
     delay_timer.start(std::min(wait_time, 250u), this);
 }
 
+bool output::frame_scheduled() const
+{
+    return swap_pending || delay_timer.isActive();
+}
+
 void output::timerEvent(QTimerEvent* event)
 {
     if (event->timerId() == delay_timer.timerId()) {
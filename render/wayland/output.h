@@ -5,12 +5,16 @@
 */
 #pragma once
 
+#include "paint_scheduler.h"
+
 #include <kwin_export.h>
 
 #include <QBasicTimer>
+#include <QList>
 #include <QRegion>
 #include <QTimer>
 
+#include <chrono>
 #include <deque>
 #include <map>
 
@@ -25,6 +29,7 @@ class Surface;
 namespace KWin
 {
 class AbstractWaylandOutput;
+class EffectWindow;
 class Toplevel;
 class WaylandCompositor;
 
@@ -42,17 +47,26 @@ class KWIN_EXPORT output : public QObject
     QTimer fallback_timer;
 
     // Compositing delay (in ns).
-    int64_t delay;
-    int64_t last_paint_durations[2]{0};
-    int paint_periods{0};
+    int64_t delay{0};
+    paint_scheduler scheduler;
 
     QRegion repaints_region;
 
-    bool prepare_run(QRegion& repaints, std::deque<Toplevel*>& windows);
+    // Windows to paint in stacking order. Recomputed only when its inputs change.
+    struct {
+        bool valid{false};
+        uint64_t generation{0};
+        bool screen_locked{false};
+        bool has_unready{false};
+        QList<EffectWindow*> elevated;
+        std::deque<Toplevel*> windows;
+    } paint_windows;
+
+    bool prepare_run(QRegion& repaints);
+    void update_paint_windows();
     void retard_next_run();
     void swapped();
 
-    void update_paint_periods(int64_t duration);
     int64_t refresh_length() const;
 
     void timerEvent(QTimerEvent* event) override;
@@ -65,12 +79,21 @@ public:
     bool swap_pending{false};
     QBasicTimer delay_timer;
 
+    // Timings of the last run that painted, for benchmarks and debugging.
+    struct {
+        std::chrono::nanoseconds prepare{0};
+        std::chrono::nanoseconds paint{0};
+    } last_run;
+
     output(AbstractWaylandOutput* base, WaylandCompositor* compositor);
 
     void add_repaint(QRegion const& region);
     void set_delay_timer();
 
-    std::deque<Toplevel*> run();
+    // A frame waits for its swap or the next run is scheduled.
+    bool frame_scheduled() const;
+
+    void run();
 
     void swapped_sw();
     void swapped_hw(unsigned int sec, unsigned int usec);
@@ -0,0 +1,84 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "paint_scheduler.h"
+
+#include <algorithm>
+
+namespace KWin::render::wayland
+{
+
+void paint_scheduler::set_refresh_rate(int millihertz)
+{
+    if (millihertz <= 0) {
+        return;
+    }
+    m_refresh = std::chrono::nanoseconds(int64_t(1000) * 1000 * 1000 * 1000 / millihertz);
+}
+
+std::chrono::nanoseconds paint_scheduler::refresh_length() const
+{
+    return m_refresh;
+}
+
+void paint_scheduler::set_latency_budget(std::chrono::nanoseconds budget)
+{
+    m_budget = std::max(budget, std::chrono::nanoseconds::zero());
+}
+
+void paint_scheduler::set_percentile(int percentile)
+{
+    m_percentile = std::clamp(percentile, 0, 100);
+}
+
+void paint_scheduler::add_render_duration(std::chrono::nanoseconds cpu,
+                                          std::chrono::nanoseconds gpu)
+{
+    // The GPU works on the frame while the CPU still records it, so the durations overlap. The
+    // slower of both bounds when the frame is done.
+    m_durations[m_durations_index] = std::max(cpu, gpu);
+    m_durations_index = (m_durations_index + 1) % window_size;
+    m_durations_count = std::min(m_durations_count + 1, window_size);
+
+    // The window is small, so selecting the percentile on a copy is cheap enough to do once per
+    // frame and keeps queries constant time.
+    auto sorted = m_durations;
+    auto const end = sorted.begin() + m_durations_count;
+    auto const rank = (m_durations_count - 1) * m_percentile / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, end);
+    m_prediction = sorted[rank];
+}
+
+void paint_scheduler::presented(std::chrono::nanoseconds timestamp)
+{
+    m_last_vblank = timestamp;
+}
+
+std::chrono::nanoseconds paint_scheduler::predicted_render_time() const
+{
+    return m_prediction;
+}
+
+std::chrono::nanoseconds paint_scheduler::next_delay(std::chrono::nanoseconds now) const
+{
+    auto const lead = m_prediction + m_budget;
+
+    // Without a reference we can only assume the vblank happened just now.
+    auto const last_vblank = m_last_vblank.count() > 0 ? m_last_vblank : now;
+
+    // Find the first vblank we can still make with the predicted render time.
+    auto next_vblank = last_vblank + m_refresh;
+    if (now > last_vblank) {
+        auto const elapsed_cycles = (now - last_vblank) / m_refresh;
+        next_vblank = last_vblank + (elapsed_cycles + 1) * m_refresh;
+    }
+    while (next_vblank - lead < now && lead < m_refresh) {
+        next_vblank += m_refresh;
+    }
+
+    return std::max(next_vblank - lead - now, std::chrono::nanoseconds::zero());
+}
+
+}
@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <kwin_export.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace KWin::render::wayland
+{
+
+/**
+ * Decides when an output starts painting its next frame.
+ *
+ * The goal is to start as late as possible while still finishing before the next vblank. The
+ * vblank phase is taken from presentation timestamps and the render time is predicted from a
+ * high percentile of the most recent frame durations, each the longer of its CPU and GPU time.
+ * On top of the prediction a latency budget is reserved as safety margin.
+ *
+ * All time points are on the monotonic clock in nanoseconds.
+ */
+class KWIN_EXPORT paint_scheduler
+{
+public:
+    static constexpr std::size_t window_size{64};
+
+    void set_refresh_rate(int millihertz);
+    std::chrono::nanoseconds refresh_length() const;
+
+    void set_latency_budget(std::chrono::nanoseconds budget);
+    void set_percentile(int percentile);
+
+    /**
+     * Records the durations of a painted frame. The CPU and GPU durations overlap, so the frame
+     * is accounted with the longer of them. The GPU duration may be zero when unknown.
+     */
+    void add_render_duration(std::chrono::nanoseconds cpu, std::chrono::nanoseconds gpu);
+
+    /**
+     * Records the time of the last vblank as reported by the hardware.
+     */
+    void presented(std::chrono::nanoseconds timestamp);
+
+    std::chrono::nanoseconds predicted_render_time() const;
+
+    /**
+     * Returns how long to wait from @p now until the next frame should be started.
+     */
+    std::chrono::nanoseconds next_delay(std::chrono::nanoseconds now) const;
+
+private:
+    std::chrono::nanoseconds m_refresh{16666667};
+    std::chrono::nanoseconds m_budget{1000000};
+    int m_percentile{90};
+
+    std::chrono::nanoseconds m_last_vblank{0};
+
+    std::array<std::chrono::nanoseconds, window_size> m_durations{};
+    std::size_t m_durations_index{0};
+    std::size_t m_durations_count{0};
+    std::chrono::nanoseconds m_prediction{0};
+};
+
+}
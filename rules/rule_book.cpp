@@ -12,6 +12,8 @@
 #include <QFileInfo>
 #include <kconfig.h>
 
+#include <algorithm>
+
 #ifndef KCMRULES
 #include "toplevel.h"
 #include "workspace.h"
@@ -68,28 +70,69 @@ void RuleBook::deleteAll()
 {
     qDeleteAll(m_rules);
     m_rules.clear();
+    m_index.dirty = true;
+}
+
+void RuleBook::updateIndex()
+{
+    m_index.wmclass.clear();
+    m_index.wmclass_complete.clear();
+    m_index.generic.clear();
+
+    for (int i = 0; i < m_rules.size(); i++) {
+        bool complete;
+        auto const wmclass = m_rules.at(i)->exactWMClass(complete);
+        if (wmclass.isEmpty()) {
+            m_index.generic.append(i);
+        } else if (complete) {
+            m_index.wmclass_complete[wmclass].append(i);
+        } else {
+            m_index.wmclass[wmclass].append(i);
+        }
+    }
+
+    m_index.dirty = false;
 }
 
 WindowRules RuleBook::find(Toplevel const* window, bool ignore_temporary)
 {
+    if (m_index.dirty) {
+        updateIndex();
+    }
+
+    // Only rules with a matching exact window class or without one are evaluated. The candidates
+    // are sorted to keep the priority order of the rules.
+    auto const wmclass = window->resourceClass();
+    QVector<int> candidates = m_index.generic;
+    candidates += m_index.wmclass.value(wmclass);
+    candidates += m_index.wmclass_complete.value(window->resourceName() + ' ' + wmclass);
+    std::sort(candidates.begin(), candidates.end());
+
     QVector<Rules*> ret;
-    for (QList<Rules*>::Iterator it = m_rules.begin(); it != m_rules.end();) {
-        if (ignore_temporary && (*it)->isTemporary()) {
-            ++it;
+    QVector<int> matched_temporary;
+
+    for (auto index : qAsConst(candidates)) {
+        auto rule = m_rules.at(index);
+        if (ignore_temporary && rule->isTemporary()) {
             continue;
         }
-        if ((*it)->match(window)) {
-            Rules* rule = *it;
+        if (rule->match(window)) {
             qCDebug(KWIN_CORE) << "Rule found:" << rule << ":" << window;
-            if (rule->isTemporary())
-                it = m_rules.erase(it);
-            else
-                ++it;
+            if (rule->isTemporary()) {
+                matched_temporary.append(index);
+            }
             ret.append(rule);
-            continue;
         }
-        ++it;
     }
+
+    // Temporary rules are only applied once.
+    for (auto it = matched_temporary.crbegin(); it != matched_temporary.crend(); ++it) {
+        m_rules.removeAt(*it);
+    }
+    if (!matched_temporary.isEmpty()) {
+        m_index.dirty = true;
+    }
+
     return WindowRules(ret);
 }
 
@@ -130,6 +173,7 @@ void RuleBook::load()
         m_config->reparseConfiguration();
     }
     m_rules = RuleBookSettings(m_config).rules().toList();
+    m_index.dirty = true;
 }
 
 void RuleBook::save()
@@ -158,6 +202,7 @@ void RuleBook::temporaryRulesMessage(const QString& message)
             was_temporary = true;
     Rules* rule = new Rules(message, true);
     m_rules.prepend(rule); // highest priority first
+    m_index.dirty = true;
 
     if (!was_temporary) {
         QTimer::singleShot(60000, this, &RuleBook::cleanupTemporaryRules);
@@ -170,6 +215,7 @@ void RuleBook::cleanupTemporaryRules()
     for (QList<Rules*>::Iterator it = m_rules.begin(); it != m_rules.end();) {
         if ((*it)->discardTemporary(false)) { // deletes (*it)
             it = m_rules.erase(it);
+            m_index.dirty = true;
         } else {
             if ((*it)->isTemporary())
                 has_temporary = true;
@@ -192,6 +238,7 @@ void RuleBook::discardUsed(Toplevel* window, bool withdrawn)
                 window->control->remove_rule(*it);
                 Rules* r = *it;
                 it = m_rules.erase(it);
+                m_index.dirty = true;
                 delete r;
                 continue;
             }
@@ -7,6 +7,7 @@
 #ifndef KWIN_RULES_RULE_BOOK_H
 #define KWIN_RULES_RULE_BOOK_H
 
+#include <QHash>
 #include <QRect>
 #include <QVector>
 #include <netwm_def.h>
@@ -52,9 +53,24 @@ private Q_SLOTS:
 private:
     void deleteAll();
     void initWithX11();
+    void updateIndex();
+
     QTimer* m_updateTimer;
     bool m_updatesDisabled;
     QList<Rules*> m_rules;
+
+    /**
+     * Positions in m_rules of the rules that can match a window. Rules with an exact window
+     * class are looked up by that class, all others are always candidates. Rebuilt lazily after
+     * m_rules changed.
+     */
+    struct {
+        bool dirty{true};
+        QHash<QByteArray, QVector<int>> wmclass;
+        QHash<QByteArray, QVector<int>> wmclass_complete;
+        QVector<int> generic;
+    } m_index;
+
     QScopedPointer<KXMessages> m_temporaryRulesMessages;
     KSharedConfig::Ptr m_config;
 
@@ -9,7 +9,7 @@
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
-#include <QRegExp>
+#include <QRegularExpression>
 #include <QTemporaryFile>
 #include <kconfig.h>
 
@@ -67,6 +67,10 @@ void Rules::readFromSettings(const RuleSettings* settings)
         bytes_match bytes;
         bytes.data = data.toLower().toLatin1();
         bytes.match = static_cast<StringMatch>(match);
+        if (bytes.match == RegExpMatch) {
+            bytes.regexp = QRegularExpression(QString::fromUtf8(bytes.data));
+            bytes.regexp.optimize();
+        }
         return bytes;
     };
 
@@ -74,6 +78,10 @@ void Rules::readFromSettings(const RuleSettings* settings)
         string_match str;
         str.data = data;
         str.match = static_cast<StringMatch>(match);
+        if (str.match == RegExpMatch) {
+            str.regexp = QRegularExpression(str.data);
+            str.regexp.optimize();
+        }
         return str;
     };
 
@@ -314,10 +322,9 @@ bool Rules::matchType(NET::WindowType match_type) const
 bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_name) const
 {
     if (wmclass.match != UnimportantMatch) {
-        // TODO optimize?
         QByteArray cwmclass = wmclasscomplete ? match_name + ' ' + match_class : match_class;
         if (wmclass.match == RegExpMatch
-            && QRegExp(QString::fromUtf8(wmclass.data)).indexIn(QString::fromUtf8(cwmclass)) == -1)
+            && !wmclass.regexp.match(QString::fromUtf8(cwmclass)).hasMatch())
             return false;
         if (wmclass.match == ExactMatch && wmclass.data != cwmclass)
             return false;
@@ -331,8 +338,7 @@ bool Rules::matchRole(const QByteArray& match_role) const
 {
     if (windowrole.match != UnimportantMatch) {
         if (windowrole.match == RegExpMatch
-            && QRegExp(QString::fromUtf8(windowrole.data)).indexIn(QString::fromUtf8(match_role))
-                == -1)
+            && !windowrole.regexp.match(QString::fromUtf8(match_role)).hasMatch())
             return false;
         if (windowrole.match == ExactMatch && windowrole.data != match_role)
             return false;
@@ -345,7 +351,7 @@ bool Rules::matchRole(const QByteArray& match_role) const
 bool Rules::matchTitle(const QString& match_title) const
 {
     if (title.match != UnimportantMatch) {
-        if (title.match == RegExpMatch && QRegExp(title.data).indexIn(match_title) == -1)
+        if (title.match == RegExpMatch && !title.regexp.match(match_title).hasMatch())
             return false;
         if (title.match == ExactMatch && title.data != match_title)
             return false;
@@ -362,9 +368,7 @@ bool Rules::matchClientMachine(const QByteArray& match_machine, bool local) cons
         if (match_machine != "localhost" && local && matchClientMachine("localhost", true))
             return true;
         if (clientmachine.match == RegExpMatch
-            && QRegExp(QString::fromUtf8(clientmachine.data))
-                    .indexIn(QString::fromUtf8(match_machine))
-                == -1)
+            && !clientmachine.regexp.match(QString::fromUtf8(match_machine)).hasMatch())
             return false;
         if (clientmachine.match == ExactMatch && clientmachine.data != match_machine)
             return false;
@@ -408,6 +412,12 @@ bool Rules::match(Toplevel const* window) const
     return true;
 }
 
+QByteArray Rules::exactWMClass(bool& complete) const
+{
+    complete = wmclasscomplete;
+    return wmclass.match == ExactMatch ? wmclass.data : QByteArray();
+}
+
 bool Rules::checkSetRule(set_rule rule, bool init)
 {
     if (rule > static_cast<set_rule>(DontAffect)) { // Unused or DontAffect
@@ -8,6 +8,7 @@
 #define KWIN_RULES_H
 
 #include <QRect>
+#include <QRegularExpression>
 #include <netwm_def.h>
 
 #include "options.h"
@@ -101,6 +102,13 @@ public:
     bool isTemporary() const;
     bool discardTemporary(bool force); // removes if temporary and forced or too old
 
+    /**
+     * The exact window class string a window must have for this rule to match or an empty array
+     * if the rule matches the window class differently. With @p complete set the string is the
+     * resource name and class separated by a space.
+     */
+    QByteArray exactWMClass(bool& complete) const;
+
     bool applyPlacement(Placement::Policy& placement) const;
     bool applyGeometry(QRect& rect, bool init) const;
     // use 'invalidPoint' with applyPosition, unlike QSize() and QRect(), QPoint() is a valid point
@@ -174,13 +182,16 @@ private:
         return checkForceStop(ruler.rule);
     }
 
+    // With RegExpMatch the pattern is compiled once when the rule is read.
     struct bytes_match {
         QByteArray data;
         StringMatch match{UnimportantMatch};
+        QRegularExpression regexp;
     };
     struct string_match {
         QString data;
         StringMatch match{UnimportantMatch};
+        QRegularExpression regexp;
     };
 
     bytes_match wmclass;
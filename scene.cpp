@@ -264,10 +264,20 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
     QRegion dirtyArea = region;
     bool opaqueFullscreen = false;
 
+    // Without transformations windows are painted at their geometry. So when painting a single
+    // output the windows not intersecting it can be culled before building their quads.
+    auto const output_geo = repaint_output ? repaint_output->geometry() : QRect();
+
     // Traverse the scene windows from bottom to top.
     for (int i = 0; i < stacking_order.count(); ++i) {
         Window *window = stacking_order[i];
         Toplevel *toplevel = window->window();
+
+        if (output_geo.isValid() && !win::visible_rect(toplevel).intersects(output_geo)) {
+            toplevel->resetRepaints(repaint_output);
+            continue;
+        }
+
         WindowPrePaintData data;
         data.mask = orig_mask | (window->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
         window->resetPaintingEnabled();
@@ -644,6 +654,11 @@ void Scene::screenGeometryChanged(const QSize &size)
     overlayWindow()->resize(size);
 }
 
+int64_t Scene::gpuPaintDuration([[maybe_unused]] AbstractOutput* output) const
+{
+    return 0;
+}
+
 bool Scene::hasSwapEvent() const
 {
     return false;
@@ -88,6 +88,14 @@ public:
                           std::deque<Toplevel*> const& windows,
                           std::chrono::milliseconds presentTime);
 
+    /**
+     * The GPU execution time of the last finished frame of @p output, or of any output if
+     * @p output is null. GPU times are measured asynchronously and lag some frames behind.
+     *
+     * @return the time in ns or 0 if not measured
+     */
+    virtual int64_t gpuPaintDuration(AbstractOutput* output = nullptr) const;
+
     /**
      * Adds the Toplevel to the Scene.
      *
@@ -197,7 +197,7 @@ void Toplevel::disownDataPassedToDeleted()
 
 Xcb::Property Toplevel::fetchWmClientLeader() const
 {
-    return Xcb::Property(false, xcb_window(), atoms->wm_client_leader, XCB_ATOM_WINDOW, 0, 10000);
+    return win::x11::fetch_wm_client_leader(xcb_window());
 }
 
 void Toplevel::readWmClientLeader(Xcb::Property &prop)
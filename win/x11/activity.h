@@ -8,6 +8,7 @@
 #include "hide.h"
 #include "input.h"
 #include "window.h"
+#include "xcb.h"
 
 #include "activities.h"
 #include "atoms.h"
@@ -167,11 +168,7 @@ void set_on_all_activities([[maybe_unused]] Win* win, [[maybe_unused]] bool on)
 template<typename Win>
 Xcb::StringProperty fetch_activities(Win* win)
 {
-#ifdef KWIN_BUILD_ACTIVITIES
-    return Xcb::StringProperty(win->xcb_window(), atoms->activities);
-#else
-    return Xcb::StringProperty();
-#endif
+    return fetch_activities(win->xcb_window());
 }
 
 template<typename Win>
@@ -611,15 +611,18 @@ QRect place_on_taking_control(Win* win,
  * Manages the clients. This means handling the very first maprequest:
  * reparenting, initial geometry, initial state, placement, etc.
  * Returns false if KWin is not going to manage this window.
+ *
+ * The replies needed for that are taken from @p prefetch, which must have been created for @p w.
  */
 template<typename Win>
-bool take_control(Win* win, xcb_window_t w, bool isMapped)
+bool take_control(Win* win, xcb_window_t w, bool isMapped, control_prefetch& prefetch)
 {
     StackingUpdatesBlocker stacking_blocker(workspace());
 
-    Xcb::WindowAttributes attr(w);
-    Xcb::WindowGeometry windowGeometry(w);
+    auto& attr = prefetch.attributes;
+    auto& windowGeometry = prefetch.geometry;
     if (attr.isNull() || windowGeometry.isNull()) {
+        prefetch.restore_event_mask();
         return false;
     }
 
@@ -675,12 +678,12 @@ bool take_control(Win* win, xcb_window_t w, bool isMapped)
         | NET::WM2Input | NET::WM2Protocols | NET::WM2InitialMappingState | NET::WM2IconPixmap
         | NET::WM2OpaqueRegion | NET::WM2DesktopFileName | NET::WM2GTKFrameExtents;
 
-    auto wmClientLeaderCookie = win->fetchWmClientLeader();
-    auto skipCloseAnimationCookie = fetch_skip_close_animation(win->xcb_window());
-    auto showOnScreenEdgeCookie = fetch_show_on_screen_edge(win);
-    auto firstInTabBoxCookie = fetch_first_in_tabbox(win);
-    auto transientCookie = fetch_transient(win);
-    auto activitiesCookie = fetch_activities(win);
+    auto& wmClientLeaderCookie = prefetch.wm_client_leader;
+    auto& skipCloseAnimationCookie = prefetch.skip_close_animation;
+    auto& showOnScreenEdgeCookie = prefetch.show_on_screen_edge;
+    auto& firstInTabBoxCookie = prefetch.first_in_tabbox;
+    auto& transientCookie = prefetch.transient_for;
+    auto& activitiesCookie = prefetch.activities;
 
     win->geometry_hints.init(win->xcb_window());
     win->motif_hints.init(win->xcb_window());
@@ -1131,6 +1134,13 @@ bool take_control(Win* win, xcb_window_t w, bool isMapped)
     return true;
 }
 
+template<typename Win>
+bool take_control(Win* win, xcb_window_t w, bool isMapped)
+{
+    control_prefetch prefetch(w);
+    return take_control(win, w, isMapped, prefetch);
+}
+
 template<typename Win>
 void restack_window(Win* win,
                     xcb_window_t above,
@@ -1458,12 +1468,7 @@ void update_urgency(Win* win)
 template<typename Win>
 Xcb::Property fetch_first_in_tabbox(Win* win)
 {
-    return Xcb::Property(false,
-                         win->xcb_windows.client,
-                         atoms->kde_first_in_window_list,
-                         atoms->kde_first_in_window_list,
-                         0,
-                         1);
+    return fetch_first_in_tabbox(win->xcb_windows.client);
 }
 
 template<typename Win>
@@ -1491,8 +1496,7 @@ void cancel_focus_out_timer(Win* win)
 template<typename Win>
 Xcb::Property fetch_show_on_screen_edge(Win* win)
 {
-    return Xcb::Property(
-        false, win->xcb_window(), atoms->kde_screen_edge_show, XCB_ATOM_CARDINAL, 0, 1);
+    return fetch_show_on_screen_edge(win->xcb_window());
 }
 
 template<typename Win>
@@ -8,6 +8,10 @@
 #include "atoms.h"
 #include "xcbutils.h"
 
+#include <config-kwin.h>
+
+#include <optional>
+
 namespace KWin::win::x11
 {
 
@@ -16,4 +20,92 @@ inline Xcb::Property fetch_skip_close_animation(xcb_window_t window)
     return Xcb::Property(false, window, atoms->kde_skip_close_animation, XCB_ATOM_CARDINAL, 0, 1);
 }
 
+inline Xcb::Property fetch_wm_client_leader(xcb_window_t window)
+{
+    return Xcb::Property(false, window, atoms->wm_client_leader, XCB_ATOM_WINDOW, 0, 10000);
+}
+
+inline Xcb::Property fetch_show_on_screen_edge(xcb_window_t window)
+{
+    return Xcb::Property(false, window, atoms->kde_screen_edge_show, XCB_ATOM_CARDINAL, 0, 1);
+}
+
+inline Xcb::Property fetch_first_in_tabbox(xcb_window_t window)
+{
+    return Xcb::Property(
+        false, window, atoms->kde_first_in_window_list, atoms->kde_first_in_window_list, 0, 1);
+}
+
+inline Xcb::StringProperty fetch_activities(xcb_window_t window)
+{
+#ifdef KWIN_BUILD_ACTIVITIES
+    return Xcb::StringProperty(window, atoms->activities);
+#else
+    Q_UNUSED(window)
+    return Xcb::StringProperty();
+#endif
+}
+
+/**
+ * Requests of take_control issued in advance, so that several windows can be adopted with the
+ * replies of all of them in flight at once instead of one round trip per window and request.
+ *
+ * When adopting in a batch the replies may be generated long before the window is embedded. In
+ * this case property changes are selected on the window before its properties are requested, so
+ * changes after the replies were generated are not lost but handled once the window is managed.
+ */
+struct control_prefetch {
+    /**
+     * Requests the replies for @p window. If @p event_mask, the event mask KWin currently selects
+     * on the window, is given, property changes are selected in addition until the window is
+     * embedded.
+     */
+    explicit control_prefetch(xcb_window_t window,
+                              std::optional<uint32_t> event_mask = std::nullopt)
+        : attributes(event_mask ? select_property_changes(window, *event_mask) : window)
+        , geometry(window)
+        , wm_client_leader(fetch_wm_client_leader(window))
+        , skip_close_animation(fetch_skip_close_animation(window))
+        , show_on_screen_edge(fetch_show_on_screen_edge(window))
+        , first_in_tabbox(fetch_first_in_tabbox(window))
+        , transient_for(window)
+        , activities(fetch_activities(window))
+        , prefetched_window{window}
+        , previous_event_mask{event_mask}
+    {
+    }
+
+    /**
+     * Restores the event mask selected before, for when the window is not managed after all.
+     */
+    void restore_event_mask() const
+    {
+        if (previous_event_mask) {
+            xcb_change_window_attributes(
+                connection(), prefetched_window, XCB_CW_EVENT_MASK, &*previous_event_mask);
+        }
+    }
+
+    Xcb::WindowAttributes attributes;
+    Xcb::WindowGeometry geometry;
+    Xcb::Property wm_client_leader;
+    Xcb::Property skip_close_animation;
+    Xcb::Property show_on_screen_edge;
+    Xcb::Property first_in_tabbox;
+    Xcb::TransientFor transient_for;
+    Xcb::StringProperty activities;
+
+private:
+    static xcb_window_t select_property_changes(xcb_window_t window, uint32_t event_mask)
+    {
+        // Replaced by the full event mask when the window is embedded.
+        uint32_t const mask = event_mask | XCB_EVENT_MASK_PROPERTY_CHANGE;
+        xcb_change_window_attributes(connection(), window, XCB_CW_EVENT_MASK, &mask);
+        return window;
+    }
+
+    xcb_window_t prefetched_window;
+    std::optional<uint32_t> previous_event_mask;
+};
+
 }
@@ -82,6 +82,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Qt
 #include <QtConcurrentRun>
 
+#include <memory>
+#include <vector>
+
 namespace KWin
 {
 
@@ -508,7 +511,11 @@ void Workspace::initWithX11()
             windowGeometries[i] = Xcb::WindowGeometry(wins[i]);
         }
 
-        // Get the replies
+        std::vector<bool> unmanaged(tree->children_len, false);
+        std::vector<std::unique_ptr<win::x11::control_prefetch>> prefetches(tree->children_len);
+
+        // Get the replies and request everything needed to manage the clients at once, so that
+        // adopting them does not wait for a round trip per window
         for (int i = 0; i < tree->children_len; i++) {
             Xcb::WindowAttributes attr(windowAttributes.at(i));
 
@@ -517,17 +524,23 @@ void Workspace::initWithX11()
             }
 
             if (attr->override_redirect) {
-                if (attr->map_state == XCB_MAP_STATE_VIEWABLE &&
-                    attr->_class != XCB_WINDOW_CLASS_INPUT_ONLY)
-                    // ### This will request the attributes again
-                    createUnmanaged(wins[i]);
+                unmanaged[i] = attr->map_state == XCB_MAP_STATE_VIEWABLE &&
+                    attr->_class != XCB_WINDOW_CLASS_INPUT_ONLY;
             } else if (attr->map_state != XCB_MAP_STATE_UNMAPPED) {
                 if (Application::wasCrash()) {
                     fixPositionAfterCrash(wins[i], windowGeometries.at(i).data());
                 }
+                prefetches[i] = std::make_unique<win::x11::control_prefetch>(
+                    wins[i], attr->your_event_mask);
+            }
+        }
 
+        for (int i = 0; i < tree->children_len; i++) {
+            if (unmanaged[i]) {
                 // ### This will request the attributes again
-                createClient(wins[i], true);
+                createUnmanaged(wins[i]);
+            } else if (prefetches[i]) {
+                createClient(wins[i], true, prefetches[i].get());
             }
         }
 
@@ -664,7 +677,8 @@ void Workspace::setupClientConnections(Toplevel* window)
     connect(window, &Toplevel::minimizedChanged, this, std::bind(&Workspace::clientMinimizedChanged, this, window));
 }
 
-win::x11::window* Workspace::createClient(xcb_window_t w, bool is_mapped)
+win::x11::window* Workspace::createClient(xcb_window_t w, bool is_mapped,
+                                          win::x11::control_prefetch* prefetch)
 {
     StackingUpdatesBlocker blocker(this);
 
@@ -675,7 +689,9 @@ win::x11::window* Workspace::createClient(xcb_window_t w, bool is_mapped)
         connect(c, &win::x11::window::blockingCompositingChanged, compositor, &X11Compositor::updateClientCompositeBlocking);
     }
     connect(c, &win::x11::window::clientFullScreenSet, ScreenEdges::self(), &ScreenEdges::checkBlocking);
-    if (!win::x11::take_control(c, w, is_mapped)) {
+    auto const managed = prefetch ? win::x11::take_control(c, w, is_mapped, *prefetch)
+                                  : win::x11::take_control(c, w, is_mapped);
+    if (!managed) {
         delete c;
         return nullptr;
     }
@@ -58,6 +58,7 @@ namespace x11
 {
 enum class predicate_match;
 class window;
+struct control_prefetch;
 }
 }
 
@@ -286,6 +287,11 @@ public:
      */
     std::deque<Toplevel*> const& stackingOrder() const;
     std::deque<Toplevel*> const& xStackingOrder() const;
+    /**
+     * Incremented each time the x stacking order is rebuilt. Lists derived from
+     * xStackingOrder() can be kept as long as the generation stays the same.
+     */
+    uint64_t xStackingGeneration() const;
     std::deque<win::x11::window*> ensureStackingOrder(std::vector<win::x11::window*> const& clients) const;
     std::deque<Toplevel*> ensureStackingOrder(std::vector<Toplevel*> const& clients) const;
 
@@ -563,7 +569,8 @@ private:
     void saveOldScreenSizes();
 
     /// This is the right way to create a new client
-    win::x11::window* createClient(xcb_window_t w, bool is_mapped);
+    win::x11::window* createClient(xcb_window_t w, bool is_mapped,
+                                   win::x11::control_prefetch* prefetch = nullptr);
     void setupClientConnections(Toplevel* window);
     void addClient(win::x11::window* c);
     Toplevel* createUnmanaged(xcb_window_t w);
@@ -611,6 +618,7 @@ private:
     std::unique_ptr<Xcb::Tree> m_xStackingQueryTree;
 
     bool m_xStackingDirty{false};
+    uint64_t m_xStackingGeneration{0};
 
     // Last is most recent.
     std::deque<Toplevel*> should_get_focus;
@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "event_merge.h"
+
+namespace KWin
+{
+namespace Xwl
+{
+
+template<typename T>
+static const T *cast(const xcb_generic_event_t *event)
+{
+    return reinterpret_cast<const T*>(event);
+}
+
+bool supersedes(const xcb_generic_event_t *event, const xcb_generic_event_t *previous)
+{
+    // Events sent by clients are always delivered.
+    if (event->response_type != previous->response_type || event->response_type & 0x80) {
+        return false;
+    }
+
+    switch (event->response_type) {
+    case XCB_MOTION_NOTIFY: {
+        auto motion = cast<xcb_motion_notify_event_t>(event);
+        auto previousMotion = cast<xcb_motion_notify_event_t>(previous);
+        return motion->event == previousMotion->event
+            && motion->child == previousMotion->child
+            && motion->state == previousMotion->state
+            && motion->same_screen == previousMotion->same_screen;
+    }
+    case XCB_CONFIGURE_NOTIFY: {
+        auto configure = cast<xcb_configure_notify_event_t>(event);
+        auto previousConfigure = cast<xcb_configure_notify_event_t>(previous);
+        return configure->event == previousConfigure->event
+            && configure->window == previousConfigure->window;
+    }
+    case XCB_PROPERTY_NOTIFY: {
+        // The property is read again on every notification, but the deletion of a property is a
+        // step of its own for example in selection transfers.
+        auto property = cast<xcb_property_notify_event_t>(event);
+        auto previousProperty = cast<xcb_property_notify_event_t>(previous);
+        return property->window == previousProperty->window
+            && property->atom == previousProperty->atom
+            && property->state == previousProperty->state;
+    }
+    default:
+        return false;
+    }
+}
+
+} // namespace Xwl
+} // namespace KWin
@@ -0,0 +1,22 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <xcb/xcb.h>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+/**
+ * Whether @p event makes @p previous obsolete, i.e. handling only @p event has the same outcome
+ * as handling both.
+ */
+bool supersedes(const xcb_generic_event_t *event, const xcb_generic_event_t *previous);
+
+} // namespace Xwl
+} // namespace KWin
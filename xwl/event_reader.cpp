@@ -0,0 +1,127 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "event_reader.h"
+#include "event_merge.h"
+
+#include <xwayland_logging.h>
+
+#include <cstring>
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+EventReader::EventReader(xcb_connection_t *connection, QObject *parent)
+    : QObject(parent)
+    , m_connection(connection)
+    , m_stopFd(eventfd(0, EFD_CLOEXEC))
+{
+    if (m_stopFd < 0) {
+        qCWarning(KWIN_XWL) << "Failed to create eventfd for the X event reader";
+        return;
+    }
+    m_thread = std::thread([this] { run(); });
+}
+
+EventReader::~EventReader()
+{
+    stop();
+    if (m_stopFd >= 0) {
+        close(m_stopFd);
+    }
+    for (auto event : m_events) {
+        free(event);
+    }
+}
+
+void EventReader::stop()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+    const uint64_t value = 1;
+    if (write(m_stopFd, &value, sizeof(value)) != sizeof(value)) {
+        qCWarning(KWIN_XWL) << "Failed to stop the X event reader";
+    }
+    m_thread.join();
+}
+
+void EventReader::run()
+{
+    pollfd fds[] = {
+        {xcb_get_file_descriptor(m_connection), POLLIN, 0},
+        {m_stopFd, POLLIN, 0},
+    };
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qCWarning(KWIN_XWL) << "Polling the X connection failed:" << strerror(errno);
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+        if (!readEvents()) {
+            return;
+        }
+    }
+}
+
+bool EventReader::readEvents()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Reads from the socket without blocking. The main thread might have read the data already.
+    while (auto event = xcb_poll_for_event(m_connection)) {
+        append(event);
+    }
+
+    if (!m_events.empty() && !m_notified) {
+        m_notified = true;
+        QMetaObject::invokeMethod(this, [this] { Q_EMIT eventsReady(); }, Qt::QueuedConnection);
+    }
+
+    return !xcb_connection_has_error(m_connection);
+}
+
+std::vector<xcb_generic_event_t*> EventReader::takeEvents()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Events read by the main thread itself are later than the ones in the batch. The reader
+    // dequeues under the same lock, so they are not overtaken.
+    while (auto event = xcb_poll_for_queued_event(m_connection)) {
+        append(event);
+    }
+
+    m_notified = false;
+
+    std::vector<xcb_generic_event_t*> events;
+    events.swap(m_events);
+    return events;
+}
+
+void EventReader::append(xcb_generic_event_t *event)
+{
+    if (!m_events.empty() && supersedes(event, m_events.back())) {
+        free(m_events.back());
+        m_events.back() = event;
+        return;
+    }
+    m_events.push_back(event);
+}
+
+} // namespace Xwl
+} // namespace KWin
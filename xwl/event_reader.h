@@ -0,0 +1,72 @@
+/*
+    SPDX-FileCopyrightText: 2021 The KWinFT Authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+
+#include <xcb/xcb.h>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+/**
+ * Reads the events of the Xwayland connection on a thread of its own.
+ *
+ * The events are collected into a batch that the main thread takes as a whole. While the batch is
+ * not taken, motion, configure and property notifications superseding the event before them are
+ * merged into it, such that bursts of them are only processed once.
+ *
+ * Events read by the main thread while it waits for replies are taken along with the batch, in
+ * the order they were received.
+ */
+class EventReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EventReader(xcb_connection_t *connection, QObject *parent = nullptr);
+    ~EventReader() override;
+
+    /**
+     * Stops reading. Must be called before the connection is closed.
+     */
+    void stop();
+
+    /**
+     * Takes the events read so far. The caller owns the events and must free them.
+     */
+    std::vector<xcb_generic_event_t*> takeEvents();
+
+Q_SIGNALS:
+    /**
+     * Emitted on the main thread when events are ready to be taken.
+     */
+    void eventsReady();
+
+private:
+    void run();
+    bool readEvents();
+    void append(xcb_generic_event_t *event);
+
+    xcb_connection_t *m_connection;
+    int m_stopFd;
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::vector<xcb_generic_event_t*> m_events;
+    bool m_notified = false;
+
+    Q_DISABLE_COPY(EventReader)
+};
+
+} // namespace Xwl
+} // namespace KWin
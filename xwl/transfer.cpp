@@ -39,6 +39,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xcb/xfixes.h>
 
 #include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include <xwayland_logging.h>
@@ -48,8 +50,44 @@ namespace KWin
 namespace Xwl
 {
 
-// in Bytes: equals 64KB
-static const uint32_t s_incrChunkSize = 63 * 1024;
+// in Bytes: upper bound for sending data in a single property
+static const uint32_t s_maxIncrChunkSize = 1024 * 1024;
+
+// in Bytes: size of the parts properties are read in
+static const uint32_t s_propertyReadSize = 1024 * 1024;
+
+// Chunks read ahead of the requestor in incremental transfers.
+static const int s_maxQueuedChunks = 2;
+
+// Buffers of sent chunks, reused by later chunks of all transfers.
+static QVector<QByteArray> s_chunkPool;
+static const int s_maxPooledChunks = 4;
+
+static int incrChunkSize()
+{
+    // Leave room for the request header. Larger requests are sent with BIG-REQUESTS by xcb.
+    const uint32_t maxRequestSize = xcb_get_maximum_request_length(kwinApp()->x11Connection()) * 4;
+    return std::min(maxRequestSize - 1024, s_maxIncrChunkSize);
+}
+
+static QByteArray takeChunkBuffer(int size)
+{
+    while (!s_chunkPool.isEmpty()) {
+        QByteArray buffer = s_chunkPool.takeLast();
+        if (buffer.size() >= size) {
+            return buffer;
+        }
+    }
+    return QByteArray(size, Qt::Uninitialized);
+}
+
+static void releaseChunkBuffer(QByteArray &buffer)
+{
+    if (s_chunkPool.size() < s_maxPooledChunks) {
+        s_chunkPool.append(std::move(buffer));
+    }
+    buffer = QByteArray();
+}
 
 Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, QObject *parent)
     : QObject(parent)
@@ -57,6 +95,12 @@ Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, Q
     , m_fd(fd)
     , m_timestamp(timestamp)
 {
+    // The fd is only read and written when the socket notifier reports it to be ready, a full
+    // pipe must not block the compositor.
+    const int flags = fcntl(m_fd, F_GETFL);
+    if (flags != -1) {
+        fcntl(m_fd, F_SETFL, flags | O_NONBLOCK);
+    }
 }
 
 void Transfer::createSocketNotifier(QSocketNotifier::Type type)
@@ -71,6 +115,13 @@ void Transfer::clearSocketNotifier()
     m_notifier = nullptr;
 }
 
+void Transfer::setSocketNotifierEnabled(bool enable)
+{
+    if (m_notifier) {
+        m_notifier->setEnabled(enable);
+    }
+}
+
 void Transfer::timeout()
 {
     if (m_timeout) {
@@ -99,11 +150,15 @@ TransferWltoX::TransferWltoX(xcb_atom_t selection, xcb_selection_request_event_t
                              qint32 fd, QObject *parent)
     : Transfer(selection, fd, 0, parent)
     , m_request(request)
+    , m_chunkSize(incrChunkSize())
 {
 }
 
 TransferWltoX::~TransferWltoX()
 {
+    for (auto &chunk : m_chunks) {
+        releaseChunkBuffer(chunk.buffer);
+    }
     delete m_request;
     m_request = nullptr;
 }
@@ -119,7 +174,7 @@ void TransferWltoX::startTransferFromSource()
     );
 }
 
-int TransferWltoX::flushSourceData()
+void TransferWltoX::setProperty(const Chunk &chunk)
 {
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
 
@@ -129,15 +184,35 @@ int TransferWltoX::flushSourceData()
                         m_request->property,
                         m_request->target,
                         8,
-                        m_chunks.first().first.size(),
-                        m_chunks.first().first.data());
+                        chunk.size,
+                        chunk.buffer.constData());
     xcb_flush(xcbConn);
+}
+
+void TransferWltoX::flushSourceData()
+{
+    Q_ASSERT(incr() && !m_propertyIsSet);
+
+    if (m_chunks.isEmpty()) {
+        if (m_sourceDone) {
+            endIncr();
+        }
+        return;
+    }
+    if (m_chunks.first().size < m_chunkSize && !m_sourceDone) {
+        // still reading into the chunk
+        return;
+    }
+
+    auto chunk = m_chunks.takeFirst();
+    setProperty(chunk);
+    releaseChunkBuffer(chunk.buffer);
 
     m_propertyIsSet = true;
     resetTimeout();
 
-    const auto rm = m_chunks.takeFirst();
-    return rm.first.size();
+    // there is space in the queue again
+    setSocketNotifierEnabled(true);
 }
 
 void TransferWltoX::startIncr()
@@ -152,7 +227,7 @@ void TransferWltoX::startIncr()
                                   XCB_CW_EVENT_MASK, mask);
 
     // spec says to make the available space larger
-    const uint32_t chunkSpace = 1024 + s_incrChunkSize;
+    const uint32_t chunkSpace = 1024 + m_chunkSize;
     xcb_change_property(xcbConn,
                         XCB_PROP_MODE_REPLACE,
                         m_request->requestor,
@@ -164,69 +239,97 @@ void TransferWltoX::startIncr()
     setIncr(true);
     // first data will be flushed after the property has been deleted
     // again by the requestor
-    m_flushPropertyOnDelete = true;
     m_propertyIsSet = true;
     Q_EMIT selectionNotify(m_request, true);
 }
 
+void TransferWltoX::endIncr()
+{
+    xcb_connection_t *xcbConn = kwinApp()->x11Connection();
+
+    uint32_t mask[] = {0};
+    xcb_change_window_attributes (xcbConn,
+                                  m_request->requestor,
+                                  XCB_CW_EVENT_MASK, mask);
+
+    // a zero-length property marks the end of the transfer
+    xcb_change_property(xcbConn,
+                        XCB_PROP_MODE_REPLACE,
+                        m_request->requestor,
+                        m_request->property,
+                        m_request->target,
+                        8, 0, nullptr);
+    xcb_flush(xcbConn);
+    endTransfer();
+}
+
 void TransferWltoX::readWlSource()
 {
-    if (m_chunks.size() == 0 ||
-            m_chunks.last().second == s_incrChunkSize) {
+    if (m_chunks.isEmpty() || m_chunks.last().size == m_chunkSize) {
         // append new chunk
-        auto next = QPair<QByteArray, int>();
-        next.first.resize(s_incrChunkSize);
-        next.second = 0;
-        m_chunks.append(next);
+        m_chunks.append(Chunk{takeChunkBuffer(m_chunkSize), 0});
     }
 
-    const auto oldLen = m_chunks.last().second;
-    const auto avail = s_incrChunkSize - m_chunks.last().second;
+    auto &chunk = m_chunks.last();
+    const int avail = m_chunkSize - chunk.size;
     Q_ASSERT(avail > 0);
 
-    ssize_t readLen = read(fd(), m_chunks.last().first.data() + oldLen, avail);
+    const ssize_t readLen = read(fd(), chunk.buffer.data() + chunk.size, avail);
     if (readLen == -1) {
+        if (errno == EAGAIN || errno == EINTR) {
+            return;
+        }
         qCWarning(KWIN_XWL) << "Error reading in Wl data.";
 
         // TODO: cleanup X side?
         endTransfer();
         return;
     }
-    m_chunks.last().second = oldLen + readLen;
+    chunk.size += readLen;
+    resetTimeout();
 
     if (readLen == 0) {
         // at the fd end - complete transfer now
-        m_chunks.last().first.resize(m_chunks.last().second);
-
-        if (incr()) {
-            // incremental transfer is to be completed now
-            m_flushPropertyOnDelete = true;
-            if (!m_propertyIsSet) {
-                // flush if target's property is not set at the moment
-                flushSourceData();
-            }
-            clearSocketNotifier();
-        } else {
+        m_sourceDone = true;
+        clearSocketNotifier();
+
+        if (!incr()) {
             // non incremental transfer is to be completed now,
             // data can be transferred to X client via a single property set
-            flushSourceData();
+            setProperty(chunk);
             Q_EMIT selectionNotify(m_request, true);
             endTransfer();
+            return;
         }
-    } else if (m_chunks.last().second == s_incrChunkSize) {
-        // first chunk full, but not yet at fd end -> go incremental
-        if (incr()) {
-            m_flushPropertyOnDelete = true;
-            if (!m_propertyIsSet) {
-                // flush if target's property is not set at the moment
-                flushSourceData();
-            }
-        } else {
-            // starting incremental transfer
-            startIncr();
+
+        if (!chunk.size) {
+            releaseChunkBuffer(chunk.buffer);
+            m_chunks.removeLast();
+        }
+        if (!m_propertyIsSet) {
+            // flush if target's property is not set at the moment
+            flushSourceData();
         }
+        return;
+    }
+
+    if (chunk.size < m_chunkSize) {
+        return;
+    }
+
+    // chunk full, but not yet at fd end
+    if (!incr()) {
+        // starting incremental transfer
+        startIncr();
+    } else if (!m_propertyIsSet) {
+        // flush if target's property is not set at the moment
+        flushSourceData();
+    }
+
+    if (m_chunks.size() == s_maxQueuedChunks && m_chunks.last().size == m_chunkSize) {
+        // wait for the requestor to take a chunk before reading on
+        setSocketNotifierEnabled(false);
     }
-    resetTimeout();
 }
 
 bool TransferWltoX::handlePropertyNotify(xcb_property_notify_event_t *event)
@@ -248,30 +351,7 @@ void TransferWltoX::handlePropertyDelete()
         return;
     }
     m_propertyIsSet = false;
-
-    if (m_flushPropertyOnDelete) {
-        if (!socketNotifier() && m_chunks.isEmpty()) {
-            // transfer complete
-            xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-
-            uint32_t mask[] = {0};
-            xcb_change_window_attributes (xcbConn,
-                                          m_request->requestor,
-                                          XCB_CW_EVENT_MASK, mask);
-
-            xcb_change_property(xcbConn,
-                                XCB_PROP_MODE_REPLACE,
-                                m_request->requestor,
-                                m_request->property,
-                                m_request->target,
-                                8, 0, nullptr);
-            xcb_flush(xcbConn);
-            m_flushPropertyOnDelete = false;
-            endTransfer();
-        } else {
-            flushSourceData();
-        }
-    }
+    flushSourceData();
 }
 
 TransferXtoWl::TransferXtoWl(xcb_atom_t selection, xcb_atom_t target, qint32 fd,
@@ -362,32 +442,63 @@ bool TransferXtoWl::handleSelectionNotify(xcb_selection_notify_event_t *event)
     return true;
 }
 
-void TransferXtoWl::startTransfer()
+xcb_get_property_reply_t *TransferXtoWl::getProperty()
 {
+    // Properties are read in parts so that large data is not held in memory all at once.
+    const uint32_t length = m_receiver->needsCompleteProperty() ? 0x1fffffff : s_propertyReadSize / 4;
+
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
     auto cookie = xcb_get_property(xcbConn,
-                                   1,
+                                   0,
                                    m_window,
                                    atoms->wl_selection,
                                    XCB_GET_PROPERTY_TYPE_ANY,
-                                   0,
-                                   0x1fffffff
-                                   );
+                                   m_propertyOffset,
+                                   length);
 
     auto *reply = xcb_get_property_reply(xcbConn, cookie, nullptr);
     if (reply == nullptr) {
         qCWarning(KWIN_XWL) << "Can't get selection property.";
         endTransfer();
+    }
+    return reply;
+}
+
+void TransferXtoWl::deleteProperty()
+{
+    xcb_connection_t *xcbConn = kwinApp()->x11Connection();
+    xcb_delete_property(xcbConn,
+                        m_window,
+                        atoms->wl_selection);
+    xcb_flush(xcbConn);
+}
+
+void TransferXtoWl::transferFromProperty(xcb_get_property_reply_t *reply)
+{
+    // Parts are read in multiples of 32 bit, the offset is only used while more data follows.
+    m_propertyOffset += xcb_get_property_value_length(reply) / 4;
+    m_propertyBytesAfter = reply->bytes_after;
+
+    // reply's ownership is transferred
+    m_receiver->transferFromProperty(reply);
+}
+
+void TransferXtoWl::startTransfer()
+{
+    m_propertyOffset = 0;
+    auto *reply = getProperty();
+    if (!reply) {
         return;
     }
 
     if (reply->type == atoms->incr) {
         setIncr(true);
         free(reply);
+        // deleting the property requests the first chunk
+        deleteProperty();
     } else {
         setIncr(false);
-        // reply's ownership is transferred
-        m_receiver->transferFromProperty(reply);
+        transferFromProperty(reply);
         dataSourceWrite();
     }
 }
@@ -402,30 +513,20 @@ void TransferXtoWl::getIncrChunk()
         // receive mechanism has not yet been setup
         return;
     }
-    xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-
-    auto cookie = xcb_get_property(xcbConn,
-                                   0,
-                                   m_window,
-                                   atoms->wl_selection,
-                                   XCB_GET_PROPERTY_TYPE_ANY,
-                                   0,
-                                   0x1fffffff);
 
-    auto *reply = xcb_get_property_reply(xcbConn, cookie, nullptr);
+    m_propertyOffset = 0;
+    auto *reply = getProperty();
     if (!reply) {
-        qCWarning(KWIN_XWL) << "Can't get selection property.";
-        endTransfer();
         return;
     }
 
     if (xcb_get_property_value_length(reply) > 0) {
-        // reply's ownership is transferred
-        m_receiver->transferFromProperty(reply);
+        transferFromProperty(reply);
         dataSourceWrite();
     } else {
         // Transfer complete
         free(reply);
+        deleteProperty();
         endTransfer();
     }
 }
@@ -552,41 +653,56 @@ void MozUrlReceiver::setData(const char *value, int length)
 
 void TransferXtoWl::dataSourceWrite()
 {
-    QByteArray property = m_receiver->data();
+    while (true) {
+        const QByteArray property = m_receiver->data();
+
+        const ssize_t len = write(fd(), property.constData(), property.size());
+        if (len == -1) {
+            if (errno != EAGAIN && errno != EINTR) {
+                qCWarning(KWIN_XWL) << "X11 to Wayland write error on fd:" << fd();
+                endTransfer();
+                return;
+            }
+            break;
+        }
+        resetTimeout();
 
-    ssize_t len = write(fd(), property.constData(), property.size());
-    if (len == -1) {
-        qCWarning(KWIN_XWL) << "X11 to Wayland write error on fd:" << fd();
-        endTransfer();
-        return;
-    }
+        m_receiver->partRead(len);
+        if (len < property.size()) {
+            break;
+        }
 
-    m_receiver->partRead(len);
-    if (len == property.size()) {
-        // property completely transferred
-        if (incr()) {
-            clearSocketNotifier();
-            xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-            xcb_delete_property(xcbConn,
-                                m_window,
-                                atoms->wl_selection);
-            xcb_flush(xcbConn);
-        } else {
-            // transfer complete
-            endTransfer();
+        if (m_propertyBytesAfter == 0) {
+            // property completely transferred
+            setSocketNotifierEnabled(false);
+            // the source waits for the deletion to send the next chunk
+            deleteProperty();
+            if (!incr()) {
+                // transfer complete
+                endTransfer();
+            }
+            return;
         }
-    } else {
-        if (!socketNotifier()) {
-            createSocketNotifier(QSocketNotifier::Write);
-            connect(socketNotifier(), &QSocketNotifier::activated, this,
-                [this](int socket) {
-                    Q_UNUSED(socket);
-                    dataSourceWrite();
-                }
-            );
+
+        // the next part is only read once the previous one is written
+        auto *reply = getProperty();
+        if (!reply) {
+            return;
         }
+        transferFromProperty(reply);
     }
-    resetTimeout();
+
+    // wait until the pipe is writable again
+    if (!socketNotifier()) {
+        createSocketNotifier(QSocketNotifier::Write);
+        connect(socketNotifier(), &QSocketNotifier::activated, this,
+            [this](int socket) {
+                Q_UNUSED(socket);
+                dataSourceWrite();
+            }
+        );
+    }
+    setSocketNotifierEnabled(true);
 }
 
 } // namespace Xwl
@@ -92,6 +92,7 @@ protected:
     }
     void createSocketNotifier(QSocketNotifier::Type type);
     void clearSocketNotifier();
+    void setSocketNotifierEnabled(bool enable);
     QSocketNotifier *socketNotifier() const {
         return m_notifier;
     }
@@ -130,20 +131,30 @@ Q_SIGNALS:
     void selectionNotify(xcb_selection_request_event_t *event, bool success);
 
 private:
+    struct Chunk {
+        // Buffer of at least the chunk size, from the chunk pool.
+        QByteArray buffer;
+        // Number of bytes read into the buffer.
+        int size;
+    };
+
     void startIncr();
     void readWlSource();
-    int flushSourceData();
+    void setProperty(const Chunk &chunk);
+    void flushSourceData();
+    void endIncr();
     void handlePropertyDelete();
 
     xcb_selection_request_event_t *m_request = nullptr;
 
-    /* contains all received data portioned in chunks
-     * TODO: explain second QPair component
+    /* Data read from the source but not yet sent. The reading stops while
+     * the queue is full and continues once the requestor took a chunk.
      */
-    QVector<QPair<QByteArray, int> > m_chunks;
+    QVector<Chunk> m_chunks;
+    int m_chunkSize;
 
     bool m_propertyIsSet = false;
-    bool m_flushPropertyOnDelete = false;
+    bool m_sourceDone = false;
 
     Q_DISABLE_COPY(TransferWltoX)
 };
@@ -162,6 +173,14 @@ public:
     virtual void setData(const char *value, int length);
     QByteArray data() const;
 
+    /**
+     * Whether setData needs the complete property at once. Otherwise the
+     * property is read and passed on in parts.
+     */
+    virtual bool needsCompleteProperty() const {
+        return false;
+    }
+
     void partRead(int length);
 
 protected:
@@ -183,6 +202,9 @@ class NetscapeUrlReceiver : public DataReceiver
 {
 public:
     void setData(const char *value, int length) override;
+    bool needsCompleteProperty() const override {
+        return true;
+    }
 };
 
 /**
@@ -193,6 +215,9 @@ class MozUrlReceiver : public DataReceiver
 {
 public:
     void setData(const char *value, int length) override;
+    bool needsCompleteProperty() const override {
+        return true;
+    }
 };
 
 /**
@@ -217,10 +242,18 @@ private:
     void dataSourceWrite();
     void startTransfer();
     void getIncrChunk();
+    xcb_get_property_reply_t *getProperty();
+    void transferFromProperty(xcb_get_property_reply_t *reply);
+    void deleteProperty();
 
     xcb_window_t m_window;
     DataReceiver *m_receiver = nullptr;
 
+    // Position of the next part to read in the current property, in 32 bit units.
+    uint32_t m_propertyOffset = 0;
+    // Bytes of the current property after the part last read.
+    uint32_t m_propertyBytesAfter = 0;
+
     Q_DISABLE_COPY(TransferXtoWl)
 };
 
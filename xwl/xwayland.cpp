@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "xwayland.h"
 #include "databridge.h"
+#include "event_reader.h"
 
 #include "main_wayland.h"
 #include "utils.h"
@@ -33,7 +34,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QFile>
 #include <QFutureWatcher>
 #include <QProcess>
-#include <QSocketNotifier>
 #include <QThread>
 #include <QtConcurrentRun>
 
@@ -90,6 +90,9 @@ Xwayland::~Xwayland()
 {
     disconnect(m_xwaylandFailConnection);
     if (m_app->x11Connection()) {
+        delete m_eventReader;
+        m_eventReader = nullptr;
+
         Xcb::setInputFocus(XCB_INPUT_FOCUS_POINTER_ROOT);
         m_app->destroyAtoms();
         Q_EMIT m_app->x11ConnectionAboutToBeDestroyed();
@@ -223,9 +226,14 @@ void Xwayland::continueStartupWithX()
         Q_EMIT criticalError(1);
         return;
     }
-    QSocketNotifier *notifier = new QSocketNotifier(xcb_get_file_descriptor(xcbConn), QSocketNotifier::Read, this);
+    // Events are read on a thread of their own and handed over in batches.
+    m_eventReader = new EventReader(xcbConn, this);
     auto processXcbEvents = [this, xcbConn] {
-        while (auto event = xcb_poll_for_event(xcbConn)) {
+        if (!m_eventReader) {
+            // connection is closed
+            return;
+        }
+        for (auto event : m_eventReader->takeEvents()) {
             if (m_dataBridge->filterEvent(event)) {
                 free(event);
                 continue;
@@ -236,9 +244,9 @@ void Xwayland::continueStartupWithX()
         }
         xcb_flush(xcbConn);
     };
-    connect(notifier, &QSocketNotifier::activated, this, processXcbEvents);
+    connect(m_eventReader, &EventReader::eventsReady, this, processXcbEvents);
+    // Picks up events read by the main thread while waiting for replies and flushes requests.
     connect(QThread::currentThread()->eventDispatcher(), &QAbstractEventDispatcher::aboutToBlock, this, processXcbEvents);
-    connect(QThread::currentThread()->eventDispatcher(), &QAbstractEventDispatcher::awake, this, processXcbEvents);
 
     xcb_prefetch_extension_data(xcbConn, &xcb_xfixes_id);
     m_xfixes = xcb_get_extension_data(xcbConn, &xcb_xfixes_id);
@@ -35,6 +35,7 @@ class ApplicationWaylandAbstract;
 namespace Xwl
 {
 class DataBridge;
+class EventReader;
 
 class KWIN_EXPORT Xwayland : public XwaylandInterface
 {
@@ -73,6 +74,7 @@ private:
     xcb_screen_t *m_xcbScreen = nullptr;
     const xcb_query_extension_reply_t *m_xfixes = nullptr;
     DataBridge *m_dataBridge = nullptr;
+    EventReader *m_eventReader = nullptr;
 
     ApplicationWaylandAbstract *m_app;
 